@@ -0,0 +1,153 @@
+#pragma once
+
+#include <unity.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+/**
+ * Replaces the global operator new and operator delete so that tests can count
+ * heap allocations. Every allocation is prefixed with a header holding its
+ * size, which lets operator delete keep track of the bytes in use.
+ *
+ * The replacements are not inline, so this header may only be included by a
+ * single translation unit per test binary.
+ */
+namespace allocation_utils {
+struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t deallocations = 0;
+  uint64_t allocated_bytes = 0;
+  uint64_t current_bytes = 0;
+  uint64_t peak_bytes = 0;
+};
+
+// keeps the returned pointers aligned like the ones malloc returns
+const size_t header_size = 16;
+
+AllocationCounts counts;
+
+AllocationCounts get_counts() { return counts; }
+
+/**
+ * Resets the counters. The bytes that are currently in use are kept, so that
+ * memory allocated before the reset is still accounted for when it is freed,
+ * and the peak starts again from there.
+ */
+void reset_counts() {
+  const auto current_bytes = counts.current_bytes;
+  counts = AllocationCounts();
+  counts.current_bytes = current_bytes;
+  counts.peak_bytes = current_bytes;
+}
+
+void* allocate(const size_t size) {
+  auto block = (char*)std::malloc(header_size + size);
+  if (block == nullptr) {
+    return nullptr;
+  }
+
+  *(size_t*)block = size;
+  counts.allocations += 1;
+  counts.allocated_bytes += size;
+  counts.current_bytes += size;
+  if (counts.current_bytes > counts.peak_bytes) {
+    counts.peak_bytes = counts.current_bytes;
+  }
+
+  return block + header_size;
+}
+
+void deallocate(void* pointer) {
+  if (pointer == nullptr) {
+    return;
+  }
+
+  auto block = (char*)pointer - header_size;
+  const auto size = *(size_t*)block;
+  counts.deallocations += 1;
+  counts.current_bytes -= size;
+
+  std::free(block);
+}
+
+/**
+ * Counts the allocations made while running the given operation. The peak is
+ * the most memory the operation held at once on top of the bytes that were
+ * already in use when it started.
+ */
+template <typename Operation>
+AllocationCounts count_allocations(Operation operation) {
+  reset_counts();
+  const auto baseline_bytes = counts.current_bytes;
+
+  operation();
+
+  auto result = counts;
+  result.peak_bytes -= baseline_bytes;
+  return result;
+}
+
+/**
+ * The most allocations and peak heap bytes an operation may use.
+ */
+struct AllocationBudget {
+  uint64_t max_allocations;
+  uint64_t max_peak_bytes;
+};
+
+/**
+ * Fails the current test if the counted allocations exceed the budget.
+ */
+void assert_within_budget(const std::string label,
+                          const AllocationCounts &counts,
+                          const AllocationBudget budget) {
+  TEST_PRINTF("%s: %u allocations (budget %u), peak %u bytes (budget %u)\n",
+              label.c_str(), (unsigned int)counts.allocations,
+              (unsigned int)budget.max_allocations,
+              (unsigned int)counts.peak_bytes,
+              (unsigned int)budget.max_peak_bytes);
+
+  TEST_ASSERT_TRUE_MESSAGE(counts.allocations <= budget.max_allocations,
+                           (label + " exceeds its allocation budget").c_str());
+  TEST_ASSERT_TRUE_MESSAGE(counts.peak_bytes <= budget.max_peak_bytes,
+                           (label + " exceeds its peak heap budget").c_str());
+}
+}  // namespace allocation_utils
+
+void* operator new(size_t size) {
+  auto pointer = allocation_utils::allocate(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return allocation_utils::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return allocation_utils::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+  allocation_utils::deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  allocation_utils::deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  allocation_utils::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  allocation_utils::deallocate(pointer);
+}
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.h"
+
+namespace simulation_utils {
+/**
+ * Virtual time in microseconds.
+ */
+typedef uint64_t Time;
+
+const Time microseconds_per_decisecond = 100000;
+
+/**
+ * The properties of the directed link from one endpoint to another.
+ */
+struct LinkProperties {
+  Time latency = 1000;
+  // a uniformly distributed delay of up to this many µs is added to packets
+  Time jitter = 0;
+  double packet_loss_rate = 0.0;
+  // a reordered packet is delayed by another latency, letting later packets
+  // overtake it
+  double reordering_rate = 0.0;
+  // 0 means unlimited
+  uint32_t bytes_per_second = 0;
+};
+
+struct SimulationStatistics {
+  uint64_t packets_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t packets_delivered = 0;
+  uint64_t packets_lost = 0;
+  uint64_t packets_partitioned = 0;
+  uint64_t packets_reordered = 0;
+};
+
+/**
+ * A deterministic discrete-event network simulator.
+ *
+ * Packets travel over directed links with their own latency, jitter, loss,
+ * reordering and bandwidth and are delivered in virtual time. Arbitrary
+ * actions, such as timers, can be scheduled alongside the deliveries. Events
+ * at the same time run in the order they were scheduled, and all randomness
+ * is drawn from a generator seeded in the constructor, so a simulation with
+ * the same seed always plays out the same way.
+ */
+struct NetworkSimulation {
+ private:
+  struct Event {
+    Time time;
+    uint64_t sequence_number;
+    std::function<void()> action;
+
+    Event(const Time time, const uint64_t sequence_number,
+          const std::function<void()> action)
+        : time(time), sequence_number(sequence_number), action(action) {}
+
+    bool operator>(const Event &other) const {
+      return time != other.time ? time > other.time
+                                : sequence_number > other.sequence_number;
+    }
+  };
+
+  typedef std::pair<udp_interface::Endpoint, udp_interface::Endpoint> Link;
+
+  std::mt19937 random_generator;
+  Time time = 0;
+  uint64_t next_sequence_number = 0;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  std::map<udp_interface::Endpoint, std::queue<udp_interface::IncomingMessage>>
+      endpoint_to_buffer;
+  LinkProperties default_link_properties;
+  std::map<Link, LinkProperties> link_to_properties;
+  std::map<Link, Time> link_to_busy_until;
+  std::map<udp_interface::Endpoint, size_t> endpoint_to_partition;
+  std::function<void(const udp_interface::Endpoint)> delivery_handler;
+  SimulationStatistics statistics;
+
+  bool is_partitioned(const udp_interface::Endpoint sender,
+                      const udp_interface::Endpoint receiver) const {
+    const auto sender_partition = endpoint_to_partition.find(sender);
+    const auto receiver_partition = endpoint_to_partition.find(receiver);
+
+    if (sender_partition == endpoint_to_partition.end() ||
+        receiver_partition == endpoint_to_partition.end()) {
+      return false;
+    }
+
+    return sender_partition->second != receiver_partition->second;
+  }
+
+  void deliver(const udp_interface::Endpoint receiver,
+               const udp_interface::IncomingMessage message) {
+    endpoint_to_buffer.at(receiver).push(message);
+    statistics.packets_delivered += 1;
+
+    if (delivery_handler) {
+      delivery_handler(receiver);
+    }
+  }
+
+ public:
+  explicit NetworkSimulation(const uint32_t seed) : random_generator(seed) {}
+
+  /**
+   * Returns a random number in [0, 1). Unlike the standard distributions,
+   * the result does not depend on the standard library implementation.
+   */
+  double random_double() { return random_generator() / 4294967296.0; }
+
+  /**
+   * Returns a random number in [0, bound].
+   */
+  uint64_t random_integer(const uint64_t bound) {
+    if (bound == 0) {
+      return 0;
+    }
+
+    const uint64_t value =
+        ((uint64_t)random_generator() << 32) | random_generator();
+    return value % (bound + 1);
+  }
+
+  Time get_time() const { return time; }
+
+  const SimulationStatistics &get_statistics() const { return statistics; }
+
+  void reset_statistics() { statistics = SimulationStatistics(); }
+
+  void register_endpoint(const udp_interface::Endpoint endpoint) {
+    endpoint_to_buffer[endpoint] = std::queue<udp_interface::IncomingMessage>();
+  }
+
+  /**
+   * Sets a function that is called whenever a packet has arrived in the
+   * buffer of an endpoint.
+   */
+  void set_delivery_handler(
+      const std::function<void(const udp_interface::Endpoint)> handler) {
+    delivery_handler = handler;
+  }
+
+  void set_default_link_properties(const LinkProperties properties) {
+    default_link_properties = properties;
+  }
+
+  void set_link_properties(const udp_interface::Endpoint sender,
+                           const udp_interface::Endpoint receiver,
+                           const LinkProperties properties) {
+    link_to_properties[Link(sender, receiver)] = properties;
+  }
+
+  const LinkProperties &get_link_properties(
+      const udp_interface::Endpoint sender,
+      const udp_interface::Endpoint receiver) const {
+    const auto properties = link_to_properties.find(Link(sender, receiver));
+    if (properties == link_to_properties.end()) {
+      return default_link_properties;
+    }
+
+    return properties->second;
+  }
+
+  /**
+   * Splits the network into the given groups of endpoints. Packets between
+   * endpoints of different groups are dropped. Endpoints that are not in any
+   * group can still reach every endpoint.
+   */
+  void partition(
+      const std::vector<std::vector<udp_interface::Endpoint>> &groups) {
+    endpoint_to_partition.clear();
+
+    for (size_t i = 0; i < groups.size(); i += 1) {
+      for (const auto &endpoint : groups[i]) {
+        endpoint_to_partition[endpoint] = i;
+      }
+    }
+  }
+
+  void heal_partition() { endpoint_to_partition.clear(); }
+
+  void schedule(const Time at_time, const std::function<void()> action) {
+    if (at_time < time) {
+      throw std::runtime_error("Cannot schedule an event in the past.");
+    }
+
+    events.push(Event(at_time, next_sequence_number, action));
+    next_sequence_number += 1;
+  }
+
+  void send_packet(const udp_interface::Endpoint sender,
+                   const udp_interface::Endpoint receiver,
+                   const std::string packet) {
+    if (endpoint_to_buffer.count(receiver) == 0) {
+      throw std::runtime_error("Receiver endpoint is not registered.");
+    }
+
+    statistics.packets_sent += 1;
+    statistics.bytes_sent += packet.size();
+
+    const auto &properties = get_link_properties(sender, receiver);
+
+    // a packet occupies the link even if it is lost on the way
+    auto departure_time = time;
+    if (properties.bytes_per_second > 0) {
+      auto &busy_until = link_to_busy_until[Link(sender, receiver)];
+      departure_time = std::max(busy_until, time) +
+                       packet.size() * 1000000 / properties.bytes_per_second;
+      busy_until = departure_time;
+    }
+
+    if (is_partitioned(sender, receiver)) {
+      statistics.packets_partitioned += 1;
+      return;
+    }
+
+    if (random_double() < properties.packet_loss_rate) {
+      statistics.packets_lost += 1;
+      return;
+    }
+
+    auto arrival_time = departure_time + properties.latency +
+                        random_integer(properties.jitter);
+    if (random_double() < properties.reordering_rate) {
+      statistics.packets_reordered += 1;
+      arrival_time += properties.latency;
+    }
+
+    const auto message = udp_interface::IncomingMessage(sender, packet);
+    schedule(arrival_time,
+             [this, receiver, message]() { deliver(receiver, message); });
+  }
+
+  bool is_incoming_packet_available(
+      const udp_interface::Endpoint receiver) const {
+    if (endpoint_to_buffer.count(receiver) == 0) {
+      throw std::runtime_error("Receiver endpoint is not registered.");
+    }
+
+    return !endpoint_to_buffer.at(receiver).empty();
+  }
+
+  tl::optional<udp_interface::IncomingMessage> receive_packet(
+      const udp_interface::Endpoint receiver) {
+    if (!is_incoming_packet_available(receiver)) {
+      return {};
+    }
+
+    const auto result = endpoint_to_buffer.at(receiver).front();
+    endpoint_to_buffer.at(receiver).pop();
+
+    return result;
+  }
+
+  /**
+   * Runs the next event if it is due at or before the given time and returns
+   * whether there was one.
+   */
+  bool run_next_event(const Time until_time) {
+    if (events.empty() || events.top().time > until_time) {
+      return false;
+    }
+
+    const auto event = events.top();
+    events.pop();
+    time = event.time;
+    event.action();
+
+    return true;
+  }
+
+  /**
+   * Runs all events up to the given time and advances the clock to it.
+   */
+  void run_until(const Time until_time) {
+    while (run_next_event(until_time)) {
+    }
+
+    time = std::max(time, until_time);
+  }
+};
+
+struct SimulatedUdpInterface : public udp_interface::UDPInterface {
+  udp_interface::Endpoint endpoint;
+  NetworkSimulation &network_simulation;
+
+  SimulatedUdpInterface(const udp_interface::Endpoint endpoint,
+                        NetworkSimulation &network_simulation)
+      : endpoint(endpoint), network_simulation(network_simulation) {}
+
+  bool send_packet(const udp_interface::Endpoint receiver,
+                   const std::string packet) override {
+    network_simulation.send_packet(endpoint, receiver, packet);
+
+    return true;
+  }
+
+  bool is_incoming_packet_available() override {
+    return network_simulation.is_incoming_packet_available(endpoint);
+  }
+
+  tl::optional<udp_interface::IncomingMessage> receive_packet() override {
+    return network_simulation.receive_packet(endpoint);
+  }
+};
+
+/**
+ * Runs a group of Synchronizers on a NetworkSimulation in virtual time. Each
+ * node handles its packets as soon as they arrive and its 100 ms timer fires
+ * with a random phase, so that the nodes do not tick in lockstep.
+ */
+struct SimulatedGroup {
+ private:
+  NetworkSimulation &network_simulation;
+  std::map<udp_interface::Endpoint, std::shared_ptr<synchronizer::Synchronizer>>
+      endpoint_to_synchronizer;
+  std::vector<udp_interface::Endpoint> endpoints;
+
+  void schedule_tick(const std::shared_ptr<synchronizer::Synchronizer> node,
+                     const Time at_time) {
+    network_simulation.schedule(at_time, [this, node, at_time]() {
+      node->on_100_ms_passed();
+      node->heartbeat();
+      schedule_tick(node, at_time + microseconds_per_decisecond);
+    });
+  }
+
+ public:
+  SimulatedGroup(NetworkSimulation &network_simulation)
+      : network_simulation(network_simulation) {
+    network_simulation.set_delivery_handler(
+        [this](const udp_interface::Endpoint endpoint) {
+          const auto node = endpoint_to_synchronizer.find(endpoint);
+          if (node == endpoint_to_synchronizer.end()) {
+            return;
+          }
+
+          while (this->network_simulation.is_incoming_packet_available(
+              endpoint)) {
+            node->second->heartbeat();
+          }
+        });
+  }
+
+  SimulatedGroup(const SimulatedGroup &) = delete;
+  SimulatedGroup &operator=(const SimulatedGroup &) = delete;
+
+  /**
+   * Connects the given Synchronizer, which must already have a delegate, to
+   * the simulated network under the given endpoint and initializes it.
+   */
+  void add_node(const udp_interface::Endpoint endpoint,
+                const std::shared_ptr<synchronizer::Synchronizer> node) {
+    network_simulation.register_endpoint(endpoint);
+    node->set_udp_interface(
+        std::make_shared<SimulatedUdpInterface>(endpoint, network_simulation));
+    node->set_mdns_interface(std::make_shared<utils::EmptyMDNSInterfaceImpl>());
+    node->init();
+
+    endpoint_to_synchronizer[endpoint] = node;
+    endpoints.push_back(endpoint);
+
+    schedule_tick(node, network_simulation.get_time() + 1 +
+                            network_simulation.random_integer(
+                                microseconds_per_decisecond - 1));
+  }
+
+  /**
+   * Makes every node know every other node, as if they had discovered each
+   * other via mDNS.
+   */
+  void connect_all_nodes() {
+    for (const auto &endpoint : endpoints) {
+      const auto &node = endpoint_to_synchronizer.at(endpoint);
+      for (const auto &other_endpoint : endpoints) {
+        if (other_endpoint != endpoint) {
+          node->add_endpoint(other_endpoint);
+        }
+      }
+    }
+  }
+
+  const std::vector<udp_interface::Endpoint> &get_endpoints() const {
+    return endpoints;
+  }
+
+  std::shared_ptr<synchronizer::Synchronizer> get_node(
+      const udp_interface::Endpoint endpoint) const {
+    return endpoint_to_synchronizer.at(endpoint);
+  }
+
+  /**
+   * Runs the simulation until the condition holds, checking it every
+   * check_interval µs, or until the given time has passed. Returns the time
+   * at which the condition was first seen to hold.
+   */
+  tl::optional<Time> run_until(const std::function<bool()> &condition,
+                               const Time timeout,
+                               const Time check_interval = 1000) {
+    const auto end_time = network_simulation.get_time() + timeout;
+
+    while (!condition()) {
+      if (network_simulation.get_time() >= end_time) {
+        return {};
+      }
+
+      network_simulation.run_until(
+          std::min(end_time, network_simulation.get_time() + check_interval));
+    }
+
+    return network_simulation.get_time();
+  }
+};
+}  // namespace simulation_utils
@@ -0,0 +1,275 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../allocation_utils.h"
+#include "../utils.h"
+#include "foo.h"
+
+/**
+ * The time and allocations spent per operation of a measured workload.
+ */
+struct Measurement {
+  double nanoseconds_per_operation;
+  double allocations_per_operation;
+  double bytes_per_operation;
+};
+
+/**
+ * Runs operation_count operations and measures them. The peak heap usage is
+ * left in the allocation counters.
+ */
+Measurement measure(const size_t operation_count,
+                    const std::function<void(size_t)>& run) {
+  allocation_utils::reset_counts();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < operation_count; i += 1) {
+    run(i);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+  const auto counts = allocation_utils::get_counts();
+  return {(double)nanoseconds / operation_count,
+          (double)counts.allocations / operation_count,
+          (double)counts.allocated_bytes / operation_count};
+}
+
+void print_measurement(const char* label, const Measurement& measurement) {
+  TEST_PRINTF("%s: %.0f ns/op, %.1f allocations/op, %.0f bytes/op\n", label,
+              measurement.nanoseconds_per_operation,
+              measurement.allocations_per_operation,
+              measurement.bytes_per_operation);
+}
+
+struct CountingNetworkMessage : public NetworkMessage {
+  std::shared_ptr<data_object::GenericValue> data_object;
+  std::shared_ptr<unsigned int> ack_counter;
+
+  CountingNetworkMessage(
+      const std::shared_ptr<data_object::GenericValue> data_object,
+      const std::shared_ptr<unsigned int> ack_counter)
+      : data_object(data_object), ack_counter(ack_counter) {}
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return data_object;
+  };
+
+  void on_send_succeeded() const override { *ack_counter += 1; }
+};
+
+struct CountingNetworkHandlerDelegate : public NetworkHandlerDelegate {
+  std::shared_ptr<unsigned int> message_counter;
+
+  CountingNetworkHandlerDelegate(
+      const std::shared_ptr<unsigned int> message_counter)
+      : message_counter(message_counter) {}
+
+  void on_message_received(IncomingDecodedMessage message) const override {
+    *message_counter += 1;
+  };
+
+  void on_message_emitted(
+      std::shared_ptr<NetworkMessage> message) const override{};
+
+  void on_ack_received(unsigned int message_id) const override{};
+
+  void on_message_discarded(unsigned int message_id) const override{};
+
+  void on_decode_failed(std::string error,
+                        std::shared_ptr<Codec> codec) const override{};
+};
+
+void codec_benchmark_test() {
+  std::srand(1337u);
+
+  std::vector<std::shared_ptr<data_object::GenericValue>> data_objects;
+  for (int i = 0; i < 200; i += 1) {
+    data_objects.push_back(utils::generate_random_data_object(3));
+  }
+
+  const size_t iterations = 20;
+  const auto operation_count = iterations * data_objects.size();
+
+  const struct {
+    const char* label;
+    std::shared_ptr<Codec> codec;
+  } codecs[] = {
+      {"MsgPackCodec", std::make_shared<MsgPackCodec>()},
+      {"JsonCodec", std::make_shared<JsonCodec>()},
+  };
+
+  for (const auto& entry : codecs) {
+    const auto& codec = *entry.codec;
+
+    std::vector<std::string> encodings;
+    size_t byte_count = 0;
+    for (const auto& data_object : data_objects) {
+      encodings.push_back(codec.encode(data_object));
+      byte_count += encodings.back().size();
+    }
+
+    size_t checksum = 0;
+    const auto encode = measure(operation_count, [&](size_t i) {
+      checksum += codec.encode(data_objects[i % data_objects.size()]).size();
+    });
+    const auto decode = measure(operation_count, [&](size_t i) {
+      std::string error_string;
+      const auto decoded =
+          codec.decode(encodings[i % encodings.size()], error_string);
+      TEST_ASSERT_TRUE_MESSAGE(decoded.has_value(), error_string.c_str());
+      checksum += 1;
+    });
+
+    TEST_ASSERT_EQUAL(byte_count * iterations + operation_count, checksum);
+
+    const auto label = std::string(entry.label);
+    TEST_PRINTF("%s: %.1f bytes per encoded tree\n", entry.label,
+                (double)byte_count / data_objects.size());
+    print_measurement((label + " encode").c_str(), encode);
+    print_measurement((label + " decode").c_str(), decode);
+  }
+}
+
+void msgpack_backend_benchmark_test() {
+  std::srand(4711u);
+
+  std::vector<std::string> encodings;
+  std::vector<msgpack11::MsgPack> values;
+  for (int i = 0; i < 200; i += 1) {
+    encodings.push_back(
+        MsgPackCodec().encode(utils::generate_random_data_object(3)));
+    std::string error_string;
+    values.push_back(msgpack11::MsgPack::parse(encodings.back(), error_string));
+  }
+
+  const size_t operation_count = 50 * encodings.size();
+
+  size_t checksum = 0;
+  const auto dump_stream = measure(operation_count, [&](size_t i) {
+    std::stringstream stream;
+    stream << values[i % values.size()];
+    checksum += stream.str().size();
+  });
+  const auto dump_buffer = measure(operation_count, [&](size_t i) {
+    checksum += values[i % values.size()].dump().size();
+  });
+  const auto parse_stream = measure(operation_count, [&](size_t i) {
+    std::string error_string;
+    std::istringstream stream(encodings[i % encodings.size()]);
+    checksum += !msgpack11::MsgPack::parse(stream, error_string).is_null();
+  });
+  const auto parse_buffer = measure(operation_count, [&](size_t i) {
+    std::string error_string;
+    const auto& encoding = encodings[i % encodings.size()];
+    checksum += !msgpack11::MsgPack::parse(encoding, error_string).is_null();
+  });
+
+  print_measurement("msgpack11 dump (stream)", dump_stream);
+  print_measurement("msgpack11 dump (buffer)", dump_buffer);
+  print_measurement("msgpack11 parse (stream)", parse_stream);
+  print_measurement("msgpack11 parse (buffer)", parse_buffer);
+
+  TEST_ASSERT_TRUE(checksum > 0);
+}
+
+void network_handler_benchmark_test() {
+  std::srand(4242u);
+
+  const unsigned int message_count = 500;
+
+  for (const double packet_loss_rate : {0.0, 0.1, 0.3}) {
+    auto network_simulator = utils::NetworkSimulator();
+    network_simulator.set_packet_loss_rate(packet_loss_rate);
+
+    auto sender =
+        udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+    auto sender_network_handler = NetworkHandler();
+    sender_network_handler.set_udp_interface(
+        std::make_shared<utils::UdpInterfaceImpl>(
+            sender, sender_network_handler, network_simulator));
+
+    auto receiver =
+        udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+    auto receiver_network_handler = NetworkHandler();
+    receiver_network_handler.set_udp_interface(
+        std::make_shared<utils::UdpInterfaceImpl>(
+            receiver, receiver_network_handler, network_simulator));
+
+    network_simulator.register_endpoint(sender);
+    network_simulator.register_endpoint(receiver);
+    sender_network_handler.track_peer(receiver);
+
+    auto received_message_count = std::make_shared<unsigned int>(0);
+    receiver_network_handler.set_delegate(
+        std::make_shared<CountingNetworkHandlerDelegate>(
+            received_message_count));
+
+    std::vector<std::shared_ptr<NetworkMessage>> messages;
+    auto ack_count = std::make_shared<unsigned int>(0);
+    for (unsigned int i = 0; i < message_count; i += 1) {
+      messages.push_back(std::make_shared<CountingNetworkMessage>(
+          utils::generate_random_data_object(2), ack_count));
+    }
+
+    // in bounded mode, only as many messages as fit the send queue are sent
+    // at once
+    const unsigned int batch_size =
+        capacity::is_bounded ? capacity::max_in_flight : message_count;
+
+    unsigned int elapsed_deciseconds = 0;
+    const auto measurement = measure(message_count, [&](size_t i) {
+      sender_network_handler.send_message(messages[i], receiver);
+
+      // the last operation of a batch drives the network until every message
+      // sent so far is acked
+      if ((i + 1) % batch_size != 0 && i + 1 < message_count) {
+        return;
+      }
+
+      while (*ack_count < i + 1 && elapsed_deciseconds < 1000) {
+        while (network_simulator.is_incoming_packet_available(receiver) ||
+               network_simulator.is_incoming_packet_available(sender)) {
+          receiver_network_handler.heartbeat();
+          sender_network_handler.heartbeat();
+        }
+
+        sender_network_handler.on_100_ms_passed();
+        receiver_network_handler.on_100_ms_passed();
+        elapsed_deciseconds += 1;
+      }
+    });
+    const auto peak_bytes = allocation_utils::get_counts().peak_bytes;
+
+    TEST_ASSERT_EQUAL(message_count, *ack_count);
+    TEST_ASSERT_EQUAL(message_count, *received_message_count);
+
+    const auto& metrics = sender_network_handler.get_metrics();
+    const auto& to_receiver = metrics.endpoints.at(receiver);
+
+    TEST_PRINTF(
+        "loss %.0f%%: %.0f messages/s, %.2f packets/message, "
+        "%u simulated deciseconds, %.1f allocations/message, peak %u KiB\n",
+        packet_loss_rate * 100,
+        1e9 / measurement.nanoseconds_per_operation,
+        (double)to_receiver.packets_sent / message_count, elapsed_deciseconds,
+        measurement.allocations_per_operation,
+        (unsigned int)(peak_bytes / 1024));
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(codec_benchmark_test);
+  RUN_TEST(msgpack_backend_benchmark_test);
+  RUN_TEST(network_handler_benchmark_test);
+  return UNITY_END();
+}
@@ -0,0 +1,421 @@
+#include <unity.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "foo.h"
+
+#ifdef SMALL_DATA_SYNC_BOUNDED
+struct SynchronizableMock : public Synchronizable {
+ private:
+  std::string name;
+  int integer = 0;
+
+ public:
+  SynchronizableMock(const std::string name) : name(name) {}
+
+  int get_integer() const { return integer; }
+
+  void set_integer(const int value) { integer = value; }
+
+  std::string get_name() const { return name; };
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const {
+    return data_object::create_number_value(integer);
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) {
+    if (data_object->is_number()) {
+      integer = data_object->number_value().value();
+      return true;
+    }
+
+    return false;
+  }
+};
+
+/**
+ * Returns the name of the synchronizable with the given index. Every node can
+ * receive as many of them as it can synchronize itself.
+ */
+std::string get_synchronizable_name(const size_t index) {
+  return "s" + std::to_string(index);
+}
+
+struct DelegateImpl : public synchronizer::SynchronizerDelegate {
+  std::vector<std::shared_ptr<Synchronizable>>
+  create_initial_synchronizables_container() override {
+    std::vector<std::shared_ptr<Synchronizable>> container;
+    for (size_t i = 0; i < capacity::max_own_synchronizables; i += 1) {
+      container.push_back(
+          std::make_shared<SynchronizableMock>(get_synchronizable_name(i)));
+    }
+
+    return container;
+  }
+};
+
+struct RejectableMessage : public NetworkMessage {
+  MessagePriority priority;
+  std::shared_ptr<std::vector<std::string>> events;
+  std::string label;
+
+  RejectableMessage(const MessagePriority priority,
+                    const std::shared_ptr<std::vector<std::string>> events,
+                    const std::string label)
+      : priority(priority), events(events), label(label) {}
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return data_object::create_string_value(label);
+  };
+
+  MessagePriority get_priority() const override { return priority; }
+
+  void on_rejected() const override { events->push_back(label); }
+};
+
+udp_interface::Endpoint create_endpoint(const unsigned int index) {
+  return udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(index),
+                                 (uint16_t)index);
+}
+
+std::shared_ptr<synchronizer::Synchronizer> create_synchronizer(
+    udp_interface::Endpoint& endpoint,
+    utils::NetworkSimulator& network_simulator) {
+  // UdpInterfaceImpl does not use the network handler it is given
+  static NetworkHandler unused_network_handler;
+
+  auto result = synchronizer::Synchronizer::create("node");
+  result->set_mdns_interface(std::make_shared<utils::EmptyMDNSInterfaceImpl>());
+  result->set_delegate(std::make_shared<DelegateImpl>());
+  result->set_udp_interface(std::make_shared<utils::UdpInterfaceImpl>(
+      endpoint, unused_network_handler, network_simulator));
+  result->init();
+  network_simulator.register_endpoint(endpoint);
+
+  return result;
+}
+
+void run_deciseconds(
+    const std::vector<std::shared_ptr<synchronizer::Synchronizer>>& nodes,
+    const int count) {
+  for (int i = 0; i < count; i += 1) {
+    for (const auto& node : nodes) {
+      node->on_100_ms_passed();
+    }
+    for (int j = 0; j < 10; j += 1) {
+      for (const auto& node : nodes) {
+        node->heartbeat();
+      }
+    }
+  }
+}
+
+void capacity_configuration_test() {
+  TEST_ASSERT_TRUE(capacity::is_bounded);
+  TEST_ASSERT_EQUAL(SMALL_DATA_SYNC_MAX_PEERS, capacity::max_peers);
+  TEST_ASSERT_EQUAL(SMALL_DATA_SYNC_MAX_IN_FLIGHT, capacity::max_in_flight);
+  TEST_ASSERT_EQUAL(SMALL_DATA_SYNC_MAX_DEDUP_ENTRIES,
+                    capacity::max_dedup_entries);
+  TEST_ASSERT_EQUAL(SMALL_DATA_SYNC_MAX_OWN_SYNCHRONIZABLES,
+                    capacity::max_own_synchronizables);
+  TEST_ASSERT_EQUAL(SMALL_DATA_SYNC_MAX_REASSEMBLY_BYTES,
+                    capacity::max_reassembly_bytes);
+
+  // the tests below need room for a few peers and messages
+  TEST_ASSERT_TRUE(capacity::max_peers >= 2);
+  TEST_ASSERT_TRUE(capacity::max_in_flight >= 2);
+  TEST_ASSERT_TRUE(capacity::max_own_synchronizables < capacity::max_in_flight);
+}
+
+void flat_map_test() {
+  capacity::FlatMap<int, std::string> map;
+  map.reserve(4);
+  map[3] = "c";
+  map[1] = "a";
+  map[2] = "b";
+
+  TEST_ASSERT_EQUAL(3, map.size());
+  TEST_ASSERT_EQUAL(4, map.capacity());
+  TEST_ASSERT_EQUAL(1, map.begin()->first);
+  TEST_ASSERT_EQUAL_STRING("b", map.at(2).c_str());
+  TEST_ASSERT_TRUE(map.find(4) == map.end());
+
+  auto it = map.begin();
+  while (it != map.end()) {
+    it = it->first == 2 ? map.erase(it) : it + 1;
+  }
+  TEST_ASSERT_EQUAL(0, map.count(2));
+  TEST_ASSERT_EQUAL(1, map.erase(3));
+  TEST_ASSERT_EQUAL(0, map.erase(3));
+  TEST_ASSERT_EQUAL(1, map.size());
+  TEST_ASSERT_EQUAL(4, map.capacity());
+}
+
+void peer_capacity_test() {
+  const auto peer_count = (unsigned int)capacity::max_peers;
+  const auto extra_peer = create_endpoint(peer_count + 1);
+
+  auto network_simulator = utils::NetworkSimulator();
+  auto endpoint = create_endpoint(0);
+  auto node = create_synchronizer(endpoint, network_simulator);
+  for (unsigned int i = 1; i <= peer_count + 1; i += 1) {
+    network_simulator.register_endpoint(create_endpoint(i));
+    node->add_endpoint(create_endpoint(i));
+  }
+
+  for (unsigned int i = 1; i <= peer_count; i += 1) {
+    TEST_ASSERT_TRUE(node->is_endpoint_known(create_endpoint(i)));
+  }
+  TEST_ASSERT_FALSE(node->is_endpoint_known(extra_peer));
+
+  // synchronization data from an unknown peer is not stored
+  node->handle_synchronization_message(node->get_group_name_hash(),
+                                       extra_peer, get_synchronizable_name(0),
+                                       data_object::create_number_value(1));
+  TEST_ASSERT_FALSE(node->is_endpoint_known(extra_peer));
+
+  node->remove_endpoint(create_endpoint(1));
+  node->add_endpoint(extra_peer);
+  TEST_ASSERT_TRUE(node->is_endpoint_known(extra_peer));
+}
+
+void own_synchronizable_capacity_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  auto endpoint = create_endpoint(0);
+  auto peer = create_endpoint(1);
+  auto node = create_synchronizer(endpoint, network_simulator);
+  network_simulator.register_endpoint(peer);
+  node->add_endpoint(peer);
+
+  // one synchronizable more than fits is ignored, although the send queue
+  // would have room for its message
+  for (size_t i = 0; i <= capacity::max_own_synchronizables; i += 1) {
+    node->synchronize(
+        std::make_shared<SynchronizableMock>(get_synchronizable_name(i)));
+  }
+  TEST_ASSERT_EQUAL(capacity::max_own_synchronizables,
+                    node->get_network_metrics().active_message_count);
+}
+
+void in_flight_capacity_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  network_simulator.set_packet_loss_rate(1.0);
+
+  auto sender = create_endpoint(0);
+  auto receiver = create_endpoint(1);
+  auto network_handler = NetworkHandler();
+  network_handler.set_udp_interface(std::make_shared<utils::UdpInterfaceImpl>(
+      sender, network_handler, network_simulator));
+  network_handler.reserve_capacity();
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto events = std::make_shared<std::vector<std::string>>();
+  const auto send = [&](const MessagePriority priority,
+                        const std::string label) {
+    network_handler.send_message(
+        std::make_shared<RejectableMessage>(priority, events, label),
+        receiver);
+  };
+
+  // the queue is filled with messages of normal and of low priority
+  const auto normal_count = capacity::max_in_flight / 2;
+  const auto low_count = capacity::max_in_flight - normal_count;
+  for (size_t i = 0; i < normal_count; i += 1) {
+    send(MessagePriority::NORMAL, "normal " + std::to_string(i));
+  }
+  for (size_t i = 0; i < low_count; i += 1) {
+    send(MessagePriority::LOW, "low " + std::to_string(i));
+  }
+
+  // there is nothing of a lower priority to evict
+  send(MessagePriority::LOW, "low extra");
+  // the oldest message of the lowest priority makes room
+  send(MessagePriority::NORMAL, "normal extra");
+  for (size_t i = 0; i < low_count - 1 + normal_count; i += 1) {
+    send(MessagePriority::HIGH, "high " + std::to_string(i));
+  }
+
+  std::vector<std::string> expected_events = {"low extra"};
+  for (size_t i = 0; i < low_count; i += 1) {
+    expected_events.push_back("low " + std::to_string(i));
+  }
+  for (size_t i = 0; i < normal_count; i += 1) {
+    expected_events.push_back("normal " + std::to_string(i));
+  }
+  TEST_ASSERT_EQUAL(expected_events.size(), events->size());
+  for (size_t i = 0; i < expected_events.size(); i += 1) {
+    TEST_ASSERT_EQUAL_STRING(expected_events[i].c_str(),
+                             events->at(i).c_str());
+  }
+
+  const auto& metrics = network_handler.get_metrics();
+  TEST_ASSERT_EQUAL(capacity::max_in_flight, metrics.active_message_count);
+  TEST_ASSERT_EQUAL(capacity::max_in_flight,
+                    metrics.capacity.evicted_messages);
+  TEST_ASSERT_EQUAL(1, metrics.capacity.rejected_messages);
+}
+
+void deferred_synchronization_test() {
+  const auto receiver_count = (unsigned int)capacity::max_peers;
+  const auto synchronizable_count = capacity::max_own_synchronizables;
+  const auto message_count = receiver_count * (1 + synchronizable_count);
+  if (message_count <= capacity::max_in_flight) {
+    TEST_IGNORE_MESSAGE("The send queue never fills up with these capacities.");
+  }
+
+  auto network_simulator = utils::NetworkSimulator();
+  auto sender = create_endpoint(0);
+  auto sender_node = create_synchronizer(sender, network_simulator);
+
+  // the UDP interfaces refer to the endpoints, so these must not move
+  std::vector<udp_interface::Endpoint> receivers;
+  for (unsigned int i = 1; i <= receiver_count; i += 1) {
+    receivers.push_back(create_endpoint(i));
+  }
+
+  std::vector<std::shared_ptr<synchronizer::Synchronizer>> nodes = {
+      sender_node};
+  for (auto& receiver : receivers) {
+    nodes.push_back(create_synchronizer(receiver, network_simulator));
+    sender_node->add_endpoint(receiver);
+    nodes.back()->add_endpoint(sender);
+  }
+
+  // nothing arrives, so that the messages stay in flight
+  network_simulator.set_packet_loss_rate(1.0);
+  for (const auto& receiver : receivers) {
+    sender_node->request_initial_synchronization_from_endpoint(receiver);
+  }
+  for (size_t i = 0; i < synchronizable_count; i += 1) {
+    auto synchronizable =
+        std::make_shared<SynchronizableMock>(get_synchronizable_name(i));
+    synchronizable->set_integer(i + 1);
+    sender_node->synchronize(synchronizable);
+  }
+
+  const auto metrics = sender_node->get_network_metrics();
+  TEST_ASSERT_EQUAL(capacity::max_in_flight, metrics.active_message_count);
+  TEST_ASSERT_EQUAL(message_count - capacity::max_in_flight,
+                    metrics.capacity.rejected_messages);
+
+  const auto has_converged = [&]() {
+    for (size_t i = 1; i < nodes.size(); i += 1) {
+      for (size_t j = 0; j < synchronizable_count; j += 1) {
+        const auto received =
+            nodes[i]->get_synchronizable_for_endpoint<SynchronizableMock>(
+                sender, get_synchronizable_name(j));
+        if (!received.has_value() ||
+            received.value()->get_integer() != (int)j + 1) {
+          return false;
+        }
+      }
+    }
+
+    return sender_node->get_network_metrics().active_message_count == 0;
+  };
+
+  // the rejected synchronizations are sent once there is room again
+  network_simulator.set_packet_loss_rate(0.0);
+  for (int i = 0; i < 100 && !has_converged(); i += 1) {
+    run_deciseconds(nodes, 1);
+  }
+  TEST_ASSERT_TRUE(has_converged());
+}
+
+void dedup_capacity_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  auto sender = create_endpoint(0);
+  auto receiver = create_endpoint(1);
+
+  auto sender_network_handler = NetworkHandler();
+  sender_network_handler.set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          sender, sender_network_handler, network_simulator));
+  auto receiver_network_handler = NetworkHandler();
+  receiver_network_handler.set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          receiver, receiver_network_handler, network_simulator));
+  receiver_network_handler.reserve_capacity();
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto events = std::make_shared<std::vector<std::string>>();
+  for (size_t i = 0; i < capacity::max_dedup_entries + 2; i += 1) {
+    sender_network_handler.send_message(
+        std::make_shared<RejectableMessage>(MessagePriority::NORMAL, events,
+                                            std::to_string(i)),
+        receiver);
+    receiver_network_handler.heartbeat();
+    sender_network_handler.heartbeat();
+  }
+
+  TEST_ASSERT_EQUAL(
+      2,
+      receiver_network_handler.get_metrics().capacity.forgotten_message_ids);
+  TEST_ASSERT_EQUAL(0,
+                    sender_network_handler.get_metrics().active_message_count);
+}
+void reassembly_capacity_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  auto sender = create_endpoint(0);
+  auto receiver = create_endpoint(1);
+
+  auto sender_network_handler = NetworkHandler();
+  sender_network_handler.set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          sender, sender_network_handler, network_simulator));
+  sender_network_handler.set_max_packet_size(508);
+  auto receiver_network_handler = NetworkHandler();
+  receiver_network_handler.set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          receiver, receiver_network_handler, network_simulator));
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  // the limit cannot be raised beyond the capacity, so larger messages are
+  // refused
+  receiver_network_handler.set_reassembly_limits(
+      4, capacity::max_reassembly_bytes * 4);
+
+  auto events = std::make_shared<std::vector<std::string>>();
+  sender_network_handler.send_message(
+      std::make_shared<RejectableMessage>(
+          MessagePriority::NORMAL, events,
+          std::string(capacity::max_reassembly_bytes * 2, 'a')),
+      receiver);
+  for (int i = 0; i < 10; i += 1) {
+    receiver_network_handler.heartbeat();
+    sender_network_handler.heartbeat();
+  }
+
+  const auto& metrics = sender_network_handler.get_metrics();
+  TEST_ASSERT_EQUAL(1, metrics.capacity.refused_messages);
+  TEST_ASSERT_EQUAL(0, metrics.active_message_count);
+}
+#else
+void bounded_mode_disabled_test() {
+  TEST_IGNORE_MESSAGE("SMALL_DATA_SYNC_BOUNDED is not defined.");
+}
+#endif
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+#ifdef SMALL_DATA_SYNC_BOUNDED
+  RUN_TEST(capacity_configuration_test);
+  RUN_TEST(flat_map_test);
+  RUN_TEST(peer_capacity_test);
+  RUN_TEST(own_synchronizable_capacity_test);
+  RUN_TEST(in_flight_capacity_test);
+  RUN_TEST(deferred_synchronization_test);
+  RUN_TEST(dedup_capacity_test);
+  RUN_TEST(reassembly_capacity_test);
+#else
+  RUN_TEST(bounded_mode_disabled_test);
+#endif
+  return UNITY_END();
+}
@@ -0,0 +1,242 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "foo.h"
+
+struct ScheduleMessage : public NetworkMessage {
+  std::shared_ptr<data_object::GenericValue> schedule;
+
+  ScheduleMessage(std::shared_ptr<data_object::GenericValue> schedule)
+      : schedule(schedule) {}
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return schedule;
+  };
+};
+
+struct NetworkHandlerDelegateImpl : public NetworkHandlerDelegate {
+  std::shared_ptr<std::vector<std::shared_ptr<data_object::GenericValue>>>
+      received = std::make_shared<
+          std::vector<std::shared_ptr<data_object::GenericValue>>>();
+
+  void on_message_received(IncomingDecodedMessage message) const override {
+    received->push_back(message.data_object);
+  };
+};
+
+struct RecordingUdpInterface : public utils::UdpInterfaceImpl {
+  std::vector<std::string> sent_packets;
+
+  RecordingUdpInterface(udp_interface::Endpoint& endpoint,
+                        NetworkHandler& network_handler,
+                        utils::NetworkSimulator& network_simulator)
+      : utils::UdpInterfaceImpl(endpoint, network_handler, network_simulator) {}
+
+  bool send_packet(const udp_interface::Endpoint receiver,
+                   const std::string packet) override {
+    sent_packets.push_back(packet);
+
+    return utils::UdpInterfaceImpl::send_packet(receiver, packet);
+  }
+};
+
+/**
+ * A schedule of 48 half-hour slots, similar to the lookup tables that motivated
+ * compression.
+ */
+std::shared_ptr<data_object::GenericValue> create_schedule() {
+  data_object::GenericValue::array slots;
+  for (int i = 0; i < 48; i += 1) {
+    slots.push_back(data_object::create_object({
+        {"start", data_object::create_int_value(i * 30)},
+        {"mode", data_object::create_string_value(i % 12 < 8 ? "eco" : "comfort")},
+        {"setpoint", data_object::create_number_value(i % 12 < 8 ? 18.5 : 21)},
+    }));
+  }
+
+  return data_object::create_array(slots);
+}
+
+void lzf_round_trip_test() {
+  std::srand(37);
+
+  std::vector<std::string> inputs = {
+      std::string(1000, 'a'),
+      "abcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabc",
+      MsgPackCodec().encode(create_schedule()),
+      JsonCodec().encode(create_schedule()),
+  };
+  for (int i = 0; i < 50; i += 1) {
+    inputs.push_back(JsonCodec().encode(utils::generate_random_data_object(3)));
+  }
+
+  for (const auto& input : inputs) {
+    const auto compressed = lzf::compress(input);
+    if (!compressed.has_value()) {
+      continue;
+    }
+
+    TEST_ASSERT_TRUE(compressed.value().size() < input.size());
+
+    const auto decompressed = lzf::decompress(compressed.value());
+    TEST_ASSERT_TRUE_MESSAGE(decompressed.has_value(),
+                             "decompression should succeed.");
+    TEST_ASSERT_TRUE(decompressed.value() == input);
+  }
+
+  TEST_ASSERT_TRUE(lzf::compress(std::string(1000, 'a')).value().size() < 20);
+
+  std::string noise;
+  for (int i = 0; i < 200; i += 1) {
+    noise += (char)(std::rand() % 256);
+  }
+  TEST_ASSERT_FALSE_MESSAGE(lzf::compress(noise).has_value(),
+                            "incompressible input should not be compressed.");
+}
+
+void lzf_malformed_input_test() {
+  const auto compressed =
+      lzf::compress(MsgPackCodec().encode(create_schedule())).value();
+
+  TEST_ASSERT_FALSE(lzf::decompress("").has_value());
+  TEST_ASSERT_FALSE(
+      lzf::decompress(compressed.substr(0, compressed.size() - 1))
+          .has_value());
+
+  // a back-reference before the start of the output
+  TEST_ASSERT_FALSE(lzf::decompress(std::string("\x05\x00\x20\x10", 4))
+                        .has_value());
+
+  // a declared size that does not match the output
+  auto wrong_size = compressed;
+  wrong_size[0] = (char)(wrong_size[0] + 1);
+  TEST_ASSERT_FALSE(lzf::decompress(wrong_size).has_value());
+}
+
+void compressed_network_handler_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<RecordingUdpInterface>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_compression_threshold(128);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>();
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  const auto schedule = create_schedule();
+  sender_network_handler.send_message(
+      std::make_shared<ScheduleMessage>(schedule), receiver, 100);
+  sender_network_handler.send_message(
+      std::make_shared<ScheduleMessage>(data_object::create_int_value(1)),
+      receiver, 100);
+
+  // one packet is received per heartbeat
+  receiver_network_handler.heartbeat();
+  receiver_network_handler.heartbeat();
+  sender_network_handler.heartbeat();
+
+  TEST_ASSERT_EQUAL(2, sender_udp_interface->sent_packets.size());
+  const auto& large_packet = sender_udp_interface->sent_packets[0];
+  const auto& small_packet = sender_udp_interface->sent_packets[1];
+
+  TEST_ASSERT_EQUAL_HEX8(0x82, (uint8_t)large_packet[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, (uint8_t)small_packet[0]);
+
+  const auto uncompressed_size =
+      MsgPackCodec()
+          .encode(data_object::create_array({
+              data_object::create_string_value("message"),
+              data_object::create_int_value(0),
+              schedule,
+          }))
+          .size();
+  TEST_ASSERT_TRUE(large_packet.size() < uncompressed_size / 2);
+
+  TEST_ASSERT_EQUAL(2, receiver_delegate->received->size());
+  TEST_ASSERT_TRUE(receiver_delegate->received->at(0)->equals(schedule));
+  TEST_ASSERT_EQUAL(1,
+                    receiver_delegate->received->at(1)->int_value().value());
+}
+
+void compression_benchmark_test() {
+  std::srand(37);
+
+  struct Sample {
+    const char* label;
+    std::vector<std::string> encodings;
+  };
+
+  std::vector<Sample> samples = {
+      {"schedule (msgpack)", {MsgPackCodec().encode(create_schedule())}},
+      {"schedule (json)", {JsonCodec().encode(create_schedule())}},
+      {"random trees (msgpack)", {}},
+      {"random trees (json)", {}},
+  };
+  for (int i = 0; i < 100; i += 1) {
+    const auto value = utils::generate_random_data_object(3);
+    samples[2].encodings.push_back(MsgPackCodec().encode(value));
+    samples[3].encodings.push_back(JsonCodec().encode(value));
+  }
+
+  const int iterations = 200;
+
+  for (const auto& sample : samples) {
+    size_t raw_size = 0;
+    size_t sent_size = 0;
+    for (const auto& encoding : sample.encodings) {
+      const auto compressed = lzf::compress(encoding);
+      raw_size += encoding.size();
+      sent_size += compressed.has_value() ? compressed.value().size()
+                                          : encoding.size();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i += 1) {
+      for (const auto& encoding : sample.encodings) {
+        const auto compressed = lzf::compress(encoding);
+        if (compressed.has_value()) {
+          lzf::decompress(compressed.value());
+        }
+      }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    TEST_PRINTF("%s: %u -> %u B (%.1f%%), %.1f ns/B compress + decompress\n",
+                sample.label, (unsigned int)raw_size, (unsigned int)sent_size,
+                100.0 * sent_size / raw_size,
+                (double)nanoseconds / iterations / raw_size);
+
+    TEST_ASSERT_TRUE(sent_size <= raw_size);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(lzf_round_trip_test);
+  RUN_TEST(lzf_malformed_input_test);
+  RUN_TEST(compressed_network_handler_test);
+  RUN_TEST(compression_benchmark_test);
+  UNITY_END();
+}
@@ -0,0 +1,144 @@
+#include <unity.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "foo.h"
+
+typedef uint32_t (*Crc32UpdateFunction)(const void*, size_t, uint32_t);
+
+struct Crc32Implementation {
+  const char* label;
+  Crc32UpdateFunction update;
+};
+
+std::vector<Crc32Implementation> get_compiled_implementations() {
+  std::vector<Crc32Implementation> implementations = {
+      {"crc32Update", &crc32Update},
+  };
+#if CRC32_HAS_BITWISE
+  implementations.push_back({"bitwise", &crc32UpdateBitwise});
+#endif
+#if CRC32_HAS_NIBBLE_TABLE
+  implementations.push_back({"nibble table", &crc32UpdateNibbleTable});
+#endif
+#if CRC32_HAS_BYTE_TABLE
+  implementations.push_back({"byte table", &crc32UpdateByteTable});
+#endif
+#if CRC32_HAS_SLICE_BY_8
+  implementations.push_back({"slice-by-8", &crc32UpdateSliceBy8});
+#endif
+#if CRC32_HAS_HARDWARE
+  implementations.push_back({"hardware", &crc32UpdateHardware});
+#endif
+  return implementations;
+}
+
+uint32_t reference_crc32_update(const char* data, size_t size, uint32_t crc) {
+  for (size_t i = 0; i < size; i += 1) {
+    crc ^= (uint8_t)data[i];
+    for (int bit = 0; bit < 8; bit += 1) {
+      crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+std::string create_random_bytes(const size_t size) {
+  std::string bytes(size, '\0');
+  for (auto& byte : bytes) {
+    byte = (char)(std::rand() & 0xff);
+  }
+  return bytes;
+}
+
+void crc32_check_value_test() {
+  TEST_ASSERT_EQUAL_HEX32(0xcbf43926, crc32String("123456789"));
+  TEST_ASSERT_EQUAL_HEX32(0x00000000, crc32Buffer("", 0));
+
+  for (const auto& implementation : get_compiled_implementations()) {
+    const auto crc = crc32Final(
+        implementation.update("123456789", 9, CRC32_INITIAL));
+    TEST_ASSERT_EQUAL_HEX32_MESSAGE(0xcbf43926, crc, implementation.label);
+  }
+}
+
+void crc32_implementations_agree_test() {
+  std::srand(8123);
+
+  const auto implementations = get_compiled_implementations();
+
+  for (int i = 0; i < 200; i += 1) {
+    const auto bytes = create_random_bytes(std::rand() % 300);
+    // start at a random offset so unaligned reads are covered
+    const auto offset = bytes.empty() ? 0 : std::rand() % 8 % bytes.size();
+    const auto data = bytes.data() + offset;
+    const auto size = bytes.size() - offset;
+    const auto split = size == 0 ? 0 : std::rand() % size;
+
+    const auto expected = crc32Final(
+        reference_crc32_update(data, size, CRC32_INITIAL));
+
+    for (const auto& implementation : implementations) {
+      TEST_ASSERT_EQUAL_HEX32_MESSAGE(
+          expected,
+          crc32Final(implementation.update(data, size, CRC32_INITIAL)),
+          implementation.label);
+
+      // updating in two steps gives the same result
+      const auto partial = implementation.update(data, split, CRC32_INITIAL);
+      TEST_ASSERT_EQUAL_HEX32_MESSAGE(
+          expected,
+          crc32Final(
+              implementation.update(data + split, size - split, partial)),
+          implementation.label);
+    }
+  }
+}
+
+void crc32_benchmark_test() {
+  std::srand(99);
+
+  const struct {
+    const char* label;
+    size_t size;
+  } workloads[] = {
+      {"group name", 16},
+      {"packet", 1400},
+  };
+  const size_t bytes_per_run = 1 << 20;
+
+  for (const auto& workload : workloads) {
+    const auto bytes = create_random_bytes(workload.size);
+    const size_t iterations = bytes_per_run / workload.size;
+
+    for (const auto& implementation : get_compiled_implementations()) {
+      uint32_t crc = CRC32_INITIAL;
+
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < iterations; i += 1) {
+        crc = implementation.update(bytes.data(), bytes.size(), crc);
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      const auto nanoseconds =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count();
+
+      TEST_PRINTF("%s, %s: %.1f MB/s (crc %08x)\n", workload.label,
+                  implementation.label,
+                  1000.0 * iterations * workload.size / (double)nanoseconds,
+                  (unsigned int)crc32Final(crc));
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(crc32_check_value_test);
+  RUN_TEST(crc32_implementations_agree_test);
+  RUN_TEST(crc32_benchmark_test);
+  return UNITY_END();
+}
@@ -0,0 +1,201 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "../allocation_utils.h"
+#include "../utils.h"
+#include "foo.h"
+
+/**
+ * A synchronizable with a few fields, roughly the size of the states the
+ * example sketches synchronize.
+ */
+struct SynchronizableMock : public Synchronizable {
+ private:
+  int counter = 0;
+
+ public:
+  void increment() { counter += 1; }
+
+  std::string get_name() const { return "SynchronizableMock"; };
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const {
+    data_object::GenericValue::object object;
+    object["counter"] = data_object::create_number_value(counter);
+    object["enabled"] = data_object::create_bool_value(counter % 2 == 0);
+    object["label"] = data_object::create_string_value("living room");
+    return data_object::create_object(object);
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) {
+    const auto counter_value = (*data_object)["counter"];
+    if (!counter_value.has_value() || !counter_value.value()->is_number()) {
+      return false;
+    }
+
+    counter = counter_value.value()->number_value().value();
+    return true;
+  }
+};
+
+struct DelegateImpl : public synchronizer::SynchronizerDelegate {
+  std::vector<std::shared_ptr<Synchronizable>>
+  create_initial_synchronizables_container() override {
+    return {
+        std::make_shared<SynchronizableMock>(),
+    };
+  }
+};
+
+/**
+ * The allocation budgets of the three operations every synchronized message
+ * goes through. They are set slightly above the measured values, so that a
+ * change that adds allocations to the message path fails the test. Lower them
+ * when an optimization lands.
+ */
+struct MessageBudgets {
+  DataFormat data_format;
+  allocation_utils::AllocationBudget synchronize;
+  allocation_utils::AllocationBudget received_packet;
+  allocation_utils::AllocationBudget ack;
+};
+
+/**
+ * Keeps the higher allocation count and peak of the two.
+ */
+void keep_maximum(allocation_utils::AllocationCounts& maximum,
+                  const allocation_utils::AllocationCounts& counts) {
+  maximum.allocations = std::max(maximum.allocations, counts.allocations);
+  maximum.peak_bytes = std::max(maximum.peak_bytes, counts.peak_bytes);
+}
+
+void message_path_budget_test() {
+  const MessageBudgets all_budgets[] = {
+      {DataFormat::JSON, {54, 1800}, {86, 3400}, {16, 640}},
+      {DataFormat::MSGPACK, {50, 1700}, {84, 3300}, {15, 640}},
+      {DataFormat::PACKED, {50, 1700}, {84, 3300}, {15, 640}},
+  };
+
+  for (const auto& budgets : all_budgets) {
+    auto network_simulator = utils::NetworkSimulator();
+    const auto empty_mdns_interface =
+        std::make_shared<utils::EmptyMDNSInterfaceImpl>();
+
+    auto sender =
+        udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+    auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+    sender_synchronizer->set_mdns_interface(empty_mdns_interface);
+    sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+    sender_synchronizer->set_default_data_format(budgets.data_format);
+    auto sender_network_handler = sender_synchronizer->get_network_handler();
+    sender_synchronizer->set_udp_interface(
+        std::make_shared<utils::UdpInterfaceImpl>(
+            sender, sender_network_handler, network_simulator));
+    sender_synchronizer->init();
+
+    auto receiver =
+        udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+    auto receiver_synchronizer = synchronizer::Synchronizer::create("receiver");
+    receiver_synchronizer->set_mdns_interface(empty_mdns_interface);
+    receiver_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+    receiver_synchronizer->set_default_data_format(budgets.data_format);
+    auto receiver_network_handler =
+        receiver_synchronizer->get_network_handler();
+    receiver_synchronizer->set_udp_interface(
+        std::make_shared<utils::UdpInterfaceImpl>(
+            receiver, receiver_network_handler, network_simulator));
+    receiver_synchronizer->init();
+
+    network_simulator.register_endpoint(sender);
+    network_simulator.register_endpoint(receiver);
+
+    receiver_synchronizer->add_endpoint(sender);
+    sender_synchronizer->add_endpoint(receiver);
+
+    auto synchronizable = std::make_shared<SynchronizableMock>();
+    allocation_utils::AllocationCounts synchronize_counts;
+    allocation_utils::AllocationCounts received_packet_counts;
+    allocation_utils::AllocationCounts ack_counts;
+
+    // the first round sets up the per-endpoint state, so only the later
+    // rounds are measured
+    for (int round = 0; round < 5; round += 1) {
+      synchronizable->increment();
+      const auto synchronize = allocation_utils::count_allocations(
+          [&]() { sender_synchronizer->synchronize(synchronizable); });
+      TEST_ASSERT_TRUE(
+          network_simulator.is_incoming_packet_available(receiver));
+
+      const auto received_packet = allocation_utils::count_allocations(
+          [&]() { receiver_synchronizer->heartbeat(); });
+      TEST_ASSERT_TRUE(network_simulator.is_incoming_packet_available(sender));
+
+      const auto ack = allocation_utils::count_allocations(
+          [&]() { sender_synchronizer->heartbeat(); });
+      TEST_ASSERT_FALSE(network_simulator.is_incoming_packet_available(sender));
+      TEST_ASSERT_EQUAL(0, sender_synchronizer->get_network_metrics()
+                               .active_message_count);
+
+      if (round == 0) {
+        continue;
+      }
+
+      keep_maximum(synchronize_counts, synchronize);
+      keep_maximum(received_packet_counts, received_packet);
+      keep_maximum(ack_counts, ack);
+    }
+
+    const auto label =
+        std::string("format ") + std::to_string((int)budgets.data_format);
+    allocation_utils::assert_within_budget(
+        label + " synchronize", synchronize_counts, budgets.synchronize);
+    allocation_utils::assert_within_budget(label + " received packet",
+                                           received_packet_counts,
+                                           budgets.received_packet);
+    allocation_utils::assert_within_budget(label + " ack", ack_counts,
+                                           budgets.ack);
+  }
+}
+
+void codec_budget_test() {
+  const struct {
+    const char* label;
+    std::shared_ptr<Codec> codec;
+    allocation_utils::AllocationBudget encode;
+    allocation_utils::AllocationBudget decode;
+  } codecs[] = {
+      {"JsonCodec", std::make_shared<JsonCodec>(), {5, 160}, {27, 1900}},
+      {"MsgPackCodec", std::make_shared<MsgPackCodec>(), {4, 160}, {30, 1900}},
+  };
+
+  SynchronizableMock synchronizable;
+  const auto data_object = synchronizable.to_data_object();
+
+  for (const auto& entry : codecs) {
+    std::string encoded_data;
+    const auto encode = allocation_utils::count_allocations(
+        [&]() { encoded_data = entry.codec->encode(data_object); });
+
+    const auto decode = allocation_utils::count_allocations([&]() {
+      std::string error_string;
+      TEST_ASSERT_TRUE(
+          entry.codec->decode(encoded_data, error_string).has_value());
+    });
+
+    const auto label = std::string(entry.label);
+    allocation_utils::assert_within_budget(label + " encode", encode,
+                                           entry.encode);
+    allocation_utils::assert_within_budget(label + " decode", decode,
+                                           entry.decode);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(message_path_budget_test);
+  RUN_TEST(codec_budget_test);
+  return UNITY_END();
+}
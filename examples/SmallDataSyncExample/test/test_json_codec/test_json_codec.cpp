@@ -81,15 +81,85 @@ void fuzzy_json_codec_test() {
     TEST_ASSERT_EQUAL_STRING(
         data_object->to_debug_string().c_str(),
         decoded_data_object.value()->to_debug_string().c_str());
+
+    // The codec writes directly; its output must match json11’s.
+    TEST_ASSERT_TRUE(json11::Json::parse(encoding, error_string).dump() == encoding);
   }
 }
 
+void integer_json_codec_test() {
+  auto codec = std::make_shared<JsonCodec>();
+
+  auto encoding = codec->encode(create_array({
+      create_int_value(-42),
+      create_uint_value(UINT64_MAX),
+      create_number_value(42),
+  }));
+
+  TEST_ASSERT_EQUAL_STRING("[-42, 18446744073709551615, 42]",
+                           encoding.c_str());
+
+  // json11 parses numbers as doubles, so integers are only exact up to 2^53.
+  std::string error_string;
+  auto decoded_data_object = codec->decode(encoding, error_string);
+
+  TEST_ASSERT_TRUE(decoded_data_object.has_value());
+  TEST_ASSERT_TRUE(
+      decoded_data_object.value()->array_items().value()->at(0)->equals(
+          create_int_value(-42)));
+}
+
+void blob_json_codec_test() {
+  auto codec = std::make_shared<JsonCodec>();
+
+  const uint8_t bytes[] = {'s', 'y', 'n', 'c', 0x00, 0xff};
+  auto encoding = codec->encode(create_blob_value(bytes, sizeof(bytes)));
+
+  TEST_ASSERT_EQUAL_STRING("\"c3luYwD/\"", encoding.c_str());
+
+  const auto decoded = base64::decode("c3luYwD/").value();
+  TEST_ASSERT_EQUAL(sizeof(bytes), decoded.size());
+  TEST_ASSERT_EQUAL_MEMORY(bytes, decoded.data(), sizeof(bytes));
+
+  TEST_ASSERT_EQUAL_STRING("c3k=", base64::encode(bytes, 2).c_str());
+  TEST_ASSERT_EQUAL(2, base64::decode("c3k=").value().size());
+  TEST_ASSERT_FALSE(base64::decode("c3k").has_value());
+  TEST_ASSERT_FALSE(base64::decode("c3!=").has_value());
+}
+
+void key_dictionary_json_codec_test() {
+  auto options = CodecOptions();
+  options.key_dictionary = std::make_shared<KeyDictionary>(
+      std::vector<std::string>{"temperature", "humidity"});
+  auto codec = std::make_shared<JsonCodec>(options);
+
+  auto data_object = create_object({
+      {"temperature", create_int_value(21)},
+      {"humidity", create_int_value(48)},
+      {"#1", create_string_value("looks like an index")},
+      {"#", create_null_value()},
+  });
+
+  auto encoding = codec->encode(data_object);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"##\": null, \"##1\": \"looks like an index\", \"#1\": 48, \"#0\": 21}",
+      encoding.c_str());
+
+  std::string error_string;
+  auto decoded_data_object = codec->decode(encoding, error_string);
+  TEST_ASSERT_TRUE(decoded_data_object.has_value());
+  TEST_ASSERT_TRUE(decoded_data_object.value()->equals(data_object));
+}
+
 int main(int argc, char **argv) {
   UNITY_BEGIN();
 
   RUN_TEST(basic_json_codec_test);
   RUN_TEST(invalid_encoding_test);
   RUN_TEST(fuzzy_json_codec_test);
+  RUN_TEST(integer_json_codec_test);
+  RUN_TEST(blob_json_codec_test);
+  RUN_TEST(key_dictionary_json_codec_test);
 
   return UNITY_END();
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <unity.h>
 
 #include <memory>
+#include <sstream>
 
 #include "../utils.h"
 #include "foo.h"
@@ -80,7 +81,154 @@ void fuzzy_msgpack_codec_test() {
     TEST_ASSERT_EQUAL_STRING(
         data_object->to_debug_string().c_str(),
         decoded_data_object.value()->to_debug_string().c_str());
+
+    // The codec writes directly; its output must match msgpack11’s.
+    TEST_ASSERT_TRUE(msgpack11::MsgPack::parse(encoding, error_string).dump() == encoding);
+  }
+}
+
+void integer_msgpack_codec_test() {
+  auto codec = std::make_shared<MsgPackCodec>();
+
+  TEST_ASSERT_EQUAL(1, codec->encode(create_int_value(5)).size());
+  TEST_ASSERT_EQUAL(1, codec->encode(create_int_value(-32)).size());
+  TEST_ASSERT_EQUAL(2, codec->encode(create_int_value(200)).size());
+  TEST_ASSERT_EQUAL(3, codec->encode(create_int_value(-1000)).size());
+  TEST_ASSERT_EQUAL(5, codec->encode(create_uint_value(4000000000u)).size());
+  TEST_ASSERT_EQUAL(9, codec->encode(create_number_value(5)).size());
+
+  auto data_object = create_array({
+      create_int_value(INT64_MIN),
+      create_int_value(-129),
+      create_int_value(0),
+      create_int_value((int64_t)1 << 53 | 1),
+      create_uint_value(UINT64_MAX),
+      create_number_value(2.5),
+  });
+
+  auto encoding = codec->encode(data_object);
+
+  std::string error_string;
+  auto decoded_data_object = codec->decode(encoding, error_string);
+
+  TEST_ASSERT_TRUE(decoded_data_object.has_value());
+  TEST_ASSERT_TRUE(decoded_data_object.value()->equals(data_object));
+  TEST_ASSERT_TRUE(msgpack11::MsgPack::parse(encoding, error_string).dump() ==
+                   encoding);
+
+  auto items = decoded_data_object.value()->array_items().value();
+  TEST_ASSERT_TRUE(items->at(0)->int_value().value() == INT64_MIN);
+  TEST_ASSERT_TRUE(items->at(3)->int_value().value() ==
+                   ((int64_t)1 << 53 | 1));
+  TEST_ASSERT_TRUE(items->at(4)->uint_value().value() == UINT64_MAX);
+  TEST_ASSERT_FALSE(items->at(4)->int_value().has_value());
+  TEST_ASSERT_FALSE(items->at(5)->is_integer());
+}
+
+void blob_msgpack_codec_test() {
+  auto codec = std::make_shared<MsgPackCodec>();
+
+  std::vector<uint8_t> bytes(300);
+  for (size_t i = 0; i < bytes.size(); i += 1) {
+    bytes[i] = (uint8_t)(i * 7);
+  }
+
+  auto data_object = create_array({
+      create_blob_value(bytes),
+      create_blob_value(bytes.data(), 3),
+  });
+
+  auto encoding = codec->encode(data_object);
+  TEST_ASSERT_EQUAL(1 + (3 + 300) + (2 + 3), encoding.size());
+
+  std::string error_string;
+  auto decoded_data_object = codec->decode(encoding, error_string);
+
+  TEST_ASSERT_TRUE(decoded_data_object.has_value());
+  TEST_ASSERT_TRUE(decoded_data_object.value()->equals(data_object));
+  TEST_ASSERT_TRUE(msgpack11::MsgPack::parse(encoding, error_string).dump() ==
+                   encoding);
+
+  auto blob = decoded_data_object.value()->array_items().value()->at(0);
+  TEST_ASSERT_TRUE(blob->is_blob());
+
+  auto view = blob->blob_value().value();
+  TEST_ASSERT_EQUAL(300, view.size);
+  TEST_ASSERT_TRUE(view.data == blob->blob_value().value().data);
+  TEST_ASSERT_EQUAL_MEMORY(bytes.data(), view.data, bytes.size());
+}
+
+void key_dictionary_msgpack_codec_test() {
+  auto options = CodecOptions();
+  options.key_dictionary = std::make_shared<KeyDictionary>(
+      std::vector<std::string>{"temperature", "humidity"});
+  auto codec = std::make_shared<MsgPackCodec>(options);
+
+  auto data_object = create_object({
+      {"temperature", create_int_value(21)},
+      {"humidity", create_int_value(48)},
+      {"label", create_string_value("kitchen")},
+  });
+
+  auto encoding = codec->encode(data_object);
+  auto plain_encoding = MsgPackCodec().encode(data_object);
+
+  // "temperature" and "humidity" each shrink to a 1-byte index
+  TEST_ASSERT_EQUAL(plain_encoding.size() - 11 - 8, encoding.size());
+
+  std::string error_string;
+  auto decoded_data_object = codec->decode(encoding, error_string);
+  TEST_ASSERT_TRUE(decoded_data_object.has_value());
+  TEST_ASSERT_TRUE(decoded_data_object.value()->equals(data_object));
+
+  // a codec without the dictionary cannot restore the keys
+  auto plain_decoded = MsgPackCodec().decode(encoding, error_string);
+  TEST_ASSERT_TRUE(plain_decoded.has_value());
+  TEST_ASSERT_TRUE((*plain_decoded.value())["1"].has_value());
+}
+
+void buffer_backend_msgpack_test() {
+  std::srand(9151u);
+
+  for (int i = 0; i < 500; i += 1) {
+    const auto encoding =
+        MsgPackCodec().encode(utils::generate_random_data_object(3));
+
+    std::string error_string;
+    const auto parsed = msgpack11::MsgPack::parse(encoding, error_string);
+    TEST_ASSERT_TRUE(error_string.empty());
+
+    std::istringstream input(encoding);
+    const auto stream_parsed = msgpack11::MsgPack::parse(input, error_string);
+    TEST_ASSERT_TRUE(error_string.empty());
+    TEST_ASSERT_TRUE(parsed == stream_parsed);
+
+    std::ostringstream output;
+    output << parsed;
+    TEST_ASSERT_TRUE(output.str() == encoding);
+    TEST_ASSERT_TRUE(parsed.dump() == encoding);
+
+    // every truncation runs into the end of the buffer
+    const auto truncated = encoding.substr(0, std::rand() % encoding.size());
+    msgpack11::MsgPack::parse(truncated, error_string);
+    TEST_ASSERT_EQUAL_STRING("end of buffer.", error_string.c_str());
   }
+
+  // length prefixes beyond the end of the buffer fail before allocating
+  const std::string huge_array = "\xdd\xff\xff\xff\xff\x01";
+  const std::string huge_string = "\xdb\xff\xff\xff\xff" "ab";
+  for (const auto& encoding : {huge_array, huge_string}) {
+    std::string error_string;
+    const auto parsed = msgpack11::MsgPack::parse(encoding, error_string);
+    TEST_ASSERT_EQUAL_STRING("end of buffer.", error_string.c_str());
+    TEST_ASSERT_TRUE(parsed.is_null());
+  }
+
+  std::string error_string;
+  const auto multi = msgpack11::MsgPack::parse_multi("\x01\xa1x\xc3",
+                                                     error_string);
+  TEST_ASSERT_EQUAL(3, multi.size());
+  TEST_ASSERT_EQUAL_STRING("x", multi[1].string_value().c_str());
 }
 
 int main(int argc, char **argv) {
@@ -89,6 +237,10 @@ int main(int argc, char **argv) {
   RUN_TEST(basic_msgpack_codec_test);
   RUN_TEST(invalid_encoding_test);
   RUN_TEST(fuzzy_msgpack_codec_test);
+  RUN_TEST(integer_msgpack_codec_test);
+  RUN_TEST(blob_msgpack_codec_test);
+  RUN_TEST(key_dictionary_msgpack_codec_test);
+  RUN_TEST(buffer_backend_msgpack_test);
 
   return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include <unity.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../thread_utils.h"
+#include "../utils.h"
+#include "foo.h"
+
+#define GROUP_COUNT 200
+#define SHARD_COUNT 4
+
+struct CounterSynchronizable : public Synchronizable {
+ private:
+  int value = 0;
+
+ public:
+  int get_value() const { return value; }
+
+  void set_value(const int new_value) { value = new_value; }
+
+  std::string get_name() const override { return "counter"; };
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return data_object::create_number_value(value);
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) override {
+    if (data_object->is_number()) {
+      value = data_object->int_value().value();
+      return true;
+    }
+
+    return false;
+  }
+};
+
+struct DelegateImpl : public synchronizer::SynchronizerDelegate {
+  std::vector<std::shared_ptr<Synchronizable>>
+  create_initial_synchronizables_container() override {
+    return {
+        std::make_shared<CounterSynchronizable>(),
+    };
+  }
+};
+
+std::shared_ptr<synchronizer::Synchronizer> create_synchronizer(
+    const char *hostname, const int group_index) {
+  const auto synchronizer = synchronizer::Synchronizer::create(hostname);
+  synchronizer->set_mdns_interface(
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>());
+  synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  synchronizer->set_group_name("group_" + std::to_string(group_index));
+
+  return synchronizer;
+}
+
+udp_interface::Endpoint create_endpoint(const int index) {
+  return udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(index),
+                                 (uint16_t)index);
+}
+
+/**
+ * A plain Synchronizer of one group, driven by the test thread.
+ */
+struct Peer {
+  udp_interface::Endpoint endpoint;
+  std::shared_ptr<synchronizer::Synchronizer> synchronizer;
+};
+
+void multi_group_host_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  std::mutex network_simulator_mutex;
+
+  const auto gateway = create_endpoint(0);
+  network_simulator.register_endpoint(gateway);
+
+  synchronizer::MultiGroupHost host(
+      std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+          gateway, network_simulator, network_simulator_mutex),
+      SHARD_COUNT);
+
+  std::vector<uint32_t> group_name_hashes;
+  std::vector<Peer> peers;
+  for (int i = 0; i < GROUP_COUNT; i += 1) {
+    const auto peer_endpoint = create_endpoint(i + 1);
+    network_simulator.register_endpoint(peer_endpoint);
+
+    const auto peer_synchronizer = create_synchronizer("peer", i);
+    peer_synchronizer->set_udp_interface(
+        std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+            peer_endpoint, network_simulator, network_simulator_mutex));
+    peer_synchronizer->init();
+    peer_synchronizer->add_endpoint(gateway);
+    peers.push_back({peer_endpoint, peer_synchronizer});
+
+    // the odd groups only learn about their peer from its synchronization
+    const auto group_synchronizer = create_synchronizer("gateway", i);
+    group_synchronizer->init();
+    if (i % 2 == 0) {
+      group_synchronizer->add_endpoint(peer_endpoint);
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(host.add_group(group_synchronizer),
+                             "group should be added.");
+    group_name_hashes.push_back(group_synchronizer->get_group_name_hash());
+  }
+
+  TEST_ASSERT_EQUAL_MESSAGE(GROUP_COUNT, host.get_group_count(),
+                            "host should host every group.");
+  TEST_ASSERT_EQUAL_MESSAGE(SHARD_COUNT, host.get_shard_count(),
+                            "host should have one task per shard.");
+
+  host.start();
+
+  for (int i = 0; i < GROUP_COUNT; i += 1) {
+    const auto counter = std::make_shared<CounterSynchronizable>();
+    counter->set_value(i + 1);
+    TEST_ASSERT_TRUE_MESSAGE(host.synchronize(group_name_hashes[i], counter),
+                             "synchronize should be accepted.");
+
+    const auto peer_counter = std::make_shared<CounterSynchronizable>();
+    peer_counter->set_value(1000 + i);
+    peers[i].synchronizer->synchronize(peer_counter);
+  }
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  auto next_tick = std::chrono::steady_clock::now();
+  auto has_converged = false;
+
+  while (!has_converged && std::chrono::steady_clock::now() < deadline) {
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto &peer : peers) {
+      if (now >= next_tick) {
+        peer.synchronizer->on_100_ms_passed();
+      }
+      for (int i = 0; i < 4; i += 1) {
+        peer.synchronizer->heartbeat();
+      }
+    }
+    if (now >= next_tick) {
+      next_tick += std::chrono::milliseconds(100);
+    }
+
+    host.apply_remote_updates();
+
+    has_converged = true;
+    for (int i = 0; i < GROUP_COUNT && has_converged; i += 1) {
+      const auto counter =
+          host.get_synchronizable_for_endpoint<CounterSynchronizable>(
+              group_name_hashes[i], peers[i].endpoint, "counter");
+      has_converged =
+          counter.has_value() && counter.value()->get_value() == 1000 + i;
+
+      if (i % 2 == 0 && has_converged) {
+        const auto peer_counter =
+            peers[i]
+                .synchronizer
+                ->get_synchronizable_for_endpoint<CounterSynchronizable>(
+                    gateway, "counter");
+        has_converged = peer_counter.has_value() &&
+                        peer_counter.value()->get_value() == i + 1;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  host.stop();
+
+  TEST_ASSERT_TRUE_MESSAGE(has_converged,
+                           "every group should exchange its values with the "
+                           "plain Synchronizer of the same group.");
+}
+
+void unknown_group_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  std::mutex network_simulator_mutex;
+
+  const auto sender = create_endpoint(0);
+  const auto receiver = create_endpoint(1);
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  synchronizer::MultiGroupHost host(
+      std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+          receiver, network_simulator, network_simulator_mutex),
+      1);
+  const auto group_synchronizer = create_synchronizer("receiver", 0);
+  group_synchronizer->init();
+  host.add_group(group_synchronizer);
+
+  // a synchronization of a group that is not hosted
+  const auto sender_synchronizer = create_synchronizer("sender", 1);
+  sender_synchronizer->set_udp_interface(
+      std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+          sender, network_simulator, network_simulator_mutex));
+  sender_synchronizer->init();
+  sender_synchronizer->add_endpoint(receiver);
+  sender_synchronizer->synchronize(std::make_shared<CounterSynchronizable>());
+
+  {
+    std::lock_guard<std::mutex> lock(network_simulator_mutex);
+    network_simulator.send_packet(sender, receiver, "ab");
+  }
+
+  host.start();
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (host.get_dropped_packet_count() < 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  host.stop();
+
+  TEST_ASSERT_EQUAL_MESSAGE(
+      2, host.get_dropped_packet_count(),
+      "synchronizations of other groups and undecodable packets from unknown "
+      "senders should be dropped.");
+  TEST_ASSERT_FALSE_MESSAGE(group_synchronizer->is_endpoint_known(sender),
+                            "the sender should not be added to the group.");
+}
+
+/**
+ * Drives the peer until the host’s group with the given hash holds the
+ * peer’s counter with the given value, or the deadline passes.
+ */
+bool wait_for_counter(synchronizer::MultiGroupHost &host, const Peer &peer,
+                      const uint32_t group_name_hash, const int value) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  auto next_tick = std::chrono::steady_clock::now();
+
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (std::chrono::steady_clock::now() >= next_tick) {
+      peer.synchronizer->on_100_ms_passed();
+      next_tick += std::chrono::milliseconds(100);
+    }
+    peer.synchronizer->heartbeat();
+
+    host.apply_remote_updates();
+
+    const auto counter =
+        host.get_synchronizable_for_endpoint<CounterSynchronizable>(
+            group_name_hash, peer.endpoint, "counter");
+    if (counter.has_value() && counter.value()->get_value() == value) {
+      return true;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return false;
+}
+
+void group_change_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  std::mutex network_simulator_mutex;
+
+  const auto gateway = create_endpoint(0);
+  const auto peer_endpoint = create_endpoint(1);
+  network_simulator.register_endpoint(gateway);
+  network_simulator.register_endpoint(peer_endpoint);
+
+  synchronizer::MultiGroupHost host(
+      std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+          gateway, network_simulator, network_simulator_mutex),
+      2);
+
+  // the groups give up on the peer after two silent seconds
+  liveness::LivenessOptions group_options;
+  group_options.keepalive_interval = 5;
+  group_options.suspicion_timeout = 10;
+  group_options.dead_timeout = 20;
+
+  std::vector<std::shared_ptr<synchronizer::Synchronizer>> groups;
+  for (int i = 0; i < 2; i += 1) {
+    groups.push_back(create_synchronizer("gateway", i));
+    groups.back()->set_liveness_options(group_options);
+    groups.back()->init();
+    host.add_group(groups.back());
+  }
+
+  liveness::LivenessOptions peer_options;
+  peer_options.keepalive_interval = 5;
+
+  const Peer peer = {peer_endpoint, create_synchronizer("peer", 0)};
+  peer.synchronizer->set_udp_interface(
+      std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+          peer_endpoint, network_simulator, network_simulator_mutex));
+  peer.synchronizer->set_liveness_options(peer_options);
+  peer.synchronizer->init();
+  peer.synchronizer->add_endpoint(gateway);
+
+  host.start();
+
+  const auto counter = std::make_shared<CounterSynchronizable>();
+  counter->set_value(1);
+  peer.synchronizer->synchronize(counter);
+  const auto has_joined_first_group =
+      wait_for_counter(host, peer, groups[0]->get_group_name_hash(), 1);
+
+  // the peer joins the second group, and the first one times it out
+  peer.synchronizer->set_group_name("group_1");
+  peer.synchronizer->add_endpoint(gateway);
+  counter->set_value(2);
+  peer.synchronizer->synchronize(counter);
+  const auto has_joined_second_group =
+      wait_for_counter(host, peer, groups[1]->get_group_name_hash(), 2);
+
+  // once the second group timed the peer out too, its packets are dropped
+  peer.synchronizer->set_group_name("group_2");
+  std::this_thread::sleep_for(std::chrono::seconds(3));
+
+  const auto dropped_packet_count = host.get_dropped_packet_count();
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (host.get_dropped_packet_count() == dropped_packet_count &&
+         std::chrono::steady_clock::now() < deadline) {
+    {
+      std::lock_guard<std::mutex> lock(network_simulator_mutex);
+      network_simulator.send_packet(peer_endpoint, gateway, "\x0f" "ab");
+    }
+    peer.synchronizer->heartbeat();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  const auto has_lost_route =
+      host.get_dropped_packet_count() > dropped_packet_count;
+
+  host.stop();
+
+  TEST_ASSERT_TRUE_MESSAGE(has_joined_first_group,
+                           "the peer should join the first group.");
+  TEST_ASSERT_TRUE_MESSAGE(
+      has_joined_second_group,
+      "the synchronizations of the peer should be routed to its new group.");
+  TEST_ASSERT_FALSE_MESSAGE(
+      groups[0]->is_endpoint_known(peer_endpoint),
+      "the first group should time the peer out once it leaves.");
+  TEST_ASSERT_TRUE_MESSAGE(
+      has_lost_route,
+      "the route of the peer should be dropped once no group knows it.");
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+
+  RUN_TEST(multi_group_host_test);
+  RUN_TEST(unknown_group_test);
+  RUN_TEST(group_change_test);
+
+  return UNITY_END();
+}
@@ -1,8 +1,12 @@
 #include <unity.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <functional>
 #include <queue>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "../utils.h"
 #include "foo.h"
@@ -24,6 +28,20 @@ struct NetworkMessageImpl : public NetworkMessage {
   void on_send_failed() const override {}
 };
 
+struct PriorityMessageImpl : public NetworkMessage {
+  std::string label;
+  MessagePriority priority;
+
+  PriorityMessageImpl(std::string label, MessagePriority priority)
+      : label(label), priority(priority) {}
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return data_object::create_string_value(label);
+  };
+
+  MessagePriority get_priority() const override { return priority; }
+};
+
 struct NetworkHandlerDelegateImpl : public NetworkHandlerDelegate {
  private:
   std::function<void(IncomingDecodedMessage message)> on_message_received_cb;
@@ -48,6 +66,86 @@ struct NetworkHandlerDelegateImpl : public NetworkHandlerDelegate {
                         std::shared_ptr<Codec> codec) const override{};
 };
 
+struct TimeoutRecordingDelegate : public NetworkHandlerDelegate {
+  std::shared_ptr<std::vector<udp_interface::Endpoint>> timed_out_endpoints =
+      std::make_shared<std::vector<udp_interface::Endpoint>>();
+
+  void on_endpoint_timed_out(udp_interface::Endpoint endpoint) const override {
+    timed_out_endpoints->push_back(endpoint);
+  };
+};
+
+/**
+ * Records the fragment indices it sends and drops the fragments whose index is
+ * in drop_once the first time they are sent.
+ */
+struct FragmentDroppingUdpInterface : public utils::UdpInterfaceImpl {
+  std::vector<size_t> sent_fragment_indices;
+  std::set<size_t> drop_once;
+
+  FragmentDroppingUdpInterface(udp_interface::Endpoint& endpoint,
+                               NetworkHandler& network_handler,
+                               utils::NetworkSimulator& network_simulator)
+      : utils::UdpInterfaceImpl(endpoint, network_handler, network_simulator) {}
+
+  bool send_packet(const udp_interface::Endpoint receiver,
+                   const std::string packet) override {
+    if ((uint8_t)packet[0] & 0x40) {
+      const size_t index =
+          ((size_t)(uint8_t)packet[4] << 8) | (uint8_t)packet[5];
+      sent_fragment_indices.push_back(index);
+
+      if (drop_once.erase(index) > 0) {
+        return true;
+      }
+    }
+
+    return utils::UdpInterfaceImpl::send_packet(receiver, packet);
+  }
+};
+
+struct CorruptingUdpInterface : public utils::UdpInterfaceImpl {
+  unsigned int packets_to_corrupt = 0;
+  size_t max_sent_packet_size = 0;
+
+  CorruptingUdpInterface(udp_interface::Endpoint& endpoint,
+                         NetworkHandler& network_handler,
+                         utils::NetworkSimulator& network_simulator)
+      : utils::UdpInterfaceImpl(endpoint, network_handler, network_simulator) {}
+
+  bool send_packet(const udp_interface::Endpoint receiver,
+                   const std::string packet) override {
+    max_sent_packet_size = std::max(max_sent_packet_size, packet.size());
+
+    if (packets_to_corrupt == 0) {
+      return utils::UdpInterfaceImpl::send_packet(receiver, packet);
+    }
+
+    packets_to_corrupt -= 1;
+    auto corrupted_packet = packet;
+    corrupted_packet[1 + std::rand() % (packet.size() - 1)] ^= 0x10;
+
+    return utils::UdpInterfaceImpl::send_packet(receiver, corrupted_packet);
+  }
+};
+
+std::string create_large_string(const size_t size) {
+  std::string result;
+  for (size_t i = 0; i < size; i += 1) {
+    result += (char)('a' + std::rand() % 26);
+  }
+
+  return result;
+}
+
+void deliver_packets(utils::NetworkSimulator& network_simulator,
+                     const udp_interface::Endpoint& endpoint,
+                     NetworkHandler& network_handler) {
+  while (network_simulator.is_incoming_packet_available(endpoint)) {
+    network_handler.heartbeat();
+  }
+}
+
 void basic_network_handler_test() {
   auto network_simulator = utils::NetworkSimulator();
 
@@ -154,11 +252,691 @@ void basic_network_handler_test_with_packet_loss() {
                             "(has_received_ack should be true.)");
 }
 
+void priority_scheduling_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_max_messages_per_decisecond(1);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto received_labels = std::make_shared<std::vector<std::string>>();
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>(
+      [received_labels](IncomingDecodedMessage message) {
+        received_labels->push_back(
+            message.data_object->string_value().value_or(""));
+      });
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  for (int i = 0; i < 4; i += 1) {
+    sender_network_handler.send_message(
+        std::make_shared<PriorityMessageImpl>("low_" + std::to_string(i),
+                                              MessagePriority::LOW),
+        receiver, 100);
+  }
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("normal", MessagePriority::NORMAL),
+      receiver, 100);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("high", MessagePriority::HIGH),
+      receiver, 100);
+
+  for (int i = 0; i < 20; i += 1) {
+    receiver_network_handler.heartbeat();
+    sender_network_handler.heartbeat();
+    sender_network_handler.on_100_ms_passed();
+    receiver_network_handler.on_100_ms_passed();
+  }
+
+  const std::vector<std::string> expected_labels = {
+      "low_0", "high", "normal", "low_1", "low_2", "low_3",
+  };
+
+  TEST_ASSERT_EQUAL_MESSAGE(expected_labels.size(), received_labels->size(),
+                            "priority_scheduling_test (every message should "
+                            "be received exactly once.)");
+
+  for (size_t i = 0; i < expected_labels.size(); i += 1) {
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        expected_labels[i].c_str(), received_labels->at(i).c_str(),
+        "priority_scheduling_test (messages should be received in order of "
+        "priority once the send budget is exhausted.)");
+  }
+}
+
+void fragmentation_test() {
+  std::srand(39u);
+
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<FragmentDroppingUdpInterface>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  // peers of older releases do not understand fragments, so they are opt-in
+  TEST_ASSERT_EQUAL(0, sender_network_handler.get_max_packet_size());
+  sender_network_handler.set_max_packet_size(508);
+  sender_network_handler.set_initial_fragment_window(8);
+  sender_udp_interface->drop_once = {2, 5};
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto received_labels = std::make_shared<std::vector<std::string>>();
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>(
+      [received_labels](IncomingDecodedMessage message) {
+        received_labels->push_back(
+            message.data_object->string_value().value_or(""));
+      });
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  const auto label = create_large_string(3900);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(label, MessagePriority::NORMAL),
+      receiver, 100);
+
+  // 3900 characters plus the envelope take 8 fragments of 500 bytes
+  TEST_ASSERT_EQUAL(8, sender_udp_interface->sent_fragment_indices.size());
+
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  deliver_packets(network_simulator, sender, sender_network_handler);
+  TEST_ASSERT_EQUAL(0, received_labels->size());
+
+  sender_udp_interface->sent_fragment_indices.clear();
+  sender_network_handler.on_100_ms_passed();
+
+  const std::vector<size_t> expected_retries = {2, 5};
+  TEST_ASSERT_TRUE_MESSAGE(
+      sender_udp_interface->sent_fragment_indices == expected_retries,
+      "fragmentation_test (only the lost fragments should be resent.)");
+
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  deliver_packets(network_simulator, sender, sender_network_handler);
+
+  TEST_ASSERT_EQUAL(1, received_labels->size());
+  TEST_ASSERT_TRUE(received_labels->at(0) == label);
+
+  sender_udp_interface->sent_fragment_indices.clear();
+  for (int i = 0; i < 10; i += 1) {
+    sender_network_handler.on_100_ms_passed();
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(
+      0, sender_udp_interface->sent_fragment_indices.size(),
+      "fragmentation_test (the message should be acknowledged.)");
+}
+
+void bounded_reassembly_test() {
+  std::srand(391u);
+
+  auto network_simulator = utils::NetworkSimulator();
+  network_simulator.set_packet_loss_rate(0.2);
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_max_packet_size(508);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+  receiver_network_handler.set_reassembly_limits(1, 2000);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto received_labels = std::make_shared<std::vector<std::string>>();
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>(
+      [received_labels](IncomingDecodedMessage message) {
+        received_labels->push_back(
+            message.data_object->string_value().value_or(""));
+      });
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  const auto too_large_label = create_large_string(3000);
+  const auto first_label = create_large_string(1500);
+  const auto second_label = create_large_string(1500);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(too_large_label,
+                                            MessagePriority::NORMAL),
+      receiver, 20);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(first_label,
+                                            MessagePriority::NORMAL),
+      receiver, 100);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(second_label,
+                                            MessagePriority::NORMAL),
+      receiver, 100);
+
+  for (int i = 0; i < 100; i += 1) {
+    deliver_packets(network_simulator, receiver, receiver_network_handler);
+    deliver_packets(network_simulator, sender, sender_network_handler);
+    sender_network_handler.on_100_ms_passed();
+    receiver_network_handler.on_100_ms_passed();
+  }
+
+  // the messages compete for the single reassembly, but dropped reassemblies
+  // are resent in full, so the ones that fit are eventually received
+  TEST_ASSERT_EQUAL_MESSAGE(2, received_labels->size(),
+                            "bounded_reassembly_test (only the messages that "
+                            "fit the reassembly limits should be received.)");
+  TEST_ASSERT_TRUE(std::find(received_labels->begin(), received_labels->end(),
+                             first_label) != received_labels->end());
+  TEST_ASSERT_TRUE(std::find(received_labels->begin(), received_labels->end(),
+                             second_label) != received_labels->end());
+
+  // the receiver refuses the message that can never fit, so the sender gives
+  // up on it without using up its retries
+  const auto metrics = sender_network_handler.get_metrics();
+  TEST_ASSERT_EQUAL(1, metrics.capacity.refused_messages);
+  TEST_ASSERT_EQUAL(0, metrics.active_message_count);
+}
+
+void windowed_transfer_test() {
+  if (capacity::is_full(24000, capacity::max_reassembly_bytes)) {
+    TEST_IGNORE_MESSAGE("The reassembly capacity is too small.");
+  }
+
+  std::srand(40u);
+
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<FragmentDroppingUdpInterface>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_max_packet_size(508);
+  sender_network_handler.set_max_messages_per_decisecond(4);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+  receiver_network_handler.set_reassembly_limits(1, 24000);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  auto received_labels = std::make_shared<std::vector<std::string>>();
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>(
+      [received_labels](IncomingDecodedMessage message) {
+        received_labels->push_back(
+            message.data_object->string_value().value_or(""));
+      });
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  const auto bulk_label = create_large_string(20000);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(bulk_label, MessagePriority::LOW),
+      receiver, 100);
+
+  TEST_ASSERT_EQUAL_MESSAGE(
+      4, sender_udp_interface->sent_fragment_indices.size(),
+      "windowed_transfer_test (only the initial window should be sent.)");
+
+  // the bulk transfer saturates the send budget, but a realtime message queued
+  // in between is sent first in the next 100 ms period
+  size_t realtime_messages_sent = 0;
+  for (int i = 0; i < 30; i += 1) {
+    const auto received_count = received_labels->size();
+
+    sender_network_handler.send_message(
+        std::make_shared<PriorityMessageImpl>(
+            "realtime_" + std::to_string(i), MessagePriority::HIGH),
+        receiver, 100);
+    realtime_messages_sent += 1;
+
+    sender_udp_interface->sent_fragment_indices.clear();
+    sender_network_handler.on_100_ms_passed();
+    receiver_network_handler.on_100_ms_passed();
+
+    for (int j = 0; j < 10; j += 1) {
+      deliver_packets(network_simulator, receiver, receiver_network_handler);
+      deliver_packets(network_simulator, sender, sender_network_handler);
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(
+        sender_udp_interface->sent_fragment_indices.size() <= 3,
+        "windowed_transfer_test (fragments should share the send budget.)");
+    TEST_ASSERT_TRUE_MESSAGE(
+        std::find(received_labels->begin() + received_count,
+                  received_labels->end(),
+                  "realtime_" + std::to_string(i)) != received_labels->end(),
+        "windowed_transfer_test (realtime messages should not wait for the "
+        "bulk transfer.)");
+  }
+
+  TEST_ASSERT_EQUAL(realtime_messages_sent + 1, received_labels->size());
+  TEST_ASSERT_TRUE(std::find(received_labels->begin(), received_labels->end(),
+                             bulk_label) != received_labels->end());
+}
+
+void large_object_transfer_test() {
+  if (capacity::is_full(65536, capacity::max_reassembly_bytes)) {
+    TEST_IGNORE_MESSAGE("The reassembly capacity is too small.");
+  }
+
+  std::srand(47u);
+
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<FragmentDroppingUdpInterface>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_max_packet_size(508);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+  // objects of tens of KiB exceed the default reassembly limit
+  receiver_network_handler.set_reassembly_limits(4, 65536);
+
+  auto silent_receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(2), 2);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+  network_simulator.register_endpoint(silent_receiver);
+
+  auto received_labels = std::make_shared<std::vector<std::string>>();
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>(
+      [received_labels](IncomingDecodedMessage message) {
+        received_labels->push_back(
+            message.data_object->string_value().value_or(""));
+      });
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  const auto bulk_label = create_large_string(40000);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(bulk_label, MessagePriority::LOW),
+      receiver, 100);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("realtime", MessagePriority::HIGH),
+      silent_receiver, 100);
+
+  // while the realtime message is queued, acknowledged fragments do not
+  // release the next ones before the next 100 ms period
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  deliver_packets(network_simulator, sender, sender_network_handler);
+  TEST_ASSERT_EQUAL_MESSAGE(
+      4, sender_udp_interface->sent_fragment_indices.size(),
+      "large_object_transfer_test (fragments should wait for messages of a "
+      "higher priority.)");
+
+  for (int i = 0; i < 20 && received_labels->empty(); i += 1) {
+    sender_network_handler.on_100_ms_passed();
+    receiver_network_handler.on_100_ms_passed();
+
+    deliver_packets(network_simulator, receiver, receiver_network_handler);
+    deliver_packets(network_simulator, sender, sender_network_handler);
+  }
+
+  // objects of tens of KiB fit the raised reassembly limit
+  TEST_ASSERT_EQUAL(1, received_labels->size());
+  TEST_ASSERT_TRUE(received_labels->at(0) == bulk_label);
+  TEST_ASSERT_EQUAL(
+      0, sender_network_handler.get_metrics().capacity.refused_messages);
+}
+
+void fragment_count_limit_test() {
+  std::srand(39u);
+
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<FragmentDroppingUdpInterface>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_max_packet_size(64);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  // 65535 fragments of 56 bytes cannot hold this label
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(create_large_string(65535 * 56),
+                                            MessagePriority::NORMAL),
+      receiver, 100);
+
+  const auto& metrics = sender_network_handler.get_metrics();
+  TEST_ASSERT_EQUAL(0, sender_udp_interface->sent_fragment_indices.size());
+  TEST_ASSERT_EQUAL(0, metrics.active_message_count);
+  TEST_ASSERT_EQUAL(1, metrics.capacity.refused_messages);
+
+  // smaller messages are still sent
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(create_large_string(1000),
+                                            MessagePriority::NORMAL),
+      receiver, 100);
+  TEST_ASSERT_EQUAL(
+      1, sender_network_handler.get_metrics().active_message_count);
+  TEST_ASSERT_TRUE(sender_udp_interface->sent_fragment_indices.size() > 0);
+}
+
+void checksum_test() {
+  std::srand(43u);
+
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<CorruptingUdpInterface>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+  sender_network_handler.set_checksums_enabled(true);
+  sender_network_handler.set_max_packet_size(508);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+  receiver_network_handler.set_checksums_enabled(true);
+
+  auto unchecked_sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(2), 2);
+  auto unchecked_network_handler = NetworkHandler();
+  auto unchecked_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      unchecked_sender, unchecked_network_handler, network_simulator);
+  unchecked_network_handler.set_udp_interface(unchecked_udp_interface);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+  network_simulator.register_endpoint(unchecked_sender);
+
+  auto received_labels = std::make_shared<std::vector<std::string>>();
+  auto receiver_delegate = std::make_shared<NetworkHandlerDelegateImpl>(
+      [received_labels](IncomingDecodedMessage message) {
+        received_labels->push_back(
+            message.data_object->string_value().value_or(""));
+      });
+  receiver_network_handler.set_delegate(receiver_delegate);
+
+  const auto& counts = receiver_network_handler.get_packet_rejection_counts();
+
+  // a corrupted packet is dropped and its retry is delivered
+  sender_udp_interface->packets_to_corrupt = 1;
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("small", MessagePriority::NORMAL),
+      receiver, 100);
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  TEST_ASSERT_EQUAL(0, received_labels->size());
+  TEST_ASSERT_EQUAL(1, counts.checksum_mismatches);
+
+  sender_network_handler.on_100_ms_passed();
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  deliver_packets(network_simulator, sender, sender_network_handler);
+  TEST_ASSERT_EQUAL(1, received_labels->size());
+  TEST_ASSERT_TRUE(received_labels->at(0) == "small");
+
+  // each fragment is checked, and stays within the max packet size
+  const auto label = create_large_string(2000);
+  sender_udp_interface->packets_to_corrupt = 2;
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>(label, MessagePriority::NORMAL),
+      receiver, 100);
+  for (int i = 0; i < 5 && received_labels->size() < 2; i += 1) {
+    deliver_packets(network_simulator, receiver, receiver_network_handler);
+    deliver_packets(network_simulator, sender, sender_network_handler);
+    sender_network_handler.on_100_ms_passed();
+  }
+  TEST_ASSERT_EQUAL(2, received_labels->size());
+  TEST_ASSERT_TRUE(received_labels->at(1) == label);
+  TEST_ASSERT_EQUAL(3, counts.checksum_mismatches);
+  TEST_ASSERT_TRUE(sender_udp_interface->max_sent_packet_size <= 508);
+
+  // packets without a checksum are rejected while checksums are enabled
+  unchecked_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("unchecked",
+                                            MessagePriority::NORMAL),
+      receiver, 100);
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  TEST_ASSERT_EQUAL(2, received_labels->size());
+  TEST_ASSERT_EQUAL(1, counts.missing_checksums);
+  TEST_ASSERT_EQUAL(0, counts.decode_failures);
+  TEST_ASSERT_EQUAL(0, counts.unknown_formats);
+}
+
+void metrics_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  auto sender_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      sender, sender_network_handler, network_simulator);
+  sender_network_handler.set_udp_interface(sender_udp_interface);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  auto receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_network_handler.set_udp_interface(receiver_udp_interface);
+
+  auto stranger =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(2), 2);
+  auto stranger_network_handler = NetworkHandler();
+  auto stranger_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      stranger, stranger_network_handler, network_simulator);
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+  network_simulator.register_endpoint(stranger);
+
+  sender_network_handler.track_peer(receiver);
+  receiver_network_handler.track_peer(sender);
+
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("label", MessagePriority::NORMAL),
+      receiver, 100);
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+
+  // the ack is lost, so the message is sent again and dropped as a duplicate
+  network_simulator.register_endpoint(sender);
+  sender_network_handler.on_100_ms_passed();
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  deliver_packets(network_simulator, sender, sender_network_handler);
+
+  const auto& sender_metrics = sender_network_handler.get_metrics();
+  const auto& to_receiver = sender_metrics.endpoints.at(receiver);
+  TEST_ASSERT_EQUAL(2, to_receiver.packets_sent);
+  TEST_ASSERT_EQUAL(1, to_receiver.retransmissions);
+  TEST_ASSERT_EQUAL(1, to_receiver.packets_received);
+  TEST_ASSERT_EQUAL(1, sender_metrics.ack_latencies.get_count());
+  TEST_ASSERT_EQUAL(1, sender_metrics.ack_latencies.buckets[1]);
+  TEST_ASSERT_EQUAL(0, sender_metrics.active_message_count);
+  TEST_ASSERT_EQUAL(1, sender_metrics.max_active_message_count);
+
+  const auto& receiver_metrics = receiver_network_handler.get_metrics();
+  const auto& from_sender = receiver_metrics.endpoints.at(sender);
+  TEST_ASSERT_EQUAL(2, from_sender.packets_received);
+  TEST_ASSERT_EQUAL(to_receiver.bytes_sent, from_sender.bytes_received);
+  TEST_ASSERT_EQUAL(1, from_sender.duplicates_dropped);
+  TEST_ASSERT_EQUAL(2, from_sender.packets_sent);
+  TEST_ASSERT_EQUAL(0, receiver_metrics.rejections.decode_failures);
+
+  // packets from endpoints that are not tracked share a single entry
+  stranger_udp_interface->send_packet(receiver, "\x0f" "ab");
+  deliver_packets(network_simulator, receiver, receiver_network_handler);
+  TEST_ASSERT_EQUAL(1, receiver_metrics.endpoints.size());
+  TEST_ASSERT_EQUAL(1, receiver_metrics.untracked_endpoints.packets_received);
+  TEST_ASSERT_EQUAL(1, receiver_metrics.rejections.unknown_formats);
+
+  receiver_network_handler.reset_metrics();
+  TEST_ASSERT_EQUAL(1, receiver_metrics.endpoints.size());
+  TEST_ASSERT_EQUAL(0, receiver_metrics.endpoints.at(sender).packets_received);
+
+  receiver_network_handler.untrack_peer(sender);
+  TEST_ASSERT_EQUAL(0, receiver_metrics.endpoints.size());
+
+  // latencies fall into buckets whose bounds double
+  AckLatencyHistogram histogram;
+  for (const uint32_t latency : {0u, 1u, 2u, 3u, 4u, 5u, 32u, 33u, 900u}) {
+    histogram.record(latency);
+  }
+  const uint32_t expected_buckets[] = {1, 1, 1, 2, 1, 0, 1, 2};
+  TEST_ASSERT_EQUAL_UINT32_ARRAY(expected_buckets, histogram.buckets,
+                                 AckLatencyHistogram::bucket_count);
+}
+
+void liveness_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_network_handler = NetworkHandler();
+  sender_network_handler.set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(sender, sender_network_handler,
+                                                network_simulator));
+  const auto delegate = std::make_shared<TimeoutRecordingDelegate>();
+  sender_network_handler.set_delegate(delegate);
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_network_handler = NetworkHandler();
+  receiver_network_handler.set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          receiver, receiver_network_handler, network_simulator));
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  // liveness is only monitored if asked to, since older releases never send
+  // keepalives
+  const auto default_options = sender_network_handler.get_liveness_options();
+  TEST_ASSERT_EQUAL(0, default_options.keepalive_interval);
+  TEST_ASSERT_EQUAL(0, default_options.suspicion_timeout);
+  TEST_ASSERT_EQUAL(0, default_options.dead_timeout);
+
+  liveness::LivenessOptions options;
+  options.keepalive_interval = 10;
+  options.suspicion_timeout = 30;
+  options.dead_timeout = 100;
+  sender_network_handler.set_liveness_options(options);
+  receiver_network_handler.set_liveness_options(options);
+
+  sender_network_handler.track_peer(receiver);
+  receiver_network_handler.track_peer(sender);
+
+  const auto run_deciseconds = [&](const int count) {
+    for (int i = 0; i < count; i += 1) {
+      sender_network_handler.on_100_ms_passed();
+      receiver_network_handler.on_100_ms_passed();
+      deliver_packets(network_simulator, receiver, receiver_network_handler);
+      deliver_packets(network_simulator, sender, sender_network_handler);
+    }
+  };
+  const auto get_sender_state = [&]() {
+    return sender_network_handler.get_peer_liveness(receiver).value().state;
+  };
+
+  // idle peers keep each other alive with keepalives
+  run_deciseconds(50);
+  TEST_ASSERT_TRUE(get_sender_state() == liveness::PeerState::ALIVE);
+  const auto keepalives_sent =
+      sender_network_handler.get_metrics().liveness.keepalives_sent;
+  TEST_ASSERT_TRUE(keepalives_sent >= 4 && keepalives_sent <= 5);
+
+  // a silent peer is suspected and its messages are not retransmitted
+  network_simulator.set_packet_loss_rate(1.0);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("label", MessagePriority::NORMAL),
+      receiver, 100);
+  run_deciseconds(40);
+  TEST_ASSERT_TRUE(get_sender_state() == liveness::PeerState::SUSPECTED);
+
+  const auto metrics_before = sender_network_handler.get_metrics();
+  run_deciseconds(20);
+  const auto metrics_after = sender_network_handler.get_metrics();
+  TEST_ASSERT_EQUAL(metrics_after.liveness.keepalives_sent -
+                        metrics_before.liveness.keepalives_sent,
+                    metrics_after.endpoints.at(receiver).packets_sent -
+                        metrics_before.endpoints.at(receiver).packets_sent);
+  TEST_ASSERT_EQUAL(1, metrics_after.active_message_count);
+
+  // any packet from the peer resumes the retransmissions
+  network_simulator.set_packet_loss_rate(0.0);
+  run_deciseconds(15);
+  TEST_ASSERT_TRUE(get_sender_state() == liveness::PeerState::ALIVE);
+  TEST_ASSERT_EQUAL(0,
+                    sender_network_handler.get_metrics().active_message_count);
+
+  // a peer that stays silent times out, failing its messages
+  network_simulator.set_packet_loss_rate(1.0);
+  sender_network_handler.send_message(
+      std::make_shared<PriorityMessageImpl>("label", MessagePriority::NORMAL),
+      receiver, 1000);
+  run_deciseconds(100);
+  TEST_ASSERT_FALSE(
+      sender_network_handler.get_peer_liveness(receiver).has_value());
+  TEST_ASSERT_EQUAL(1, delegate->timed_out_endpoints->size());
+  TEST_ASSERT_TRUE(delegate->timed_out_endpoints->at(0) == receiver);
+
+  const auto metrics = sender_network_handler.get_metrics();
+  TEST_ASSERT_EQUAL(0, metrics.active_message_count);
+  TEST_ASSERT_EQUAL(2, metrics.liveness.suspected_peers);
+  TEST_ASSERT_EQUAL(1, metrics.liveness.timed_out_peers);
+}
+
 int main(int argc, char** argv) {
   UNITY_BEGIN();
 
   RUN_TEST(basic_network_handler_test);
   RUN_TEST(basic_network_handler_test_with_packet_loss);
+  RUN_TEST(priority_scheduling_test);
+  RUN_TEST(fragmentation_test);
+  RUN_TEST(bounded_reassembly_test);
+  RUN_TEST(windowed_transfer_test);
+  RUN_TEST(large_object_transfer_test);
+  RUN_TEST(fragment_count_limit_test);
+  RUN_TEST(checksum_test);
+  RUN_TEST(metrics_test);
+  RUN_TEST(liveness_test);
 
   return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include <unity.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../simulation_utils.h"
+#include "../utils.h"
+#include "foo.h"
+
+/**
+ * Counts how many synchronizables of all nodes hold the expected value.
+ */
+struct ConvergenceCounter {
+  int expected_value = 0;
+  size_t converged_count = 0;
+};
+
+struct SynchronizableMock : public Synchronizable {
+ private:
+  int integer = 0;
+  std::shared_ptr<ConvergenceCounter> counter;
+
+ public:
+  SynchronizableMock(const std::shared_ptr<ConvergenceCounter> counter)
+      : counter(counter) {}
+
+  int get_integer() const { return integer; }
+
+  void set_integer(const int value) { integer = value; }
+
+  std::string get_name() const { return "SynchronizableMock"; };
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const {
+    return data_object::create_number_value(integer);
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) {
+    if (!data_object->is_number()) {
+      return false;
+    }
+
+    const auto new_integer = (int)data_object->number_value().value();
+    if (new_integer == counter->expected_value &&
+        integer != counter->expected_value) {
+      counter->converged_count += 1;
+    }
+    integer = new_integer;
+
+    return true;
+  }
+};
+
+struct DelegateImpl : public synchronizer::SynchronizerDelegate {
+  std::shared_ptr<ConvergenceCounter> counter;
+
+  DelegateImpl(const std::shared_ptr<ConvergenceCounter> counter)
+      : counter(counter) {}
+
+  std::vector<std::shared_ptr<Synchronizable>>
+  create_initial_synchronizables_container() override {
+    return {
+        std::make_shared<SynchronizableMock>(counter),
+    };
+  }
+};
+
+udp_interface::Endpoint create_endpoint(const unsigned int index) {
+  return udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(index),
+                                 (uint16_t)index);
+}
+
+/**
+ * Creates a group of fully connected nodes that count their converged
+ * synchronizables with the given counter.
+ */
+void add_nodes(simulation_utils::SimulatedGroup &group,
+               const unsigned int node_count,
+               const std::shared_ptr<ConvergenceCounter> counter) {
+  for (unsigned int i = 0; i < node_count; i += 1) {
+    auto node = synchronizer::Synchronizer::create("node");
+    node->set_delegate(std::make_shared<DelegateImpl>(counter));
+    group.add_node(create_endpoint(i), node);
+  }
+
+  group.connect_all_nodes();
+}
+
+struct ScenarioResult {
+  tl::optional<simulation_utils::Time> convergence_time;
+  simulation_utils::SimulationStatistics statistics;
+};
+
+/**
+ * Lets every node of a group publish the same value at a random time within
+ * the first 100 ms and runs the simulation until every node has received the
+ * value from every other node.
+ */
+ScenarioResult run_all_to_all_scenario(
+    const uint32_t seed, const unsigned int node_count,
+    const simulation_utils::LinkProperties link_properties) {
+  simulation_utils::NetworkSimulation network_simulation(seed);
+  network_simulation.set_default_link_properties(link_properties);
+  simulation_utils::SimulatedGroup group(network_simulation);
+
+  auto counter = std::make_shared<ConvergenceCounter>();
+  counter->expected_value = 42;
+  add_nodes(group, node_count, counter);
+
+  for (const auto &endpoint : group.get_endpoints()) {
+    const auto node = group.get_node(endpoint);
+    network_simulation.schedule(
+        network_simulation.random_integer(
+            simulation_utils::microseconds_per_decisecond),
+        [node, counter]() {
+          auto synchronizable = std::make_shared<SynchronizableMock>(counter);
+          synchronizable->set_integer(42);
+          node->synchronize(synchronizable);
+        });
+  }
+
+  const size_t pair_count = (size_t)node_count * (node_count - 1);
+  ScenarioResult result;
+  result.convergence_time = group.run_until(
+      [&]() { return counter->converged_count == pair_count; },
+      60 * 1000000);
+  result.statistics = network_simulation.get_statistics();
+
+  return result;
+}
+
+void link_properties_test() {
+  simulation_utils::NetworkSimulation network_simulation(1);
+  const auto sender = create_endpoint(0);
+  const auto receiver = create_endpoint(1);
+  network_simulation.register_endpoint(sender);
+  network_simulation.register_endpoint(receiver);
+
+  simulation_utils::LinkProperties properties;
+  properties.latency = 5000;
+  properties.bytes_per_second = 100000;
+  network_simulation.set_link_properties(sender, receiver, properties);
+
+  std::vector<simulation_utils::Time> arrival_times;
+  network_simulation.set_delivery_handler(
+      [&](const udp_interface::Endpoint endpoint) {
+        if (endpoint == receiver) {
+          arrival_times.push_back(network_simulation.get_time());
+        }
+      });
+
+  // each packet takes 10 ms to transmit, the second waits for the first
+  network_simulation.send_packet(sender, receiver, std::string(1000, 'a'));
+  network_simulation.send_packet(sender, receiver, std::string(1000, 'b'));
+  // the reverse link uses the default properties
+  network_simulation.send_packet(receiver, sender, "c");
+
+  network_simulation.run_until(14999);
+  TEST_ASSERT_EQUAL(0, arrival_times.size());
+  TEST_ASSERT_TRUE(network_simulation.is_incoming_packet_available(sender));
+
+  network_simulation.run_until(1000000);
+  TEST_ASSERT_EQUAL(2, arrival_times.size());
+  TEST_ASSERT_TRUE(arrival_times[0] == 15000);
+  TEST_ASSERT_TRUE(arrival_times[1] == 25000);
+  TEST_ASSERT_EQUAL('a', network_simulation.receive_packet(receiver)->data[0]);
+  TEST_ASSERT_EQUAL('b', network_simulation.receive_packet(receiver)->data[0]);
+
+  // jitter and reordering let packets overtake each other
+  properties = simulation_utils::LinkProperties();
+  properties.jitter = 2000;
+  properties.reordering_rate = 0.2;
+  network_simulation.set_link_properties(sender, receiver, properties);
+  for (int i = 0; i < 100; i += 1) {
+    network_simulation.send_packet(sender, receiver, std::to_string(i));
+  }
+  network_simulation.run_until(2000000);
+
+  int out_of_order_count = 0;
+  int previous = -1;
+  while (network_simulation.is_incoming_packet_available(receiver)) {
+    const auto value =
+        std::stoi(network_simulation.receive_packet(receiver)->data);
+    out_of_order_count += value < previous;
+    previous = value;
+  }
+  TEST_ASSERT_TRUE(out_of_order_count > 0);
+  TEST_ASSERT_TRUE(network_simulation.get_statistics().packets_reordered > 0);
+
+  // a lossy link drops packets
+  properties = simulation_utils::LinkProperties();
+  properties.packet_loss_rate = 1.0;
+  network_simulation.set_link_properties(sender, receiver, properties);
+  network_simulation.send_packet(sender, receiver, "lost");
+  network_simulation.run_until(3000000);
+  TEST_ASSERT_FALSE(network_simulation.is_incoming_packet_available(receiver));
+  TEST_ASSERT_TRUE(network_simulation.get_statistics().packets_lost == 1);
+}
+
+void determinism_test() {
+  simulation_utils::LinkProperties properties;
+  properties.latency = 3000;
+  properties.jitter = 4000;
+  properties.packet_loss_rate = 0.2;
+  properties.reordering_rate = 0.1;
+
+  const auto first = run_all_to_all_scenario(7, 8, properties);
+  const auto second = run_all_to_all_scenario(7, 8, properties);
+
+  TEST_ASSERT_TRUE(first.convergence_time.has_value());
+  TEST_ASSERT_TRUE(second.convergence_time.has_value());
+  TEST_ASSERT_TRUE(first.convergence_time.value() ==
+                   second.convergence_time.value());
+  TEST_ASSERT_TRUE(first.statistics.packets_sent ==
+                   second.statistics.packets_sent);
+  TEST_ASSERT_TRUE(first.statistics.bytes_sent == second.statistics.bytes_sent);
+  TEST_ASSERT_TRUE(first.statistics.packets_lost ==
+                   second.statistics.packets_lost);
+  TEST_ASSERT_TRUE(first.statistics.packets_lost > 0);
+}
+
+void partition_test() {
+  simulation_utils::NetworkSimulation network_simulation(3);
+  simulation_utils::SimulatedGroup group(network_simulation);
+
+  auto counter = std::make_shared<ConvergenceCounter>();
+  counter->expected_value = 7;
+  add_nodes(group, 4, counter);
+
+  const auto &endpoints = group.get_endpoints();
+  network_simulation.partition(
+      {{endpoints[0], endpoints[1]}, {endpoints[2], endpoints[3]}});
+
+  auto synchronizable = std::make_shared<SynchronizableMock>(counter);
+  synchronizable->set_integer(7);
+  group.get_node(endpoints[0])->synchronize(synchronizable);
+
+  // only the node in the same partition receives the value
+  const auto never = group.run_until([]() { return false; }, 1000000);
+  TEST_ASSERT_FALSE(never.has_value());
+  TEST_ASSERT_EQUAL(1, counter->converged_count);
+  TEST_ASSERT_TRUE(network_simulation.get_statistics().packets_partitioned > 0);
+
+  // the messages are still being retried, so they arrive after healing
+  network_simulation.heal_partition();
+  const auto convergence_time =
+      group.run_until([&]() { return counter->converged_count == 3; }, 1000000);
+  TEST_ASSERT_TRUE(convergence_time.has_value());
+}
+
+/**
+ * Runs the all-to-all scenario over a lossy link for each of the given group
+ * sizes and prints how the cost grows. In bounded mode, groups with more
+ * peers per node than fit are skipped.
+ */
+void run_scaling_scenarios(const std::vector<unsigned int> &node_counts) {
+  simulation_utils::LinkProperties properties;
+  properties.latency = 2000;
+  properties.jitter = 3000;
+  properties.packet_loss_rate = 0.05;
+  properties.bytes_per_second = 1000000;
+
+  for (const auto node_count : node_counts) {
+    if (capacity::is_bounded && node_count - 1 > capacity::max_peers) {
+      TEST_PRINTF("%u nodes: skipped, more peers than fit\n", node_count);
+      continue;
+    }
+
+    const auto result = run_all_to_all_scenario(11, node_count, properties);
+
+    TEST_ASSERT_TRUE_MESSAGE(result.convergence_time.has_value(),
+                             std::to_string(node_count).c_str());
+
+    const auto &statistics = result.statistics;
+    TEST_PRINTF(
+        "%u nodes: converged after %u ms, %u packets (%.1f per node pair), "
+        "%u KiB sent\n",
+        node_count, (unsigned int)(result.convergence_time.value() / 1000),
+        (unsigned int)statistics.packets_sent,
+        (double)statistics.packets_sent / node_count / (node_count - 1),
+        (unsigned int)(statistics.bytes_sent / 1024));
+  }
+}
+
+void scaling_test() { run_scaling_scenarios({2, 10, 25}); }
+
+#ifdef BENCHMARK
+/**
+ * Sweeps up to 500 nodes, which takes a while, so it only runs in the
+ * native_benchmark environment.
+ */
+void scaling_benchmark_test() {
+  run_scaling_scenarios({2, 10, 50, 100, 250, 500});
+}
+#endif
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(link_properties_test);
+  RUN_TEST(determinism_test);
+  RUN_TEST(partition_test);
+  RUN_TEST(scaling_test);
+#ifdef BENCHMARK
+  RUN_TEST(scaling_benchmark_test);
+#endif
+  return UNITY_END();
+}
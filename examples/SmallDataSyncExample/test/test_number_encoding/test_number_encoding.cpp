@@ -0,0 +1,184 @@
+#include <unity.h>
+
+#include <cstdlib>
+#include <limits>
+#include <memory>
+
+#include "../utils.h"
+#include "foo.h"
+
+using namespace data_object;
+
+struct WeatherReading : public TypedSynchronizable<WeatherReading> {
+  float temperature = 0;
+  FixedPoint<100> humidity;
+  FixedPoint<10> pressure;
+
+  std::string get_name() const override { return "weather_reading"; }
+
+  SMALL_DATA_SYNC_FIELDS(temperature, humidity, pressure)
+};
+
+std::string encode_with(const NumberEncoding number_encoding,
+                        const std::shared_ptr<GenericValue> value) {
+  auto options = CodecOptions();
+  options.number_encoding = number_encoding;
+
+  return MsgPackCodec(options).encode(value);
+}
+
+std::shared_ptr<GenericValue> decode_msgpack(const std::string& encoding) {
+  std::string error_string;
+  const auto decoded = MsgPackCodec().decode(encoding, error_string);
+  TEST_ASSERT_TRUE_MESSAGE(decoded.has_value(), "decoding should succeed.");
+
+  return decoded.value();
+}
+
+void float32_value_test() {
+  const auto value = create_float32_value(21.37f);
+
+  const auto msgpack_encoding = MsgPackCodec().encode(value);
+  TEST_ASSERT_EQUAL(5, msgpack_encoding.size());
+  TEST_ASSERT_EQUAL_UINT8(0xca, (uint8_t)msgpack_encoding[0]);
+
+  const auto decoded = decode_msgpack(msgpack_encoding);
+  TEST_ASSERT_TRUE((float)decoded->number_value().value() == 21.37f);
+  TEST_ASSERT_TRUE(decoded->equals(value));
+
+  TEST_ASSERT_EQUAL_STRING("21.37", JsonCodec().encode(value).c_str());
+}
+
+void compact_number_encoding_test() {
+  // whole numbers become integers, float32-exact numbers become float32, and
+  // all others stay float64
+  TEST_ASSERT_EQUAL(
+      1, encode_with(NumberEncoding::COMPACT, create_number_value(3)).size());
+  TEST_ASSERT_EQUAL(
+      3, encode_with(NumberEncoding::COMPACT, create_number_value(-1000))
+             .size());
+  TEST_ASSERT_EQUAL(
+      5, encode_with(NumberEncoding::COMPACT, create_number_value(0.5)).size());
+  TEST_ASSERT_EQUAL(
+      9, encode_with(NumberEncoding::COMPACT, create_number_value(0.1)).size());
+  // -0.0 is not written as the integer 0, which would lose its sign
+  TEST_ASSERT_EQUAL(
+      5,
+      encode_with(NumberEncoding::COMPACT, create_number_value(-0.0)).size());
+
+  TEST_ASSERT_EQUAL(
+      9, encode_with(NumberEncoding::FLOAT64, create_number_value(3)).size());
+
+  const auto lossy_encoding =
+      encode_with(NumberEncoding::FLOAT32, create_number_value(0.1));
+  TEST_ASSERT_EQUAL(5, lossy_encoding.size());
+  TEST_ASSERT_TRUE(decode_msgpack(lossy_encoding)->number_value().value() ==
+                   (double)0.1f);
+}
+
+void fixed_point_field_test() {
+  auto reading = WeatherReading();
+  reading.temperature = 21.5f;
+  reading.humidity = 48.27;
+  reading.pressure = 1013.2;
+
+  const auto data_object = reading.to_data_object();
+  const auto humidity = (*data_object)["humidity"];
+  TEST_ASSERT_TRUE(humidity.has_value());
+  TEST_ASSERT_TRUE(humidity.value()->is_integer());
+  TEST_ASSERT_EQUAL(4827, humidity.value()->int_value().value());
+
+  const auto decoded = decode_msgpack(MsgPackCodec().encode(data_object));
+
+  auto received_reading = WeatherReading();
+  TEST_ASSERT_TRUE(received_reading.apply_from_data_object(decoded));
+  TEST_ASSERT_TRUE(received_reading.temperature == 21.5f);
+  TEST_ASSERT_TRUE(std::abs(received_reading.humidity - 48.27) < 1e-9);
+  TEST_ASSERT_TRUE(std::abs(received_reading.pressure - 1013.2) < 1e-9);
+}
+
+void fixed_point_range_test() {
+  auto reading = WeatherReading();
+  reading.humidity = std::numeric_limits<double>::quiet_NaN();
+  reading.pressure = 1e30;
+
+  // values that cannot be scaled into an int64 are sent as null
+  const auto data_object = reading.to_data_object();
+  TEST_ASSERT_TRUE((*data_object)["humidity"].value()->is_null());
+  TEST_ASSERT_TRUE((*data_object)["pressure"].value()->is_null());
+
+  auto received_reading = WeatherReading();
+  received_reading.humidity = 48.27;
+  TEST_ASSERT_FALSE(received_reading.apply_from_data_object(data_object));
+
+  const auto infinity = std::numeric_limits<double>::infinity();
+  const std::shared_ptr<GenericValue> invalid_values[] = {
+      create_object({{"humidity", create_number_value(infinity)}}),
+      create_object({{"humidity", create_number_value(1e300)}}),
+  };
+
+  for (const auto& invalid_value : invalid_values) {
+    TEST_ASSERT_FALSE(received_reading.apply_from_data_object(invalid_value));
+  }
+  TEST_ASSERT_TRUE(received_reading.humidity == 48.27);
+}
+
+void number_encoding_size_benchmark_test() {
+  std::srand(36);
+
+  size_t float64_size = 0;
+  size_t compact_size = 0;
+  size_t float32_size = 0;
+
+  for (int i = 0; i < 200; i += 1) {
+    const auto value = utils::generate_random_data_object(4);
+
+    const auto float64_encoding = encode_with(NumberEncoding::FLOAT64, value);
+    const auto compact_encoding = encode_with(NumberEncoding::COMPACT, value);
+    const auto float32_encoding = encode_with(NumberEncoding::FLOAT32, value);
+
+    TEST_ASSERT_TRUE_MESSAGE(decode_msgpack(compact_encoding)->equals(value),
+                             "compact encoding should be lossless.");
+
+    float64_size += float64_encoding.size();
+    compact_size += compact_encoding.size();
+    float32_size += float32_encoding.size();
+  }
+
+  TEST_PRINTF("random trees: float64 %u B, compact %u B, float32 %u B\n",
+              (unsigned int)float64_size, (unsigned int)compact_size,
+              (unsigned int)float32_size);
+
+  TEST_ASSERT_TRUE(compact_size <= float64_size);
+  TEST_ASSERT_TRUE(float32_size < compact_size);
+
+  auto reading = WeatherReading();
+  reading.temperature = 21.5f;
+  reading.humidity = 48.27;
+  reading.pressure = 1013.2;
+
+  auto plain_reading = create_object({
+      {"temperature", create_number_value(21.5)},
+      {"humidity", create_number_value(48.27)},
+      {"pressure", create_number_value(1013.2)},
+  });
+
+  const auto typed_size = MsgPackCodec().encode(reading.to_data_object()).size();
+  const auto plain_size = MsgPackCodec().encode(plain_reading).size();
+
+  TEST_PRINTF("weather reading: float64 %u B, float32 + fixed-point %u B\n",
+              (unsigned int)plain_size, (unsigned int)typed_size);
+
+  // 4 + 2 + 1 bytes saved on the three numbers
+  TEST_ASSERT_EQUAL(plain_size - 4 - 6 - 6, typed_size);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(float32_value_test);
+  RUN_TEST(compact_number_encoding_test);
+  RUN_TEST(fixed_point_field_test);
+  RUN_TEST(fixed_point_range_test);
+  RUN_TEST(number_encoding_size_benchmark_test);
+  UNITY_END();
+}
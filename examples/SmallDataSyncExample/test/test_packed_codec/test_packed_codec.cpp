@@ -0,0 +1,168 @@
+#include <unity.h>
+
+#include <limits>
+#include <memory>
+
+#include "../utils.h"
+#include "foo.h"
+
+using namespace data_object;
+
+struct SensorFrame : public TypedSynchronizable<SensorFrame> {
+  float temperature = 0;
+  float humidity = 0;
+  uint16_t battery_millivolts = 0;
+  int16_t rssi = 0;
+  bool is_charging = false;
+  uint32_t sequence = 0;
+
+  std::string get_name() const override { return "sensor_frame"; }
+
+  SMALL_DATA_SYNC_FIELDS(temperature, humidity, battery_millivolts, rssi,
+                         is_charging, sequence)
+};
+
+struct RenamedSensorFrame : public TypedSynchronizable<RenamedSensorFrame> {
+  float temperature = 0;
+  float humidity = 0;
+  uint16_t battery_millivolts = 0;
+  int16_t rssi = 0;
+  bool is_charging = false;
+  uint32_t counter = 0;
+
+  std::string get_name() const override { return "sensor_frame"; }
+
+  SMALL_DATA_SYNC_FIELDS(temperature, humidity, battery_millivolts, rssi,
+                         is_charging, counter)
+};
+
+struct LabeledFrame : public TypedSynchronizable<LabeledFrame> {
+  float value = 0;
+  std::string label;
+
+  std::string get_name() const override { return "labeled_frame"; }
+
+  SMALL_DATA_SYNC_FIELDS(value, label)
+};
+
+SensorFrame create_sensor_frame() {
+  auto frame = SensorFrame();
+  frame.temperature = 21.5f;
+  frame.humidity = 48.25f;
+  frame.battery_millivolts = 3712;
+  frame.rssi = -67;
+  frame.is_charging = true;
+  frame.sequence = 123456;
+
+  return frame;
+}
+
+void packed_codec_round_trip_test() {
+  const auto codec = std::make_shared<PackedCodec>();
+  TEST_ASSERT_TRUE(codec->get_format() == DataFormat::PACKED);
+
+  const auto encoding = codec->encode(create_sensor_frame().to_data_object());
+
+  std::string error_string;
+  const auto decoded = codec->decode(encoding, error_string);
+  TEST_ASSERT_TRUE_MESSAGE(decoded.has_value(), "decoding should succeed.");
+  TEST_ASSERT_TRUE_MESSAGE(decoded.value()->is_packed(),
+                           "the frame should be decoded as a packed value.");
+
+  auto received_frame = SensorFrame();
+  TEST_ASSERT_TRUE(received_frame.apply_from_data_object(decoded.value()));
+  TEST_ASSERT_TRUE(received_frame.temperature == 21.5f);
+  TEST_ASSERT_TRUE(received_frame.humidity == 48.25f);
+  TEST_ASSERT_EQUAL(3712, received_frame.battery_millivolts);
+  TEST_ASSERT_EQUAL(-67, received_frame.rssi);
+  TEST_ASSERT_TRUE(received_frame.is_charging);
+  TEST_ASSERT_EQUAL(123456, received_frame.sequence);
+
+  // 4 + 4 + 2 + 2 + 1 + 4 bytes of fields, a 4-byte schema hash, and a
+  // 3-byte extension header.
+  TEST_ASSERT_EQUAL(24, encoding.size());
+
+  const auto msgpack_encoding =
+      MsgPackCodec().encode(create_sensor_frame().to_data_object());
+  TEST_ASSERT_TRUE_MESSAGE(encoding.size() < msgpack_encoding.size() / 3,
+                           "the packed frame should be much smaller.");
+}
+
+void packed_codec_schema_mismatch_test() {
+  const auto codec = PackedCodec();
+  const auto encoding = codec.encode(create_sensor_frame().to_data_object());
+
+  std::string error_string;
+  const auto decoded = codec.decode(encoding, error_string);
+
+  auto renamed_frame = RenamedSensorFrame();
+  TEST_ASSERT_FALSE_MESSAGE(
+      renamed_frame.apply_from_data_object(decoded.value()),
+      "a record with a different schema should be rejected.");
+  TEST_ASSERT_EQUAL(0, renamed_frame.counter);
+}
+
+void packed_codec_invalid_values_test() {
+  const auto codec = PackedCodec();
+  std::string error_string;
+
+  // the fields make up the end of the record, and is_charging is followed by
+  // the 4 bytes of sequence
+  auto encoding = codec.encode(create_sensor_frame().to_data_object());
+  encoding[encoding.size() - 5] = 0x02;
+  auto received_frame = SensorFrame();
+  TEST_ASSERT_TRUE(received_frame.apply_from_data_object(
+      codec.decode(encoding, error_string).value()));
+  TEST_ASSERT_TRUE(received_frame.is_charging);
+  TEST_ASSERT_EQUAL(123456, received_frame.sequence);
+
+  auto frame = create_sensor_frame();
+  frame.humidity = std::numeric_limits<float>::quiet_NaN();
+  const auto nan_encoding = codec.encode(frame.to_data_object());
+  auto unchanged_frame = SensorFrame();
+  TEST_ASSERT_FALSE_MESSAGE(
+      unchanged_frame.apply_from_data_object(
+          codec.decode(nan_encoding, error_string).value()),
+      "a record with a non-finite number should be rejected.");
+  TEST_ASSERT_TRUE(unchanged_frame.temperature == 0);
+  TEST_ASSERT_TRUE(unchanged_frame.humidity == 0);
+}
+
+void packed_codec_fallback_test() {
+  const auto codec = PackedCodec();
+
+  auto frame = LabeledFrame();
+  frame.value = 2.5f;
+  frame.label = "not packable";
+
+  std::string error_string;
+  const auto decoded =
+      codec.decode(codec.encode(create_array({
+                       create_string_value("sync"),
+                       create_number_value(7),
+                       frame.to_data_object(),
+                   })),
+                   error_string);
+
+  TEST_ASSERT_TRUE(decoded.has_value());
+
+  const auto payload = decoded.value()->array_items().value()->at(2);
+  TEST_ASSERT_TRUE_MESSAGE(payload->is_object(),
+                           "a frame with a string should not be packed.");
+
+  auto received_frame = LabeledFrame();
+  TEST_ASSERT_TRUE(received_frame.apply_from_data_object(payload));
+  TEST_ASSERT_TRUE(received_frame.value == 2.5f);
+  TEST_ASSERT_EQUAL_STRING("not packable", received_frame.label.c_str());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+
+  RUN_TEST(packed_codec_round_trip_test);
+  RUN_TEST(packed_codec_schema_mismatch_test);
+  RUN_TEST(packed_codec_invalid_values_test);
+  RUN_TEST(packed_codec_fallback_test);
+
+  return UNITY_END();
+}
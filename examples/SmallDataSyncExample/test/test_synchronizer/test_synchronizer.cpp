@@ -151,6 +151,191 @@ void basic_synchronizer_test_with_network_simulator() {
       "receiver_synchronizable_value’s integer should be 42.");
 }
 
+void coalescing_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  network_simulator.set_packet_loss_rate(0);
+
+  const auto empty_mdns_interface =
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+  sender_synchronizer->set_mdns_interface(empty_mdns_interface);
+  sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto sender_network_handler = sender_synchronizer->get_network_handler();
+
+  auto const sender_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      sender, sender_network_handler, network_simulator);
+  sender_synchronizer->set_udp_interface(sender_udp_interface);
+
+  sender_synchronizer->init();
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_synchronizer = synchronizer::Synchronizer::create("receiver");
+  receiver_synchronizer->set_mdns_interface(empty_mdns_interface);
+  receiver_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto receiver_network_handler = receiver_synchronizer->get_network_handler();
+
+  auto const receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_synchronizer->set_udp_interface(receiver_udp_interface);
+
+  receiver_synchronizer->init();
+
+  auto received_update_count = 0;
+  receiver_synchronizer->set_remote_update_handler(
+      [&received_update_count](
+          const udp_interface::Endpoint endpoint,
+          const std::shared_ptr<Synchronizable> synchronizable,
+          const std::shared_ptr<data_object::GenericValue> data_object) {
+        received_update_count += 1;
+        synchronizable->apply_from_data_object(data_object);
+      });
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  receiver_synchronizer->add_endpoint(sender);
+  sender_synchronizer->add_endpoint(receiver);
+
+  auto sender_synchronizable = std::make_shared<SynchronizableMock>();
+
+  // Only the first update goes out right away; the others overwrite it while
+  // it is in flight, and only the latest one is sent once it is acknowledged.
+  for (int i = 1; i <= 1000; i += 1) {
+    sender_synchronizable->set_integer(i);
+    sender_synchronizer->synchronize(sender_synchronizable);
+  }
+
+  for (int i = 0; i < 20; i += 1) {
+    sender_synchronizer->on_100_ms_passed();
+    sender_synchronizer->heartbeat();
+    receiver_synchronizer->on_100_ms_passed();
+    receiver_synchronizer->heartbeat();
+  }
+
+  const auto receiver_synchronizable =
+      receiver_synchronizer
+          ->get_synchronizable_for_endpoint<SynchronizableMock>(
+              sender, "SynchronizableMock");
+
+  TEST_ASSERT_TRUE_MESSAGE(receiver_synchronizable.has_value(),
+                           "receiver_synchronizable should have value.");
+  TEST_ASSERT_EQUAL_MESSAGE(
+      1000, receiver_synchronizable.value()->get_integer(),
+      "receiver_synchronizable’s integer should be 1000.");
+  TEST_ASSERT_EQUAL_MESSAGE(2, received_update_count,
+                            "1000 updates should be coalesced into 2.");
+}
+
+void rate_limit_test() {
+  auto network_simulator = utils::NetworkSimulator();
+  network_simulator.set_packet_loss_rate(0);
+
+  const auto empty_mdns_interface =
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+  sender_synchronizer->set_mdns_interface(empty_mdns_interface);
+  sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto sender_network_handler = sender_synchronizer->get_network_handler();
+
+  auto const sender_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      sender, sender_network_handler, network_simulator);
+  sender_synchronizer->set_udp_interface(sender_udp_interface);
+
+  sender_synchronizer->init();
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_synchronizer = synchronizer::Synchronizer::create("receiver");
+  receiver_synchronizer->set_mdns_interface(empty_mdns_interface);
+  receiver_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto receiver_network_handler = receiver_synchronizer->get_network_handler();
+
+  auto const receiver_udp_interface = std::make_shared<utils::UdpInterfaceImpl>(
+      receiver, receiver_network_handler, network_simulator);
+  receiver_synchronizer->set_udp_interface(receiver_udp_interface);
+
+  receiver_synchronizer->init();
+
+  auto received_update_count = 0;
+  receiver_synchronizer->set_remote_update_handler(
+      [&received_update_count](
+          const udp_interface::Endpoint endpoint,
+          const std::shared_ptr<Synchronizable> synchronizable,
+          const std::shared_ptr<data_object::GenericValue> data_object) {
+        received_update_count += 1;
+        synchronizable->apply_from_data_object(data_object);
+      });
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  receiver_synchronizer->add_endpoint(sender);
+  sender_synchronizer->add_endpoint(receiver);
+
+  sender_synchronizer->set_rate_limit("SynchronizableMock",
+                                      rate_limiter::RateLimit(5));
+
+  auto sender_synchronizable = std::make_shared<SynchronizableMock>();
+
+  for (int i = 1; i <= 50; i += 1) {
+    sender_synchronizable->set_integer(i);
+    sender_synchronizer->synchronize(sender_synchronizable);
+
+    sender_synchronizer->on_100_ms_passed();
+    sender_synchronizer->heartbeat();
+    receiver_synchronizer->on_100_ms_passed();
+    receiver_synchronizer->heartbeat();
+    sender_synchronizer->heartbeat();
+  }
+
+  TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(
+      11, received_update_count,
+      "At most one update per 500 ms should have been sent.");
+
+  // The last update is held back and has to go out on a later tick.
+  for (int i = 0; i < 10; i += 1) {
+    sender_synchronizer->on_100_ms_passed();
+    sender_synchronizer->heartbeat();
+    receiver_synchronizer->on_100_ms_passed();
+    receiver_synchronizer->heartbeat();
+  }
+
+  const auto receiver_synchronizable =
+      receiver_synchronizer
+          ->get_synchronizable_for_endpoint<SynchronizableMock>(
+              sender, "SynchronizableMock");
+
+  TEST_ASSERT_TRUE_MESSAGE(receiver_synchronizable.has_value(),
+                           "receiver_synchronizable should have value.");
+  TEST_ASSERT_EQUAL_MESSAGE(50, receiver_synchronizable.value()->get_integer(),
+                            "receiver_synchronizable’s integer should be 50.");
+
+  auto limiter = rate_limiter::RateLimiter();
+  limiter.set_rate_limit("bytes", rate_limiter::RateLimit(0, 100));
+
+  TEST_ASSERT_TRUE_MESSAGE(limiter.try_acquire("bytes"),
+                           "The first send should be allowed.");
+  limiter.record_bytes_sent("bytes", 150);
+  TEST_ASSERT_FALSE_MESSAGE(limiter.try_acquire("bytes"),
+                            "The byte allowance should be exhausted.");
+
+  auto released_count = 0;
+  for (int i = 0; i < 10; i += 1) {
+    released_count += limiter.on_100_ms_passed().size();
+  }
+
+  TEST_ASSERT_EQUAL_MESSAGE(
+      1, released_count,
+      "The pending send should be released once the allowance refills.");
+}
+
 void basic_mdns_handler_test() {
   auto mdns_simulator = utils::MDNSSimulator();
   auto network_simulator = utils::NetworkSimulator();
@@ -233,12 +418,176 @@ void basic_mdns_handler_test() {
       "receiver_synchronizable_value’s integer should be 42.");
 }
 
+void peer_timeout_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  const auto empty_mdns_interface =
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+  sender_synchronizer->set_mdns_interface(empty_mdns_interface);
+  sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto sender_network_handler = sender_synchronizer->get_network_handler();
+  sender_synchronizer->set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(sender, sender_network_handler,
+                                                network_simulator));
+  sender_synchronizer->init();
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_synchronizer = synchronizer::Synchronizer::create("receiver");
+  receiver_synchronizer->set_mdns_interface(empty_mdns_interface);
+  receiver_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto receiver_network_handler = receiver_synchronizer->get_network_handler();
+  receiver_synchronizer->set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          receiver, receiver_network_handler, network_simulator));
+  receiver_synchronizer->init();
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  liveness::LivenessOptions options;
+  options.keepalive_interval = 10;
+  options.suspicion_timeout = 30;
+  options.dead_timeout = 100;
+  sender_synchronizer->set_liveness_options(options);
+  receiver_synchronizer->set_liveness_options(options);
+
+  receiver_synchronizer->add_endpoint(sender);
+  sender_synchronizer->add_endpoint(receiver);
+
+  const auto run_deciseconds = [&](const int count) {
+    for (int i = 0; i < count; i += 1) {
+      sender_synchronizer->on_100_ms_passed();
+      sender_synchronizer->heartbeat();
+      receiver_synchronizer->on_100_ms_passed();
+      receiver_synchronizer->heartbeat();
+    }
+  };
+
+  // idle peers stay known thanks to keepalives
+  run_deciseconds(200);
+  TEST_ASSERT_TRUE(sender_synchronizer->is_endpoint_known(receiver));
+  TEST_ASSERT_TRUE(receiver_synchronizer->is_endpoint_known(sender));
+
+  // once the receiver is gone, the synchronization is only retransmitted
+  // until the receiver is suspected, and the receiver is removed after the
+  // dead timeout
+  network_simulator.set_packet_loss_rate(1.0);
+  const auto packets_sent_before = sender_synchronizer->get_network_metrics()
+                                       .endpoints.at(receiver)
+                                       .packets_sent;
+  auto sender_synchronizable = std::make_shared<SynchronizableMock>();
+  sender_synchronizable->set_integer(42);
+  sender_synchronizer->synchronize(sender_synchronizable);
+  run_deciseconds(80);
+
+  const auto& metrics = sender_synchronizer->get_network_metrics();
+  TEST_ASSERT_TRUE(sender_synchronizer->is_endpoint_known(receiver));
+  TEST_ASSERT_LESS_THAN(
+      50, metrics.endpoints.at(receiver).packets_sent - packets_sent_before);
+
+  run_deciseconds(30);
+
+  // the counters of the removed receiver are dropped along with it
+  TEST_ASSERT_FALSE(sender_synchronizer->is_endpoint_known(receiver));
+  TEST_ASSERT_EQUAL(
+      0, sender_synchronizer->get_network_metrics().active_message_count);
+  TEST_ASSERT_EQUAL(1, metrics.liveness.timed_out_peers);
+  TEST_ASSERT_EQUAL(0, metrics.endpoints.count(receiver));
+}
+
+void silent_peer_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+  sender_synchronizer->set_mdns_interface(
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>());
+  sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto sender_network_handler = sender_synchronizer->get_network_handler();
+  sender_synchronizer->set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(sender, sender_network_handler,
+                                                network_simulator));
+  sender_synchronizer->init();
+
+  // like a peer running a release without keepalives, this one never sends
+  // anything while idle
+  auto silent_peer =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(silent_peer);
+  sender_synchronizer->add_endpoint(silent_peer);
+
+  for (int i = 0; i < 600; i += 1) {
+    sender_synchronizer->on_100_ms_passed();
+    sender_synchronizer->heartbeat();
+  }
+
+  // by default, it is kept nonetheless, and no keepalives are sent to it
+  TEST_ASSERT_TRUE(sender_synchronizer->is_endpoint_known(silent_peer));
+  const auto& metrics = sender_synchronizer->get_network_metrics();
+  TEST_ASSERT_EQUAL(0, metrics.liveness.keepalives_sent);
+  TEST_ASSERT_EQUAL(0, metrics.endpoints.at(silent_peer).packets_sent);
+  TEST_ASSERT_EQUAL(0, metrics.liveness.suspected_peers);
+  TEST_ASSERT_EQUAL(0, metrics.liveness.timed_out_peers);
+}
+
+void removed_peer_test() {
+  auto network_simulator = utils::NetworkSimulator();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+  sender_synchronizer->set_mdns_interface(
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>());
+  sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto sender_network_handler = sender_synchronizer->get_network_handler();
+  sender_synchronizer->set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(sender, sender_network_handler,
+                                                network_simulator));
+  sender_synchronizer->init();
+
+  // the peer never acknowledges anything
+  auto peer =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(peer);
+  sender_synchronizer->add_endpoint(peer);
+
+  auto sender_synchronizable = std::make_shared<SynchronizableMock>();
+  sender_synchronizable->set_integer(42);
+  sender_synchronizer->synchronize(sender_synchronizable);
+  TEST_ASSERT_EQUAL(
+      1, sender_synchronizer->get_network_metrics().active_message_count);
+
+  sender_synchronizer->remove_endpoint(peer);
+  for (int i = 0; i < 50; i += 1) {
+    sender_synchronizer->on_100_ms_passed();
+    sender_synchronizer->heartbeat();
+  }
+
+  // the synchronization of the removed peer is not retransmitted
+  const auto& metrics = sender_synchronizer->get_network_metrics();
+  TEST_ASSERT_EQUAL(0, metrics.active_message_count);
+  TEST_ASSERT_EQUAL(0, metrics.untracked_endpoints.packets_sent);
+}
+
 int main(int argc, char** argv) {
   UNITY_BEGIN();
 
   RUN_TEST(basic_synchronizer_test);
   RUN_TEST(basic_synchronizer_test_with_network_simulator);
+  RUN_TEST(coalescing_test);
+  RUN_TEST(rate_limit_test);
   RUN_TEST(basic_mdns_handler_test);
+  RUN_TEST(peer_timeout_test);
+  RUN_TEST(silent_peer_test);
+  RUN_TEST(removed_peer_test);
 
   return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../thread_utils.h"
+#include "../utils.h"
+#include "foo.h"
+
+#define PRODUCER_COUNT 8
+
+struct CounterSynchronizable : public Synchronizable {
+ private:
+  std::string name;
+  int value = 0;
+
+ public:
+  CounterSynchronizable(std::string name) : name(name) {}
+
+  int get_value() const { return value; }
+
+  void set_value(const int new_value) { value = new_value; }
+
+  std::string get_name() const override { return name; };
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return data_object::create_number_value(value);
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) override {
+    if (data_object->is_number()) {
+      value = data_object->int_value().value();
+      return true;
+    }
+
+    return false;
+  }
+};
+
+struct DelegateImpl : public synchronizer::SynchronizerDelegate {
+  std::vector<std::shared_ptr<Synchronizable>>
+  create_initial_synchronizables_container() override {
+    std::vector<std::shared_ptr<Synchronizable>> container;
+
+    for (int i = 0; i < PRODUCER_COUNT; i += 1) {
+      container.push_back(std::make_shared<CounterSynchronizable>(
+          "counter_" + std::to_string(i)));
+    }
+
+    return container;
+  }
+};
+
+void mpsc_queue_stress_test() {
+  const int items_per_producer = 20000;
+  lock_free_queue::MPSCQueue<std::pair<int, int>> queue(1024);
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < PRODUCER_COUNT; producer += 1) {
+    producers.push_back(std::thread([&queue, producer, items_per_producer]() {
+      for (int i = 0; i < items_per_producer; i += 1) {
+        while (!queue.push(std::make_pair(producer, i))) {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+
+  std::vector<int> next_expected(PRODUCER_COUNT, 0);
+  int received = 0;
+  bool is_in_order = true;
+
+  while (received < PRODUCER_COUNT * items_per_producer) {
+    const auto item = queue.pop();
+
+    if (!item.has_value()) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const auto producer = item.value().first;
+    const auto value = item.value().second;
+
+    if (next_expected[producer] != value) {
+      is_in_order = false;
+    }
+    next_expected[producer] = value + 1;
+
+    received += 1;
+  }
+
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  TEST_ASSERT_TRUE_MESSAGE(is_in_order,
+                           "each producer’s items should arrive in order.");
+  TEST_ASSERT_FALSE_MESSAGE(queue.pop().has_value(),
+                            "queue should be empty.");
+}
+
+void spsc_queue_test() {
+  const int item_count = 100000;
+  lock_free_queue::SPSCQueue<int> queue(64);
+
+  std::thread producer([&queue, item_count]() {
+    for (int i = 0; i < item_count; i += 1) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  bool is_in_order = true;
+
+  while (expected < item_count) {
+    const auto item = queue.pop();
+
+    if (!item.has_value()) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    if (item.value() != expected) {
+      is_in_order = false;
+    }
+    expected += 1;
+  }
+
+  producer.join();
+
+  TEST_ASSERT_TRUE_MESSAGE(is_in_order, "items should arrive in order.");
+  TEST_ASSERT_FALSE_MESSAGE(queue.pop().has_value(),
+                            "queue should be empty.");
+}
+
+void os_task_test() {
+  std::atomic<int> counter(0);
+  os::Task task;
+
+  const auto config = os::TaskConfig("test_task", 4096, 1, os::APP_CORE);
+  const auto function = [&counter]() {
+    for (int i = 0; i < 10; i += 1) {
+      counter += 1;
+      os::sleep_for_microseconds(100);
+    }
+  };
+
+  TEST_ASSERT_TRUE_MESSAGE(task.start(function, config),
+                           "task should start.");
+  TEST_ASSERT_TRUE_MESSAGE(task.is_started(), "task should be started.");
+  TEST_ASSERT_FALSE_MESSAGE(task.start(function, config),
+                            "a started task should not start again.");
+
+  task.join();
+
+  TEST_ASSERT_FALSE_MESSAGE(task.is_started(),
+                            "a joined task should not be started.");
+  TEST_ASSERT_EQUAL_MESSAGE(10, counter.load(),
+                            "the task’s function should have run to the end.");
+}
+
+std::shared_ptr<synchronizer::Synchronizer> create_synchronizer(
+    const char *hostname, udp_interface::Endpoint endpoint,
+    utils::NetworkSimulator &network_simulator, std::mutex &mutex) {
+  const auto synchronizer = synchronizer::Synchronizer::create(hostname);
+  synchronizer->set_mdns_interface(
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>());
+  synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  synchronizer->set_udp_interface(
+      std::make_shared<thread_utils::LockedUdpInterfaceImpl>(
+          endpoint, network_simulator, mutex));
+  synchronizer->init();
+
+  return synchronizer;
+}
+
+void threaded_synchronizer_stress_test() {
+  const int updates_per_producer = 500;
+
+  auto network_simulator = utils::NetworkSimulator();
+  std::mutex network_simulator_mutex;
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  const auto sender_synchronizer = create_synchronizer(
+      "sender", sender, network_simulator, network_simulator_mutex);
+  const auto receiver_synchronizer = create_synchronizer(
+      "receiver", receiver, network_simulator, network_simulator_mutex);
+  sender_synchronizer->add_endpoint(receiver);
+  receiver_synchronizer->add_endpoint(sender);
+
+  synchronizer::ThreadedSynchronizer threaded_sender(sender_synchronizer);
+  synchronizer::ThreadedSynchronizer threaded_receiver(receiver_synchronizer);
+  threaded_sender.start();
+  threaded_receiver.start();
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < PRODUCER_COUNT; producer += 1) {
+    producers.push_back(std::thread(
+        [&threaded_sender, producer, updates_per_producer]() {
+          const auto counter = std::make_shared<CounterSynchronizable>(
+              "counter_" + std::to_string(producer));
+
+          for (int i = 1; i <= updates_per_producer; i += 1) {
+            counter->set_value(i);
+
+            while (!threaded_sender.synchronize(counter)) {
+              std::this_thread::yield();
+            }
+          }
+        }));
+  }
+
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  auto has_converged = false;
+
+  while (!has_converged && std::chrono::steady_clock::now() < deadline) {
+    threaded_receiver.apply_remote_updates();
+
+    has_converged = true;
+    for (int producer = 0; producer < PRODUCER_COUNT; producer += 1) {
+      const auto counter =
+          threaded_receiver
+              .get_synchronizable_for_endpoint<CounterSynchronizable>(
+                  sender, "counter_" + std::to_string(producer));
+
+      if (!counter.has_value() ||
+          counter.value()->get_value() != updates_per_producer) {
+        has_converged = false;
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  threaded_sender.stop();
+  threaded_receiver.stop();
+
+  TEST_ASSERT_TRUE_MESSAGE(
+      has_converged,
+      "the receiver should end up with every producer’s last value.");
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+
+  RUN_TEST(mpsc_queue_stress_test);
+  RUN_TEST(spsc_queue_test);
+  RUN_TEST(os_task_test);
+  RUN_TEST(threaded_synchronizer_stress_test);
+
+  return UNITY_END();
+}
@@ -0,0 +1,195 @@
+#include <unity.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../utils.h"
+#include "foo.h"
+
+#ifdef SMALL_DATA_SYNC_TRACING
+struct SynchronizableMock : public Synchronizable {
+ private:
+  int integer = 0;
+
+ public:
+  int get_integer() const { return integer; }
+
+  void set_integer(const int value) { integer = value; }
+
+  std::string get_name() const { return "SynchronizableMock"; };
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const {
+    return data_object::create_number_value(integer);
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) {
+    if (data_object->is_number()) {
+      integer = data_object->number_value().value();
+      return true;
+    }
+
+    return false;
+  }
+};
+
+struct DelegateImpl : public synchronizer::SynchronizerDelegate {
+  std::vector<std::shared_ptr<Synchronizable>>
+  create_initial_synchronizables_container() override {
+    return {
+        std::make_shared<SynchronizableMock>(),
+    };
+  }
+};
+
+uint64_t fake_time_in_nanoseconds = 0;
+
+/**
+ * A clock that advances by 1 µs every time it is read.
+ */
+uint64_t get_fake_time_in_nanoseconds() {
+  fake_time_in_nanoseconds += 1000;
+  return fake_time_in_nanoseconds;
+}
+
+void stage_histogram_test() {
+  tracing::StageHistogram histogram;
+  histogram.record(0);
+  histogram.record(256);
+  histogram.record(257);
+  histogram.record(1000);
+  histogram.record(1ull << 40);
+
+  TEST_ASSERT_EQUAL(5, histogram.count);
+  TEST_ASSERT_EQUAL(2, histogram.buckets[0]);
+  TEST_ASSERT_EQUAL(1, histogram.buckets[1]);
+  TEST_ASSERT_EQUAL(1, histogram.buckets[2]);
+  const auto last_bucket = tracing::StageHistogram::bucket_count - 1;
+  TEST_ASSERT_EQUAL(1, histogram.buckets[last_bucket]);
+  TEST_ASSERT_TRUE(histogram.max_nanoseconds == 1ull << 40);
+  TEST_ASSERT_TRUE(histogram.total_nanoseconds == (1ull << 40) + 1513);
+}
+
+void synchronization_stages_test() {
+  tracing::set_clock(&get_fake_time_in_nanoseconds);
+  tracing::reset();
+
+  auto network_simulator = utils::NetworkSimulator();
+  const auto empty_mdns_interface =
+      std::make_shared<utils::EmptyMDNSInterfaceImpl>();
+
+  auto sender =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(0), 0);
+  auto sender_synchronizer = synchronizer::Synchronizer::create("sender");
+  sender_synchronizer->set_mdns_interface(empty_mdns_interface);
+  sender_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto sender_network_handler = sender_synchronizer->get_network_handler();
+  sender_synchronizer->set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          sender, sender_network_handler, network_simulator));
+  sender_synchronizer->init();
+
+  auto receiver =
+      udp_interface::Endpoint(std::make_shared<utils::IPAddressImpl>(1), 1);
+  auto receiver_synchronizer = synchronizer::Synchronizer::create("receiver");
+  receiver_synchronizer->set_mdns_interface(empty_mdns_interface);
+  receiver_synchronizer->set_delegate(std::make_shared<DelegateImpl>());
+  auto receiver_network_handler = receiver_synchronizer->get_network_handler();
+  receiver_synchronizer->set_udp_interface(
+      std::make_shared<utils::UdpInterfaceImpl>(
+          receiver, receiver_network_handler, network_simulator));
+  receiver_synchronizer->init();
+
+  network_simulator.register_endpoint(sender);
+  network_simulator.register_endpoint(receiver);
+
+  receiver_synchronizer->add_endpoint(sender);
+  sender_synchronizer->add_endpoint(receiver);
+
+  auto sender_synchronizable = std::make_shared<SynchronizableMock>();
+  sender_synchronizable->set_integer(42);
+  sender_synchronizer->synchronize(sender_synchronizable);
+
+  for (int i = 0; i < 10; i += 1) {
+    sender_synchronizer->on_100_ms_passed();
+    sender_synchronizer->heartbeat();
+    receiver_synchronizer->on_100_ms_passed();
+    receiver_synchronizer->heartbeat();
+  }
+
+  const auto receiver_synchronizable =
+      receiver_synchronizer
+          ->get_synchronizable_for_endpoint<SynchronizableMock>(
+              sender, "SynchronizableMock");
+  TEST_ASSERT_TRUE(receiver_synchronizable.has_value());
+  TEST_ASSERT_EQUAL(42, receiver_synchronizable.value()->get_integer());
+
+  for (size_t i = 0; i < tracing::stage_count; i += 1) {
+    const auto stage = (tracing::Stage)i;
+    const auto histogram = tracing::get_histogram(stage);
+
+    TEST_ASSERT_TRUE_MESSAGE(histogram.count > 0,
+                             tracing::get_stage_name(stage));
+    // every span reads the fake clock at least twice
+    TEST_ASSERT_TRUE_MESSAGE(
+        histogram.total_nanoseconds >= 1000 * histogram.count,
+        tracing::get_stage_name(stage));
+
+    TEST_PRINTF("%s: %u spans, %.1f µs on average\n",
+                tracing::get_stage_name(stage), (unsigned int)histogram.count,
+                histogram.total_nanoseconds / 1000.0 / histogram.count);
+  }
+
+  tracing::reset();
+  TEST_ASSERT_EQUAL(0, tracing::get_histogram(tracing::Stage::APPLY).count);
+  tracing::set_clock(nullptr);
+}
+
+void concurrent_recording_test() {
+  tracing::reset();
+
+  const int thread_count = 4;
+  const int records_per_thread = 100000;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; i += 1) {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < records_per_thread; j += 1) {
+        tracing::record(tracing::Stage::DECODE, 256 * (i + 1));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // no record is lost, although all threads share the histogram
+  const auto histogram = tracing::get_histogram(tracing::Stage::DECODE);
+  TEST_ASSERT_EQUAL(thread_count * records_per_thread, histogram.count);
+  TEST_ASSERT_EQUAL(records_per_thread, histogram.buckets[0]);
+  TEST_ASSERT_EQUAL(records_per_thread, histogram.buckets[1]);
+  TEST_ASSERT_EQUAL(2 * records_per_thread, histogram.buckets[2]);
+  TEST_ASSERT_TRUE(histogram.total_nanoseconds ==
+                   (uint64_t)256 * 10 * records_per_thread);
+  TEST_ASSERT_TRUE(histogram.max_nanoseconds == 256 * thread_count);
+
+  tracing::reset();
+}
+#else
+void tracing_disabled_test() {
+  TEST_IGNORE_MESSAGE("SMALL_DATA_SYNC_TRACING is not defined.");
+}
+#endif
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+#ifdef SMALL_DATA_SYNC_TRACING
+  RUN_TEST(stage_histogram_test);
+  RUN_TEST(synchronization_stages_test);
+  RUN_TEST(concurrent_recording_test);
+#else
+  RUN_TEST(tracing_disabled_test);
+#endif
+  return UNITY_END();
+}
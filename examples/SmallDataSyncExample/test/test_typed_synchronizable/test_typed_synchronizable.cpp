@@ -0,0 +1,194 @@
+#include <unity.h>
+
+#include <memory>
+
+#include "../utils.h"
+#include "foo.h"
+
+using namespace data_object;
+
+struct SensorFrame : public TypedSynchronizable<SensorFrame> {
+  bool is_on = false;
+  int fan_speed = 0;
+  uint32_t sample_count = 0;
+  double temperature = 0;
+  std::string label;
+
+  std::string get_name() const override { return "sensor_frame"; }
+
+  SMALL_DATA_SYNC_FIELDS(is_on, fan_speed, sample_count, temperature, label)
+};
+
+struct SampleBuffer : public TypedSynchronizable<SampleBuffer> {
+  std::vector<uint8_t> samples;
+
+  std::string get_name() const override { return "sample_buffer"; }
+
+  SMALL_DATA_SYNC_FIELDS(samples)
+};
+
+std::shared_ptr<GenericValue> create_expected_data_object() {
+  return create_object({
+      {"is_on", create_bool_value(true)},
+      {"fan_speed", create_number_value(-12)},
+      {"sample_count", create_number_value(4000000000u)},
+      {"temperature", create_number_value(21.5)},
+      {"label", create_string_value("kitchen \"north\"")},
+  });
+}
+
+SensorFrame create_sensor_frame() {
+  auto frame = SensorFrame();
+  frame.is_on = true;
+  frame.fan_speed = -12;
+  frame.sample_count = 4000000000u;
+  frame.temperature = 21.5;
+  frame.label = "kitchen \"north\"";
+
+  return frame;
+}
+
+void typed_synchronizable_round_trip_test() {
+  const std::shared_ptr<Codec> codecs[] = {
+      std::make_shared<JsonCodec>(),
+      std::make_shared<MsgPackCodec>(),
+  };
+
+  for (const auto& codec : codecs) {
+    const auto frame = create_sensor_frame();
+    const auto encoding = codec->encode(create_array({
+        create_string_value("sync"),
+        frame.to_data_object(),
+    }));
+
+    std::string error_string;
+    const auto decoded = codec->decode(encoding, error_string);
+    TEST_ASSERT_TRUE_MESSAGE(decoded.has_value(), "decoding should succeed.");
+
+    auto received_frame = SensorFrame();
+    const auto was_applied = received_frame.apply_from_data_object(
+        decoded.value()->array_items().value()->at(1));
+
+    TEST_ASSERT_TRUE_MESSAGE(was_applied, "applying should succeed.");
+    TEST_ASSERT_TRUE(received_frame.is_on);
+    TEST_ASSERT_EQUAL(-12, received_frame.fan_speed);
+    TEST_ASSERT_TRUE(received_frame.sample_count == 4000000000u);
+    TEST_ASSERT_TRUE(received_frame.temperature == 21.5);
+    TEST_ASSERT_EQUAL_STRING("kitchen \"north\"", received_frame.label.c_str());
+  }
+}
+
+void typed_synchronizable_matches_data_object_test() {
+  const std::shared_ptr<Codec> codecs[] = {
+      std::make_shared<JsonCodec>(),
+      std::make_shared<MsgPackCodec>(),
+  };
+
+  const auto frame_data_object = create_sensor_frame().to_data_object();
+  const auto expected_data_object = create_expected_data_object();
+
+  TEST_ASSERT_TRUE_MESSAGE(frame_data_object->equals(expected_data_object),
+                           "The typed value should act as a data object.");
+
+  for (const auto& codec : codecs) {
+    std::string error_string;
+    const auto decoded =
+        codec->decode(codec->encode(frame_data_object), error_string);
+
+    TEST_ASSERT_TRUE_MESSAGE(decoded.has_value(), "decoding should succeed.");
+    TEST_ASSERT_TRUE_MESSAGE(
+        decoded.value()->equals(expected_data_object),
+        "The direct encoding should decode to the equivalent data object.");
+  }
+}
+
+void typed_synchronizable_invalid_data_test() {
+  auto frame = create_sensor_frame();
+
+  TEST_ASSERT_FALSE(frame.apply_from_data_object(create_number_value(3)));
+
+  const auto was_applied = frame.apply_from_data_object(create_object({
+      {"fan_speed", create_number_value(7)},
+      {"label", create_number_value(1)},
+  }));
+
+  TEST_ASSERT_FALSE_MESSAGE(was_applied,
+                            "A field of the wrong type should be reported.");
+  TEST_ASSERT_EQUAL(7, frame.fan_speed);
+  TEST_ASSERT_TRUE(frame.temperature == 21.5);
+  TEST_ASSERT_EQUAL_STRING("kitchen \"north\"", frame.label.c_str());
+}
+
+struct SmallIntegers : public TypedSynchronizable<SmallIntegers> {
+  int8_t offset = 0;
+  uint16_t count = 0;
+  float ratio = 0;
+
+  std::string get_name() const override { return "small_integers"; }
+
+  SMALL_DATA_SYNC_FIELDS(offset, count, ratio)
+};
+
+void typed_synchronizable_range_test() {
+  auto integers = SmallIntegers();
+
+  TEST_ASSERT_TRUE(integers.apply_from_data_object(create_object({
+      {"offset", create_number_value(-128)},
+      {"count", create_number_value(3.0)},
+      {"ratio", create_number_value(0.5)},
+  })));
+  TEST_ASSERT_EQUAL(-128, integers.offset);
+  TEST_ASSERT_EQUAL(3, integers.count);
+
+  const std::shared_ptr<GenericValue> invalid_values[] = {
+      create_object({{"offset", create_number_value(300)}}),
+      create_object({{"offset", create_number_value(-129)}}),
+      create_object({{"count", create_number_value(3.7)}}),
+      create_object({{"count", create_number_value(-1)}}),
+      create_object({{"count", create_number_value(65536)}}),
+      create_object({{"count", create_number_value(1e300)}}),
+      create_object({{"ratio", create_number_value(1e300)}}),
+  };
+
+  for (const auto& invalid_value : invalid_values) {
+    TEST_ASSERT_FALSE(integers.apply_from_data_object(invalid_value));
+  }
+  TEST_ASSERT_EQUAL(-128, integers.offset);
+  TEST_ASSERT_EQUAL(3, integers.count);
+  TEST_ASSERT_TRUE(integers.ratio == 0.5f);
+}
+
+void typed_synchronizable_blob_test() {
+  const std::shared_ptr<Codec> codecs[] = {
+      std::make_shared<JsonCodec>(),
+      std::make_shared<MsgPackCodec>(),
+  };
+
+  auto buffer = SampleBuffer();
+  for (int i = 0; i < 40; i += 1) {
+    buffer.samples.push_back((uint8_t)(i * 13));
+  }
+
+  for (const auto& codec : codecs) {
+    std::string error_string;
+    const auto decoded =
+        codec->decode(codec->encode(buffer.to_data_object()), error_string);
+    TEST_ASSERT_TRUE(decoded.has_value());
+
+    auto received_buffer = SampleBuffer();
+    TEST_ASSERT_TRUE(received_buffer.apply_from_data_object(decoded.value()));
+    TEST_ASSERT_TRUE(received_buffer.samples == buffer.samples);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+
+  RUN_TEST(typed_synchronizable_round_trip_test);
+  RUN_TEST(typed_synchronizable_matches_data_object_test);
+  RUN_TEST(typed_synchronizable_invalid_data_test);
+  RUN_TEST(typed_synchronizable_range_test);
+  RUN_TEST(typed_synchronizable_blob_test);
+
+  return UNITY_END();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <mutex>
+
+#include "utils.h"
+
+namespace thread_utils {
+/**
+ * A UDP interface that serializes all access to a shared network simulator, so
+ * that it can be used by the tasks of several synchronizers concurrently.
+ */
+struct LockedUdpInterfaceImpl : public udp_interface::UDPInterface {
+  udp_interface::Endpoint endpoint;
+  utils::NetworkSimulator &network_simulator;
+  std::mutex &mutex;
+
+  LockedUdpInterfaceImpl(udp_interface::Endpoint endpoint,
+                         utils::NetworkSimulator &network_simulator,
+                         std::mutex &mutex)
+      : endpoint(endpoint), network_simulator(network_simulator), mutex(mutex) {}
+
+  bool send_packet(const udp_interface::Endpoint receiver,
+                   const std::string packet) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    network_simulator.send_packet(endpoint, receiver, packet);
+
+    return true;
+  }
+
+  bool is_incoming_packet_available() override {
+    std::lock_guard<std::mutex> lock(mutex);
+    return network_simulator.is_incoming_packet_available(endpoint);
+  }
+
+  tl::optional<udp_interface::IncomingMessage> receive_packet() override {
+    std::lock_guard<std::mutex> lock(mutex);
+    return network_simulator.receive_packet(endpoint);
+  }
+};
+}  // namespace thread_utils
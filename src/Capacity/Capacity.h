@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "FlatMap.h"
+
+/**
+ * Optional compile-time capacity limits. If SMALL_DATA_SYNC_BOUNDED is
+ * defined, the number of known peers, of queued outgoing messages, of
+ * remembered message IDs and of own synchronizables, as well as the bytes
+ * buffered to reassemble fragmented messages, are limited to the capacities
+ * below, which can be overridden with -D flags. The containers
+ * holding them are then backed by vectors whose storage is reserved once by
+ * Synchronizer::init, instead of node-based containers that allocate on every
+ * insertion.
+ *
+ * When a container is full:
+ * - messages from unknown peers are ignored until a known peer is removed,
+ * - a new outgoing message evicts the oldest queued message of a lower
+ *   priority, or is rejected if there is none (see
+ *   NetworkMessage::on_rejected),
+ * - the oldest remembered message ID is forgotten, so a very late duplicate
+ *   of that message is handled again,
+ * - synchronizing another synchronizable with a new name is ignored,
+ * - fragmented messages larger than the reassembly limit are refused, and
+ *   NetworkHandler::set_reassembly_limits cannot raise the limit beyond it.
+ *
+ * Without SMALL_DATA_SYNC_BOUNDED, every capacity is 0, which means unlimited.
+ */
+#ifdef SMALL_DATA_SYNC_BOUNDED
+#ifndef SMALL_DATA_SYNC_MAX_PEERS
+#define SMALL_DATA_SYNC_MAX_PEERS 8
+#endif
+
+#ifndef SMALL_DATA_SYNC_MAX_IN_FLIGHT
+#define SMALL_DATA_SYNC_MAX_IN_FLIGHT 32
+#endif
+
+#ifndef SMALL_DATA_SYNC_MAX_DEDUP_ENTRIES
+#define SMALL_DATA_SYNC_MAX_DEDUP_ENTRIES 64
+#endif
+
+#ifndef SMALL_DATA_SYNC_MAX_OWN_SYNCHRONIZABLES
+#define SMALL_DATA_SYNC_MAX_OWN_SYNCHRONIZABLES 8
+#endif
+
+#ifndef SMALL_DATA_SYNC_MAX_REASSEMBLY_BYTES
+#define SMALL_DATA_SYNC_MAX_REASSEMBLY_BYTES 4096
+#endif
+#endif
+
+namespace capacity {
+#ifdef SMALL_DATA_SYNC_BOUNDED
+const bool is_bounded = true;
+const size_t max_peers = SMALL_DATA_SYNC_MAX_PEERS;
+const size_t max_in_flight = SMALL_DATA_SYNC_MAX_IN_FLIGHT;
+const size_t max_dedup_entries = SMALL_DATA_SYNC_MAX_DEDUP_ENTRIES;
+const size_t max_own_synchronizables = SMALL_DATA_SYNC_MAX_OWN_SYNCHRONIZABLES;
+const size_t max_reassembly_bytes = SMALL_DATA_SYNC_MAX_REASSEMBLY_BYTES;
+
+template <typename Key, typename Value>
+using Map = FlatMap<Key, Value>;
+
+template <typename T>
+using Queue = std::vector<T>;
+#else
+const bool is_bounded = false;
+const size_t max_peers = 0;
+const size_t max_in_flight = 0;
+const size_t max_dedup_entries = 0;
+const size_t max_own_synchronizables = 0;
+const size_t max_reassembly_bytes = 0;
+
+template <typename Key, typename Value>
+using Map = std::map<Key, Value>;
+
+template <typename T>
+using Queue = std::deque<T>;
+#endif
+
+/**
+ * How many bytes fragmented messages may hold while they are reassembled,
+ * unless set otherwise. It is kept to a few KiB on the ESP8266, whose whole
+ * heap is smaller than a large object.
+ */
+#if defined(ARDUINO_ARCH_ESP8266)
+const size_t default_reassembly_bytes = 4096;
+#else
+const size_t default_reassembly_bytes = 16384;
+#endif
+
+/**
+ * Returns the given value, or the given capacity if the value exceeds it. A
+ * capacity of 0 never limits the value.
+ */
+inline size_t limit_to(const size_t value, const size_t max_size) {
+  return max_size != 0 && value > max_size ? max_size : value;
+}
+
+/**
+ * Returns true if a container of the given size has reached the given
+ * capacity. A capacity of 0 is never reached.
+ */
+inline bool is_full(const size_t size, const size_t max_size) {
+  return max_size != 0 && size >= max_size;
+}
+
+/**
+ * Reserves storage for the given number of entries in containers that
+ * support it.
+ */
+template <typename Key, typename Value>
+void reserve(FlatMap<Key, Value>& map, const size_t capacity) {
+  map.reserve(capacity);
+}
+
+template <typename Key, typename Value>
+void reserve(std::map<Key, Value>&, const size_t) {}
+
+template <typename T>
+void reserve(std::vector<T>& vector, const size_t capacity) {
+  vector.reserve(capacity);
+}
+
+template <typename T>
+void reserve(std::deque<T>&, const size_t) {}
+}  // namespace capacity
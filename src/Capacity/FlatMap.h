@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace capacity {
+/**
+ * An ordered map stored in a sorted vector. It offers the subset of the
+ * std::map interface used by this library. Once storage has been reserved,
+ * inserting entries does not allocate as long as the map stays within the
+ * reserved capacity.
+ *
+ * Inserting or erasing entries invalidates iterators and references to
+ * entries, unlike std::map.
+ */
+template <typename Key, typename Value>
+struct FlatMap {
+ public:
+  typedef std::pair<Key, Value> value_type;
+  typedef typename std::vector<value_type>::iterator iterator;
+  typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+ private:
+  std::vector<value_type> entries;
+
+  static bool is_less(const value_type& entry, const Key& key) {
+    return entry.first < key;
+  }
+
+ public:
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  const_iterator begin() const { return entries.begin(); }
+  const_iterator end() const { return entries.end(); }
+
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  size_t capacity() const { return entries.capacity(); }
+  void reserve(const size_t new_capacity) { entries.reserve(new_capacity); }
+
+  iterator find(const Key& key) {
+    const auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                                     &FlatMap::is_less);
+    if (it == entries.end() || key < it->first) {
+      return entries.end();
+    }
+
+    return it;
+  }
+
+  const_iterator find(const Key& key) const {
+    const auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                                     &FlatMap::is_less);
+    if (it == entries.end() || key < it->first) {
+      return entries.end();
+    }
+
+    return it;
+  }
+
+  size_t count(const Key& key) const { return find(key) == end() ? 0 : 1; }
+
+  Value& at(const Key& key) {
+    const auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("FlatMap::at");
+    }
+
+    return it->second;
+  }
+
+  const Value& at(const Key& key) const {
+    const auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("FlatMap::at");
+    }
+
+    return it->second;
+  }
+
+  Value& operator[](const Key& key) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                               &FlatMap::is_less);
+    if (it == entries.end() || key < it->first) {
+      it = entries.insert(it, value_type(key, Value()));
+    }
+
+    return it->second;
+  }
+
+  iterator erase(const_iterator position) {
+    return entries.erase(begin() + (position - entries.cbegin()));
+  }
+
+  iterator erase(iterator position) { return entries.erase(position); }
+
+  size_t erase(const Key& key) {
+    const auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+
+    entries.erase(it);
+    return 1;
+  }
+
+  void clear() { entries.clear(); }
+};
+}  // namespace capacity
@@ -3,6 +3,7 @@
 #include <memory>
 #include <string>
 
+#include "./CodecOptions/CodecOptions.h"
 #include "DataFormat/DataFormat.h"
 #include "DataObject/DataObject.h"
 #include "optional/include/tl/optional.hpp"
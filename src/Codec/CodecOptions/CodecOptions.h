@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include "../KeyDictionary/KeyDictionary.h"
+
+/**
+ * How MessagePack-based codecs encode numbers that are stored as doubles.
+ * Numbers created as integers or float32 values are always encoded as such.
+ */
+enum class NumberEncoding {
+  /**
+   * Every double is encoded as a 9-byte float64.
+   */
+  FLOAT64,
+
+  /**
+   * Doubles are encoded in the smallest lossless form: whole numbers as
+   * integers, numbers exactly representable as float32 as float32, and all
+   * others as float64.
+   */
+  COMPACT,
+
+  /**
+   * Whole numbers are encoded as integers and all other numbers as 5-byte
+   * float32, which keeps about 7 significant digits.
+   */
+  FLOAT32,
+};
+
+/**
+ * Options that tune how a codec encodes data.
+ */
+struct CodecOptions {
+  NumberEncoding number_encoding = NumberEncoding::FLOAT64;
+
+  /**
+   * Object keys that are sent as their index instead of in full, if any.
+   */
+  std::shared_ptr<const KeyDictionary> key_dictionary;
+};
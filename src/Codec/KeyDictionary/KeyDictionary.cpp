@@ -0,0 +1,31 @@
+#include "KeyDictionary.h"
+
+/**
+ * Creates a dictionary of the given keys. Duplicate keys keep their first
+ * index.
+ */
+KeyDictionary::KeyDictionary(const std::vector<std::string> keys) : keys(keys) {
+  for (size_t i = 0; i < keys.size(); i += 1) {
+    key_to_index.insert(std::make_pair(keys[i], i));
+  }
+}
+
+tl::optional<size_t> KeyDictionary::get_index(const std::string &key) const {
+  const auto it = key_to_index.find(key);
+  if (it == key_to_index.end()) {
+    return {};
+  }
+
+  return it->second;
+}
+
+tl::optional<const std::string &> KeyDictionary::get_key(
+    const size_t index) const {
+  if (index >= keys.size()) {
+    return {};
+  }
+
+  return keys[index];
+}
+
+size_t KeyDictionary::size() const { return keys.size(); }
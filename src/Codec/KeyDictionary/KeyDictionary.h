@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "optional/include/tl/optional.hpp"
+
+/**
+ * A fixed list of object keys that codecs replace with their index on the
+ * wire. Every endpoint of a group must register the same keys in the same
+ * order.
+ */
+struct KeyDictionary {
+ private:
+  std::vector<std::string> keys;
+  std::map<std::string, size_t> key_to_index;
+
+ public:
+  KeyDictionary(const std::vector<std::string> keys);
+
+  tl::optional<size_t> get_index(const std::string &key) const;
+
+  tl::optional<const std::string &> get_key(const size_t index) const;
+
+  size_t size() const;
+};
@@ -1,10 +1,242 @@
 #pragma once
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
 #include "../Codec.h"
 #include "json11/json11.hpp"
 
+/**
+ * A data_object::Writer that serializes straight into JSON, producing the same
+ * text as json11. Integers are written exactly, but json11 parses all numbers
+ * as doubles, so integers beyond ±2^53 lose precision when decoded. Object
+ * keys found in the key dictionary of the codec options are written as "#"
+ * followed by their index.
+ */
+struct JsonWriter : public data_object::Writer {
+ private:
+  std::string output;
+  std::vector<size_t> element_counts;
+  bool is_after_key = false;
+  std::shared_ptr<const KeyDictionary> key_dictionary;
+
+  void begin_value() {
+    if (is_after_key) {
+      is_after_key = false;
+      return;
+    }
+
+    if (!element_counts.empty() && element_counts.back()++ > 0) {
+      output += ", ";
+    }
+  }
+
+  void write_escaped_string(const std::string& value) {
+    output += '"';
+    for (size_t i = 0; i < value.length(); i++) {
+      const char ch = value[i];
+      if (ch == '\\') {
+        output += "\\\\";
+      } else if (ch == '"') {
+        output += "\\\"";
+      } else if (ch == '\b') {
+        output += "\\b";
+      } else if (ch == '\f') {
+        output += "\\f";
+      } else if (ch == '\n') {
+        output += "\\n";
+      } else if (ch == '\r') {
+        output += "\\r";
+      } else if (ch == '\t') {
+        output += "\\t";
+      } else if (static_cast<uint8_t>(ch) <= 0x1f) {
+        char buf[8];
+        snprintf(buf, sizeof buf, "\\u%04x", ch);
+        output += buf;
+      } else if (static_cast<uint8_t>(ch) == 0xe2 && i + 2 < value.length() &&
+                 static_cast<uint8_t>(value[i + 1]) == 0x80 &&
+                 static_cast<uint8_t>(value[i + 2]) == 0xa8) {
+        output += "\\u2028";
+        i += 2;
+      } else if (static_cast<uint8_t>(ch) == 0xe2 && i + 2 < value.length() &&
+                 static_cast<uint8_t>(value[i + 1]) == 0x80 &&
+                 static_cast<uint8_t>(value[i + 2]) == 0xa9) {
+        output += "\\u2029";
+        i += 2;
+      } else {
+        output += ch;
+      }
+    }
+    output += '"';
+  }
+
+  /**
+   * Returns "#" followed by the index of the given key if it is in the key
+   * dictionary. Keys that start with "#" themselves are escaped with another
+   * "#".
+   */
+  std::string encode_key(const std::string& key) const {
+    const auto index = key_dictionary->get_index(key);
+    if (index.has_value()) {
+      return "#" + std::to_string(index.value());
+    }
+
+    if (!key.empty() && key[0] == '#') {
+      return "#" + key;
+    }
+
+    return key;
+  }
+
+  void write_digits(uint64_t value) {
+    char buffer[20];
+    int length = 0;
+    do {
+      buffer[length++] = (char)('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+
+    while (length > 0) {
+      output += buffer[--length];
+    }
+  }
+
+ public:
+  JsonWriter(const CodecOptions options = CodecOptions())
+      : key_dictionary(options.key_dictionary) {}
+
+  void write_null() override {
+    begin_value();
+    output += "null";
+  }
+
+  void write_number(const double value) override {
+    begin_value();
+    if (std::isfinite(value)) {
+      char buf[32];
+      snprintf(buf, sizeof buf, "%.17g", value);
+      output += buf;
+    } else {
+      output += "null";
+    }
+  }
+
+  /**
+   * Writes the shortest decimal that reads back as the same float32, so 21.37f
+   * is written as 21.37 rather than 21.3700008.
+   */
+  void write_float32(const float value) override {
+    begin_value();
+    if (std::isfinite(value)) {
+      char buf[32];
+      for (int precision = 6; precision <= 9; precision += 1) {
+        snprintf(buf, sizeof buf, "%.*g", precision, value);
+        if ((float)std::strtod(buf, nullptr) == value) {
+          break;
+        }
+      }
+      output += buf;
+    } else {
+      output += "null";
+    }
+  }
+
+  void write_int(const int64_t value) override {
+    if (value >= 0) {
+      write_uint((uint64_t)value);
+      return;
+    }
+
+    begin_value();
+    output += '-';
+    write_digits(0 - (uint64_t)value);
+  }
+
+  void write_uint(const uint64_t value) override {
+    begin_value();
+    write_digits(value);
+  }
+
+  void write_bool(const bool value) override {
+    begin_value();
+    output += value ? "true" : "false";
+  }
+
+  void write_string(const std::string& value) override {
+    begin_value();
+    write_escaped_string(value);
+  }
+
+  void begin_array(const size_t size) override {
+    begin_value();
+    output += "[";
+    element_counts.push_back(0);
+  }
+
+  void end_array() override {
+    element_counts.pop_back();
+    output += "]";
+  }
+
+  void begin_object(const size_t size) override {
+    begin_value();
+    output += "{";
+    element_counts.push_back(0);
+  }
+
+  void write_key(const std::string& key) override {
+    begin_value();
+    if (key_dictionary) {
+      write_escaped_string(encode_key(key));
+    } else {
+      write_escaped_string(key);
+    }
+    output += ": ";
+    is_after_key = true;
+  }
+
+  void end_object() override {
+    element_counts.pop_back();
+    output += "}";
+  }
+
+  const std::string& get_output() const { return output; }
+};
+
 struct JsonCodec : public Codec {
  private:
+  CodecOptions options;
+
+  /**
+   * Reverses JsonWriter::encode_key. Unknown indices are kept as they are.
+   */
+  std::string decode_key(const std::string& key) const {
+    if (!options.key_dictionary || key.size() < 2 || key[0] != '#') {
+      return key;
+    }
+
+    if (key[1] == '#') {
+      return key.substr(1);
+    }
+
+    size_t index = 0;
+    for (size_t i = 1; i < key.size(); i += 1) {
+      if (key[i] < '0' || key[i] > '9' || i > 9) {
+        return key;
+      }
+      index = index * 10 + (key[i] - '0');
+    }
+
+    const auto dictionary_key = options.key_dictionary->get_key(index);
+    if (dictionary_key.has_value()) {
+      return dictionary_key.value();
+    }
+
+    return key;
+  }
+
   std::shared_ptr<data_object::GenericValue> json_to_data_object(
       const json11::Json& json) const {
     if (json.is_null()) {
@@ -42,7 +274,7 @@ struct JsonCodec : public Codec {
         auto key = item.first;
         auto json_value = item.second;
         auto value_data_object = json_to_data_object(json_value);
-        data_object_object[key] = value_data_object;
+        data_object_object[decode_key(key)] = value_data_object;
       }
 
       return data_object::create_object(data_object_object);
@@ -51,53 +283,9 @@ struct JsonCodec : public Codec {
     return data_object::create_null_value();
   }
 
-  json11::Json data_object_to_json(
-      const std::shared_ptr<data_object::GenericValue> data_object) const {
-    if (data_object->is_null()) {
-      return json11::Json();
-    }
-
-    if (data_object->is_number()) {
-      return json11::Json(data_object->number_value().value());
-    }
-
-    if (data_object->is_bool()) {
-      return json11::Json(data_object->bool_value().value());
-    }
-
-    if (data_object->is_string()) {
-      return json11::Json(data_object->string_value().value());
-    }
-
-    if (data_object->is_array()) {
-      auto data_object_array = data_object->array_items().value();
-      auto json_array = json11::Json::array();
-      json_array.reserve(data_object_array->size());
-      for (auto& element : *data_object_array) {
-        auto json_element = data_object_to_json(element);
-        json_array.push_back(json_element);
-      }
-
-      return json11::Json(json_array);
-    }
-
-    if (data_object->is_object()) {
-      auto data_object_items = data_object->object_items().value();
-      auto json_object = json11::Json::object();
-      for (auto& item : *data_object_items) {
-        auto key = item.first;
-        auto value = item.second;
-        auto json_value = data_object_to_json(value);
-        json_object[key] = json_value;
-      }
-
-      return json11::Json(json_object);
-    }
-
-    return json11::Json();
-  }
-
  public:
+  JsonCodec(const CodecOptions options = CodecOptions()) : options(options) {}
+
   tl::optional<std::shared_ptr<data_object::GenericValue>> decode(
       std::string encoded_data, std::string& error_string) const override {
     auto parsed_json = json11::Json::parse(encoded_data, error_string);
@@ -111,9 +299,10 @@ struct JsonCodec : public Codec {
 
   std::string encode(
       std::shared_ptr<data_object::GenericValue> data) const override {
-    auto json = data_object_to_json(data);
+    auto writer = JsonWriter(options);
+    data->write_to(writer);
 
-    return json.dump();
+    return writer.get_output();
   }
 
   DataFormat get_format() const override { return DataFormat::JSON; };
@@ -1,15 +1,285 @@
 #pragma once
 
+#include <cmath>
+#include <cstring>
+
 #include "Codec/Codec.h"
 #include "msgpack11/msgpack11.hpp"
 
+/**
+ * The MessagePack extension type that packed values are encoded with. The
+ * extension data starts with the schema hash as a little-endian uint32,
+ * followed by the packed fields.
+ */
+const int8_t packed_extension_type = 0x50;
+
+/**
+ * A data_object::Writer that serializes straight into MessagePack, producing
+ * the same bytes as msgpack11. Integers use the smallest MessagePack integer
+ * encoding that fits; doubles are written according to the NumberEncoding of
+ * the codec options. Object keys found in the key dictionary of the codec
+ * options are written as their index.
+ */
+struct MsgPackWriter : public data_object::Writer {
+ private:
+  std::string output;
+  CodecOptions options;
+  bool should_pack;
+
+  static bool is_whole_number(const double value) {
+    return std::isfinite(value) && std::floor(value) == value &&
+           value >= -9.2e18 && value <= 9.2e18 &&
+           !(value == 0 && std::signbit(value));
+  }
+
+  void write_float64(const double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    output += (char)0xcb;
+    write_big_endian(bits, 8);
+  }
+
+  void write_big_endian(const uint64_t value, const int byte_count) {
+    for (int i = byte_count - 1; i >= 0; i -= 1) {
+      output += (char)((value >> (i * 8)) & 0xff);
+    }
+  }
+
+  void write_extension_header(const size_t length, const int8_t type) {
+    if (length == 1) {
+      output += (char)0xd4;
+    } else if (length == 2) {
+      output += (char)0xd5;
+    } else if (length == 4) {
+      output += (char)0xd6;
+    } else if (length == 8) {
+      output += (char)0xd7;
+    } else if (length == 16) {
+      output += (char)0xd8;
+    } else if (length <= 0xff) {
+      output += (char)0xc7;
+      output += (char)length;
+    } else if (length <= 0xffff) {
+      output += (char)0xc8;
+      write_big_endian(length, 2);
+    } else {
+      output += (char)0xc9;
+      write_big_endian(length, 4);
+    }
+
+    output += (char)type;
+  }
+
+  void write_length(const size_t length, const uint8_t fix_marker,
+                    const size_t fix_max, const uint8_t marker_16,
+                    const uint8_t marker_32) {
+    if (length <= fix_max) {
+      output += (char)(fix_marker | length);
+    } else if (length <= 0xffff) {
+      output += (char)marker_16;
+      write_big_endian(length, 2);
+    } else {
+      output += (char)marker_32;
+      write_big_endian(length, 4);
+    }
+  }
+
+ public:
+  MsgPackWriter(const CodecOptions options = CodecOptions(),
+                const bool should_pack = false)
+      : options(options), should_pack(should_pack) {}
+
+  void write_null() override { output += (char)0xc0; }
+
+  void write_number(const double value) override {
+    switch (options.number_encoding) {
+      case NumberEncoding::COMPACT:
+        if (is_whole_number(value)) {
+          write_int((int64_t)value);
+        } else if ((double)(float)value == value) {
+          write_float32((float)value);
+        } else {
+          write_float64(value);
+        }
+        break;
+
+      case NumberEncoding::FLOAT32:
+        if (is_whole_number(value)) {
+          write_int((int64_t)value);
+        } else {
+          write_float32((float)value);
+        }
+        break;
+
+      default:
+        write_float64(value);
+    }
+  }
+
+  void write_float32(const float value) override {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    output += (char)0xca;
+    write_big_endian(bits, 4);
+  }
+
+  void write_int(const int64_t value) override {
+    if (value >= 0) {
+      write_uint((uint64_t)value);
+    } else if (value >= -32) {
+      output += (char)value;
+    } else if (value >= INT8_MIN) {
+      output += (char)0xd0;
+      write_big_endian((uint64_t)value, 1);
+    } else if (value >= INT16_MIN) {
+      output += (char)0xd1;
+      write_big_endian((uint64_t)value, 2);
+    } else if (value >= INT32_MIN) {
+      output += (char)0xd2;
+      write_big_endian((uint64_t)value, 4);
+    } else {
+      output += (char)0xd3;
+      write_big_endian((uint64_t)value, 8);
+    }
+  }
+
+  void write_uint(const uint64_t value) override {
+    if (value < 128) {
+      output += (char)value;
+    } else if (value <= UINT8_MAX) {
+      output += (char)0xcc;
+      write_big_endian(value, 1);
+    } else if (value <= UINT16_MAX) {
+      output += (char)0xcd;
+      write_big_endian(value, 2);
+    } else if (value <= UINT32_MAX) {
+      output += (char)0xce;
+      write_big_endian(value, 4);
+    } else {
+      output += (char)0xcf;
+      write_big_endian(value, 8);
+    }
+  }
+
+  void write_bool(const bool value) override {
+    output += (char)(value ? 0xc3 : 0xc2);
+  }
+
+  void write_string(const std::string& value) override {
+    const auto length = value.size();
+    if (length > 0x1f && length <= 0xff) {
+      output += (char)0xd9;
+      output += (char)length;
+    } else {
+      write_length(length, 0xa0, 0x1f, 0xda, 0xdb);
+    }
+
+    output += value;
+  }
+
+  void write_blob(const uint8_t* data, const size_t size) override {
+    if (size <= 0xff) {
+      output += (char)0xc4;
+      write_big_endian(size, 1);
+    } else if (size <= 0xffff) {
+      output += (char)0xc5;
+      write_big_endian(size, 2);
+    } else {
+      output += (char)0xc6;
+      write_big_endian(size, 4);
+    }
+
+    output.append((const char*)data, size);
+  }
+
+  void begin_array(const size_t size) override {
+    write_length(size, 0x90, 15, 0xdc, 0xdd);
+  }
+
+  void end_array() override {}
+
+  void begin_object(const size_t size) override {
+    write_length(size, 0x80, 15, 0xde, 0xdf);
+  }
+
+  void write_key(const std::string& key) override {
+    if (options.key_dictionary) {
+      const auto index = options.key_dictionary->get_index(key);
+      if (index.has_value()) {
+        write_uint(index.value());
+        return;
+      }
+    }
+
+    write_string(key);
+  }
+
+  void end_object() override {}
+
+  bool accepts_packed() const override { return should_pack; }
+
+  void write_packed(const uint32_t schema_hash,
+                    const std::string& bytes) override {
+    write_extension_header(4 + bytes.size(), packed_extension_type);
+    for (int i = 0; i < 4; i += 1) {
+      output += (char)((schema_hash >> (i * 8)) & 0xff);
+    }
+    output += bytes;
+  }
+
+  const std::string& get_output() const { return output; }
+};
+
 struct MsgPackCodec : public Codec {
+ protected:
+  CodecOptions options;
+
+ public:
+  MsgPackCodec(const CodecOptions options = CodecOptions())
+      : options(options) {}
+
+  /**
+   * Returns the key an object key on the wire stands for. Integer keys are
+   * looked up in the key dictionary; unknown ones are kept as their decimal
+   * representation.
+   */
+  std::string decode_key(const msgpack11::MsgPack& key) const {
+    if (!key.is_int()) {
+      return key.string_value();
+    }
+
+    if (options.key_dictionary && !key.is_uint64() && key.int64_value() >= 0) {
+      const auto dictionary_key =
+          options.key_dictionary->get_key((size_t)key.int64_value());
+      if (dictionary_key.has_value()) {
+        return dictionary_key.value();
+      }
+    }
+
+    return key.is_uint64() ? std::to_string(key.uint64_value())
+                           : std::to_string(key.int64_value());
+  }
+
   std::shared_ptr<data_object::GenericValue> msgpack_to_data_object(
       const msgpack11::MsgPack& msgpack) const {
     if (msgpack.is_null()) {
       return data_object::create_null_value();
     }
 
+    if (msgpack.is_int()) {
+      if (msgpack.is_uint64()) {
+        return data_object::create_uint_value(msgpack.uint64_value());
+      }
+
+      return data_object::create_int_value(msgpack.int64_value());
+    }
+
+    if (msgpack.is_float32()) {
+      return data_object::create_float32_value(msgpack.float32_value());
+    }
+
     if (msgpack.is_number()) {
       return data_object::create_number_value(msgpack.number_value());
     }
@@ -22,6 +292,10 @@ struct MsgPackCodec : public Codec {
       return data_object::create_string_value(msgpack.string_value());
     }
 
+    if (msgpack.is_binary()) {
+      return data_object::create_blob_value(msgpack.binary_items());
+    }
+
     if (msgpack.is_array()) {
       auto msgpack_array_items = msgpack.array_items();
       auto data_object_array = data_object::GenericValue::array();
@@ -38,62 +312,31 @@ struct MsgPackCodec : public Codec {
       auto msgpack_object_items = msgpack.object_items();
       auto data_object_object = data_object::GenericValue::object();
       for (auto& item : msgpack_object_items) {
-        auto key = item.first;
+        auto key = decode_key(item.first);
         auto msgpack_value = item.second;
         auto value_data_object = msgpack_to_data_object(msgpack_value);
-        data_object_object[key.string_value()] = value_data_object;
+        data_object_object[key] = value_data_object;
       }
 
       return data_object::create_object(data_object_object);
     }
 
-    return data_object::create_null_value();
-  }
+    if (msgpack.is_extension()) {
+      const auto& extension = msgpack.extension_items();
+      const auto& data = std::get<1>(extension);
 
-  msgpack11::MsgPack data_object_to_msgpack(
-      const std::shared_ptr<data_object::GenericValue> data_object) const {
-    if (data_object->is_null()) {
-      return msgpack11::MsgPack();
-    }
+      if (std::get<0>(extension) == packed_extension_type && data.size() >= 4) {
+        const uint32_t schema_hash = (uint32_t)data[0] |
+                                     ((uint32_t)data[1] << 8) |
+                                     ((uint32_t)data[2] << 16) |
+                                     ((uint32_t)data[3] << 24);
 
-    if (data_object->is_number()) {
-      return msgpack11::MsgPack(data_object->number_value().value());
-    }
-
-    if (data_object->is_bool()) {
-      return msgpack11::MsgPack(data_object->bool_value().value());
-    }
-
-    if (data_object->is_string()) {
-      return msgpack11::MsgPack(data_object->string_value().value());
-    }
-
-    if (data_object->is_array()) {
-      auto data_object_array = data_object->array_items().value();
-      auto msgpack_array = msgpack11::MsgPack::array();
-      msgpack_array.reserve(data_object_array->size());
-      for (auto& element : *data_object_array) {
-        auto msgpack_element = data_object_to_msgpack(element);
-        msgpack_array.push_back(msgpack_element);
+        return data_object::create_packed_value(
+            schema_hash, std::string(data.begin() + 4, data.end()));
       }
-
-      return msgpack11::MsgPack(msgpack_array);
     }
 
-    if (data_object->is_object()) {
-      auto data_object_items = data_object->object_items().value();
-      auto msgpack_object = msgpack11::MsgPack::object();
-      for (auto& item : *data_object_items) {
-        auto key = item.first;
-        auto value = item.second;
-        auto msgpack_value = data_object_to_msgpack(value);
-        msgpack_object[key] = msgpack_value;
-      }
-
-      return msgpack11::MsgPack(msgpack_object);
-    }
-
-    return msgpack11::MsgPack();
+    return data_object::create_null_value();
   }
 
  public:
@@ -110,9 +353,10 @@ struct MsgPackCodec : public Codec {
 
   std::string encode(
       std::shared_ptr<data_object::GenericValue> data) const override {
-    auto msgpack = data_object_to_msgpack(data);
+    auto writer = MsgPackWriter(options);
+    data->write_to(writer);
 
-    return msgpack.dump();
+    return writer.get_output();
   }
 
   DataFormat get_format() const override { return DataFormat::MSGPACK; };
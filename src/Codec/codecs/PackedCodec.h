@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MsgPackCodec.h"
+
+/**
+ * A MessagePack codec that encodes values which support it, such as
+ * TypedSynchronizables made of numeric fields, as fixed-layout binary records
+ * instead of key-value maps. Each record is carried in a MessagePack extension
+ * together with the hash of its schema; its fields are laid out back to back in
+ * declaration order, little-endian, at their natural widths.
+ */
+struct PackedCodec : public MsgPackCodec {
+  PackedCodec(const CodecOptions options = CodecOptions())
+      : MsgPackCodec(options) {}
+
+  std::string encode(
+      std::shared_ptr<data_object::GenericValue> data) const override {
+    auto writer = MsgPackWriter(options, true);
+    data->write_to(writer);
+
+    return writer.get_output();
+  }
+
+  DataFormat get_format() const override { return DataFormat::PACKED; };
+};
@@ -5,4 +5,5 @@
 enum class DataFormat {
   JSON = 0x01,
   MSGPACK = 0x02,
+  PACKED = 0x03,
 };
@@ -8,6 +8,9 @@ tl::optional<DataFormat> get_data_format_from_format_byte(uint8_t value) {
     case 0x02:
       return DataFormat::MSGPACK;
 
+    case 0x03:
+      return DataFormat::PACKED;
+
     default:
       return {};
   }
@@ -21,20 +24,27 @@ uint8_t get_format_byte_from_data_format(DataFormat format) {
     case DataFormat::MSGPACK:
       return 0x02;
 
+    case DataFormat::PACKED:
+      return 0x03;
+
     default:
       return 0x01;
   }
 }
 
-std::shared_ptr<Codec> create_codec_from_format(DataFormat format) {
+std::shared_ptr<Codec> create_codec_from_format(DataFormat format,
+                                                const CodecOptions options) {
   switch (format) {
     case DataFormat::JSON:
-      return std::make_shared<JsonCodec>();
+      return std::make_shared<JsonCodec>(options);
 
     case DataFormat::MSGPACK:
-      return std::make_shared<MsgPackCodec>();
+      return std::make_shared<MsgPackCodec>(options);
+
+    case DataFormat::PACKED:
+      return std::make_shared<PackedCodec>(options);
 
     default:
-      return std::make_shared<JsonCodec>();
+      return std::make_shared<JsonCodec>(options);
   }
 }
\ No newline at end of file
@@ -5,10 +5,46 @@
 #include "Codec/Codec.h"
 #include "Codec/codecs/JsonCodec.h"
 #include "Codec/codecs/MsgPackCodec.h"
+#include "Codec/codecs/PackedCodec.h"
 #include "DataFormat.h"
 
+/**
+ * Set in the format byte of a packet whose encoding is LZF-compressed.
+ */
+const uint8_t compressed_format_flag = 0x80;
+
+/**
+ * Set in the format byte of a packet that carries one fragment of a larger
+ * packet.
+ */
+const uint8_t fragment_format_flag = 0x40;
+
+/**
+ * Set in the format byte of a packet that ends with a CRC32 of all its
+ * preceding bytes.
+ */
+const uint8_t checksum_format_flag = 0x20;
+
+/**
+ * The size of the big-endian CRC32 at the end of a packet with a checksum.
+ */
+const size_t checksum_size = 4;
+
+/**
+ * The size of the format byte, message ID, fragment index, and fragment count
+ * that precede the data of a fragment.
+ */
+const size_t fragment_header_size = 8;
+
+/**
+ * The largest number of fragments a packet can be split into, since the
+ * fragment count is sent in 2 bytes.
+ */
+const size_t max_fragment_count = 0xffff;
+
 tl::optional<DataFormat> get_data_format_from_format_byte(uint8_t value);
 
 uint8_t get_format_byte_from_data_format(DataFormat format);
 
-std::shared_ptr<Codec> create_codec_from_format(DataFormat format);
\ No newline at end of file
+std::shared_ptr<Codec> create_codec_from_format(
+    DataFormat format, const CodecOptions options = CodecOptions());
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "Base64.h"
+
+namespace base64 {
+namespace {
+const char alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int get_sextet(const char character) {
+  if (character >= 'A' && character <= 'Z') {
+    return character - 'A';
+  }
+  if (character >= 'a' && character <= 'z') {
+    return character - 'a' + 26;
+  }
+  if (character >= '0' && character <= '9') {
+    return character - '0' + 52;
+  }
+  if (character == '+') {
+    return 62;
+  }
+  if (character == '/') {
+    return 63;
+  }
+
+  return -1;
+}
+}  // namespace
+
+/**
+ * Encodes the given bytes as padded base64 with the standard alphabet.
+ */
+std::string encode(const uint8_t *data, const size_t size) {
+  std::string result;
+  result.reserve((size + 2) / 3 * 4);
+
+  for (size_t i = 0; i < size; i += 3) {
+    const uint32_t remaining = size - i;
+    uint32_t triple = (uint32_t)data[i] << 16;
+    if (remaining > 1) {
+      triple |= (uint32_t)data[i + 1] << 8;
+    }
+    if (remaining > 2) {
+      triple |= data[i + 2];
+    }
+
+    result += alphabet[(triple >> 18) & 0x3f];
+    result += alphabet[(triple >> 12) & 0x3f];
+    result += remaining > 1 ? alphabet[(triple >> 6) & 0x3f] : '=';
+    result += remaining > 2 ? alphabet[triple & 0x3f] : '=';
+  }
+
+  return result;
+}
+
+/**
+ * Decodes padded base64 with the standard alphabet. Returns an empty optional
+ * if the input is not valid base64.
+ */
+tl::optional<std::vector<uint8_t>> decode(const std::string &encoded) {
+  if (encoded.size() % 4 != 0) {
+    return {};
+  }
+
+  std::vector<uint8_t> result;
+  result.reserve(encoded.size() / 4 * 3);
+
+  for (size_t i = 0; i < encoded.size(); i += 4) {
+    const auto is_last_group = i + 4 == encoded.size();
+    const auto padding = is_last_group ? (encoded[i + 3] == '=') +
+                                             (encoded[i + 2] == '=')
+                                       : 0;
+    if (padding == 1 && encoded[i + 2] == '=') {
+      return {};
+    }
+
+    uint32_t triple = 0;
+    for (size_t j = 0; j < 4 - (size_t)padding; j += 1) {
+      const auto sextet = get_sextet(encoded[i + j]);
+      if (sextet < 0) {
+        return {};
+      }
+
+      triple |= (uint32_t)sextet << (18 - 6 * j);
+    }
+
+    result.push_back((triple >> 16) & 0xff);
+    if (padding < 2) {
+      result.push_back((triple >> 8) & 0xff);
+    }
+    if (padding < 1) {
+      result.push_back(triple & 0xff);
+    }
+  }
+
+  return result;
+}
+}  // namespace base64
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "optional/include/tl/optional.hpp"
+
+namespace base64 {
+std::string encode(const uint8_t *data, const size_t size);
+
+tl::optional<std::vector<uint8_t>> decode(const std::string &encoded);
+}  // namespace base64
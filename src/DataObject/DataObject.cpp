@@ -1,6 +1,18 @@
 #include "DataObject.h"
 
+#include "Writer/TreeWriter.h"
+
 namespace data_object {
+const GenericValue &EncodableValue::get_tree() const {
+  if (!tree) {
+    auto writer = TreeWriter();
+    write_to(writer);
+    tree = writer.get_result();
+  }
+
+  return *tree;
+}
+
 std::shared_ptr<GenericValue> create_null_value() {
   return std::make_shared<NullValue>();
 }
@@ -9,6 +21,18 @@ std::shared_ptr<GenericValue> create_number_value(double value) {
   return std::make_shared<NumberValue>(value);
 }
 
+std::shared_ptr<GenericValue> create_float32_value(float value) {
+  return std::make_shared<NumberValue>(value);
+}
+
+std::shared_ptr<GenericValue> create_int_value(int64_t value) {
+  return std::make_shared<NumberValue>(value);
+}
+
+std::shared_ptr<GenericValue> create_uint_value(uint64_t value) {
+  return std::make_shared<NumberValue>(value);
+}
+
 std::shared_ptr<GenericValue> create_bool_value(bool value) {
   return std::make_shared<BoolValue>(value);
 }
@@ -17,6 +41,15 @@ std::shared_ptr<GenericValue> create_string_value(std::string value) {
   return std::make_shared<StringValue>(value);
 }
 
+std::shared_ptr<GenericValue> create_blob_value(std::vector<uint8_t> value) {
+  return std::make_shared<BlobValue>(std::move(value));
+}
+
+std::shared_ptr<GenericValue> create_blob_value(const uint8_t *data,
+                                                size_t size) {
+  return std::make_shared<BlobValue>(std::vector<uint8_t>(data, data + size));
+}
+
 std::shared_ptr<Array> create_array(GenericValue::array value) {
   auto shared_pointer = std::make_shared<GenericValue::array>(value);
   return std::make_shared<Array>(shared_pointer);
@@ -26,4 +59,9 @@ std::shared_ptr<Object> create_object(GenericValue::object value) {
   auto shared_pointer = std::make_shared<GenericValue::object>(value);
   return std::make_shared<Object>(shared_pointer);
 }
+
+std::shared_ptr<GenericValue> create_packed_value(uint32_t schema_hash,
+                                                  std::string bytes) {
+  return std::make_shared<PackedValue>(schema_hash, bytes);
+}
 }
\ No newline at end of file
@@ -2,15 +2,28 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "Writer/Writer.h"
 #include "optional/include/tl/optional.hpp"
 
 namespace data_object {
+/**
+ * A read-only view of binary data owned by a data object. It is valid as long
+ * as the data object is.
+ */
+struct BlobView {
+  const uint8_t *data;
+  size_t size;
+
+  BlobView(const uint8_t *data, size_t size) : data(data), size(size) {}
+};
+
 struct GenericValue {
   typedef std::vector<std::shared_ptr<GenericValue>> array;
   typedef std::map<std::string, std::shared_ptr<GenericValue>> object;
@@ -19,13 +32,18 @@ struct GenericValue {
   virtual bool is_number() const { return false; }
   virtual bool is_bool() const { return false; }
   virtual bool is_string() const { return false; }
+  virtual bool is_blob() const { return false; }
   virtual bool is_array() const { return false; }
   virtual bool is_object() const { return false; }
+  virtual bool is_packed() const { return false; }
+  virtual bool is_integer() const { return false; }
 
   virtual tl::optional<double> number_value() const { return {}; }
   virtual tl::optional<int64_t> int_value() const { return {}; }
+  virtual tl::optional<uint64_t> uint_value() const { return {}; }
   virtual tl::optional<bool> bool_value() const { return {}; }
   virtual const tl::optional<std::string> string_value() const { return {}; }
+  virtual tl::optional<BlobView> blob_value() const { return {}; }
   virtual const tl::optional<std::shared_ptr<GenericValue::array>> array_items()
       const {
     return {};
@@ -42,6 +60,8 @@ struct GenericValue {
       const std::string &key) const {
     return {};
   }
+  virtual tl::optional<uint32_t> packed_schema_hash() const { return {}; }
+  virtual const tl::optional<std::string> packed_bytes() const { return {}; }
 
   virtual std::string to_debug_string() const { return ""; }
 
@@ -49,6 +69,12 @@ struct GenericValue {
     return false;
   }
 
+  /**
+   * Writes this value to the given writer, e.g. to serialize it directly into
+   * a codec’s wire format.
+   */
+  virtual void write_to(Writer &writer) const { writer.write_null(); }
+
   virtual ~GenericValue() {}
 };
 
@@ -57,29 +83,127 @@ struct NullValue : public GenericValue {
 
   std::string to_debug_string() const override { return "null"; }
 
+  void write_to(Writer &writer) const override { writer.write_null(); }
+
   bool equals(const std::shared_ptr<GenericValue> other) const override {
     return other->is_null();
   }
 };
 
+/**
+ * A number, stored either as a double, as a float32 if only single precision
+ * is needed, or, if it was created from an integer, as an exact 64-bit
+ * integer. Integers are kept as int64 unless they are too large, in which case
+ * they are kept as uint64.
+ */
 struct NumberValue : public GenericValue {
  private:
-  double value;
+  enum class Representation { DOUBLE, FLOAT32, INT64, UINT64 };
+
+  Representation representation;
+  double double_value = 0;
+  int64_t int64_value = 0;
+  uint64_t uint64_value = 0;
 
  public:
-  NumberValue(double value) : value(value) {}
+  NumberValue(double value)
+      : representation(Representation::DOUBLE), double_value(value) {}
+  NumberValue(float value)
+      : representation(Representation::FLOAT32), double_value(value) {}
+  NumberValue(int64_t value)
+      : representation(Representation::INT64), int64_value(value) {}
+  NumberValue(uint64_t value)
+      : representation(value <= (uint64_t)INT64_MAX ? Representation::INT64
+                                                    : Representation::UINT64),
+        int64_value((int64_t)value),
+        uint64_value(value) {}
 
   bool is_number() const override { return true; }
-  tl::optional<double> number_value() const override { return value; }
-  tl::optional<int64_t> int_value() const override { return std::round(value); }
+  bool is_integer() const override {
+    return representation == Representation::INT64 ||
+           representation == Representation::UINT64;
+  }
+
+  tl::optional<double> number_value() const override {
+    switch (representation) {
+      case Representation::INT64:
+        return (double)int64_value;
+      case Representation::UINT64:
+        return (double)uint64_value;
+      default:
+        return double_value;
+    }
+  }
+  tl::optional<int64_t> int_value() const override {
+    switch (representation) {
+      case Representation::INT64:
+        return int64_value;
+      case Representation::UINT64:
+        return {};
+      default:
+        return std::round(double_value);
+    }
+  }
+  tl::optional<uint64_t> uint_value() const override {
+    switch (representation) {
+      case Representation::INT64:
+        if (int64_value < 0) {
+          return {};
+        }
+        return (uint64_t)int64_value;
+      case Representation::UINT64:
+        return uint64_value;
+      default:
+        if (double_value < 0) {
+          return {};
+        }
+        return (uint64_t)std::round(double_value);
+    }
+  }
+
+  std::string to_debug_string() const override {
+    switch (representation) {
+      case Representation::INT64:
+        return std::to_string((long long)int64_value);
+      case Representation::UINT64:
+        return std::to_string((unsigned long long)uint64_value);
+      default:
+        return std::to_string(double_value);
+    }
+  }
 
-  std::string to_debug_string() const override { return std::to_string(value); }
+  void write_to(Writer &writer) const override {
+    switch (representation) {
+      case Representation::INT64:
+        writer.write_int(int64_value);
+        break;
+      case Representation::UINT64:
+        writer.write_uint(uint64_value);
+        break;
+      case Representation::FLOAT32:
+        writer.write_float32((float)double_value);
+        break;
+      default:
+        writer.write_number(double_value);
+    }
+  }
 
   bool equals(const std::shared_ptr<GenericValue> other) const override {
-    if (other->is_number()) {
-      return value == other->number_value().value();
+    if (!other->is_number()) {
+      return false;
     }
-    return false;
+
+    if (is_integer() && other->is_integer()) {
+      if (representation == Representation::UINT64) {
+        const auto other_value = other->uint_value();
+        return other_value.has_value() && other_value.value() == uint64_value;
+      }
+
+      const auto other_value = other->int_value();
+      return other_value.has_value() && other_value.value() == int64_value;
+    }
+
+    return number_value().value() == other->number_value().value();
   }
 };
 
@@ -97,6 +221,8 @@ struct BoolValue : public GenericValue {
     return value ? "true" : "false";
   }
 
+  void write_to(Writer &writer) const override { writer.write_bool(value); }
+
   bool equals(const std::shared_ptr<GenericValue> other) const override {
     if (other->is_bool()) {
       return value == other->bool_value().value();
@@ -119,6 +245,8 @@ struct StringValue : public GenericValue {
 
   std::string to_debug_string() const override { return value; }
 
+  void write_to(Writer &writer) const override { writer.write_string(value); }
+
   bool equals(const std::shared_ptr<GenericValue> other) const override {
     if (other->is_string()) {
       return value == other->string_value().value();
@@ -127,6 +255,40 @@ struct StringValue : public GenericValue {
   }
 };
 
+/**
+ * Binary data. MessagePack carries it as bin; JSON as a base64 string, which
+ * is decoded as a StringValue on the receiving side.
+ */
+struct BlobValue : public GenericValue {
+ private:
+  std::vector<uint8_t> value;
+
+ public:
+  BlobValue(std::vector<uint8_t> value) : value(std::move(value)) {}
+
+  bool is_blob() const override { return true; }
+  tl::optional<BlobView> blob_value() const override {
+    return BlobView(value.data(), value.size());
+  }
+
+  std::string to_debug_string() const override {
+    return "blob(" + std::to_string(value.size()) + " bytes)";
+  }
+
+  void write_to(Writer &writer) const override {
+    writer.write_blob(value.data(), value.size());
+  }
+
+  bool equals(const std::shared_ptr<GenericValue> other) const override {
+    if (other->is_blob()) {
+      const auto other_value = other->blob_value().value();
+      return other_value.size == value.size() &&
+             std::equal(value.begin(), value.end(), other_value.data);
+    }
+    return false;
+  }
+};
+
 struct Array : public GenericValue {
  private:
   std::shared_ptr<GenericValue::array> value;
@@ -162,6 +324,14 @@ struct Array : public GenericValue {
     return result + "]";
   }
 
+  void write_to(Writer &writer) const override {
+    writer.begin_array(value->size());
+    for (const auto &element : *value) {
+      element->write_to(writer);
+    }
+    writer.end_array();
+  }
+
   bool equals(const std::shared_ptr<GenericValue> other) const override {
     if (!other->is_array()) {
       return false;
@@ -218,6 +388,15 @@ struct Object : public GenericValue {
     return result + "}";
   }
 
+  void write_to(Writer &writer) const override {
+    writer.begin_object(value->size());
+    for (const auto &item : *value) {
+      writer.write_key(item.first);
+      item.second->write_to(writer);
+    }
+    writer.end_object();
+  }
+
   bool equals(const std::shared_ptr<GenericValue> other) const override {
     if (!other->is_object()) {
       return false;
@@ -246,15 +425,143 @@ struct Object : public GenericValue {
   }
 };
 
+/**
+ * A fixed-layout binary record as produced by the packed codec, identified by
+ * the hash of the schema it was packed with.
+ */
+struct PackedValue : public GenericValue {
+ private:
+  uint32_t schema_hash;
+  std::string bytes;
+
+ public:
+  PackedValue(uint32_t schema_hash, std::string bytes)
+      : schema_hash(schema_hash), bytes(bytes) {}
+
+  bool is_packed() const override { return true; }
+  tl::optional<uint32_t> packed_schema_hash() const override {
+    return schema_hash;
+  }
+  const tl::optional<std::string> packed_bytes() const override {
+    return bytes;
+  }
+
+  std::string to_debug_string() const override {
+    return "packed(" + std::to_string(schema_hash) + ", " +
+           std::to_string(bytes.size()) + " bytes)";
+  }
+
+  bool equals(const std::shared_ptr<GenericValue> other) const override {
+    if (other->is_packed()) {
+      return schema_hash == other->packed_schema_hash().value() &&
+             bytes == other->packed_bytes().value();
+    }
+    return false;
+  }
+
+  void write_to(Writer &writer) const override {
+    writer.write_packed(schema_hash, bytes);
+  }
+};
+
+/**
+ * A value that knows how to write itself to a Writer, e.g. a typed struct that
+ * serializes its fields straight into a codec’s wire format. Subclasses only
+ * implement write_to; all other accessors are answered from a tree that is
+ * built from write_to the first time it is needed.
+ */
+struct EncodableValue : public GenericValue {
+ private:
+  mutable std::shared_ptr<GenericValue> tree;
+
+  const GenericValue &get_tree() const;
+
+ public:
+  bool is_null() const override { return get_tree().is_null(); }
+  bool is_number() const override { return get_tree().is_number(); }
+  bool is_bool() const override { return get_tree().is_bool(); }
+  bool is_string() const override { return get_tree().is_string(); }
+  bool is_blob() const override { return get_tree().is_blob(); }
+  bool is_array() const override { return get_tree().is_array(); }
+  bool is_object() const override { return get_tree().is_object(); }
+  bool is_packed() const override { return get_tree().is_packed(); }
+  bool is_integer() const override { return get_tree().is_integer(); }
+
+  tl::optional<double> number_value() const override {
+    return get_tree().number_value();
+  }
+  tl::optional<int64_t> int_value() const override {
+    return get_tree().int_value();
+  }
+  tl::optional<uint64_t> uint_value() const override {
+    return get_tree().uint_value();
+  }
+  tl::optional<bool> bool_value() const override {
+    return get_tree().bool_value();
+  }
+  const tl::optional<std::string> string_value() const override {
+    return get_tree().string_value();
+  }
+  tl::optional<BlobView> blob_value() const override {
+    return get_tree().blob_value();
+  }
+  const tl::optional<std::shared_ptr<GenericValue::array>> array_items()
+      const override {
+    return get_tree().array_items();
+  }
+  const tl::optional<std::shared_ptr<GenericValue>> operator[](
+      size_t i) const override {
+    return get_tree()[i];
+  }
+  const tl::optional<std::shared_ptr<GenericValue::object>> object_items()
+      const override {
+    return get_tree().object_items();
+  }
+  const tl::optional<std::shared_ptr<GenericValue>> operator[](
+      const std::string &key) const override {
+    return get_tree()[key];
+  }
+  tl::optional<uint32_t> packed_schema_hash() const override {
+    return get_tree().packed_schema_hash();
+  }
+  const tl::optional<std::string> packed_bytes() const override {
+    return get_tree().packed_bytes();
+  }
+
+  std::string to_debug_string() const override {
+    return get_tree().to_debug_string();
+  }
+
+  bool equals(const std::shared_ptr<GenericValue> other) const override {
+    return get_tree().equals(other);
+  }
+
+  void write_to(Writer &writer) const override = 0;
+};
+
 std::shared_ptr<GenericValue> create_null_value();
 
 std::shared_ptr<GenericValue> create_number_value(double value);
 
+std::shared_ptr<GenericValue> create_float32_value(float value);
+
+std::shared_ptr<GenericValue> create_int_value(int64_t value);
+
+std::shared_ptr<GenericValue> create_uint_value(uint64_t value);
+
 std::shared_ptr<GenericValue> create_bool_value(bool value);
 
 std::shared_ptr<GenericValue> create_string_value(std::string value);
 
+std::shared_ptr<GenericValue> create_blob_value(std::vector<uint8_t> value);
+
+std::shared_ptr<GenericValue> create_blob_value(const uint8_t *data,
+                                                size_t size);
+
 std::shared_ptr<Array> create_array(GenericValue::array value);
 
 std::shared_ptr<Object> create_object(GenericValue::object value);
+
+std::shared_ptr<GenericValue> create_packed_value(uint32_t schema_hash,
+                                                  std::string bytes);
 }  // namespace data_object
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "TreeWriter.h"
+
+namespace data_object {
+void TreeWriter::add_value(const std::shared_ptr<GenericValue> value) {
+  if (containers.empty()) {
+    result = value;
+    return;
+  }
+
+  auto &container = containers.back();
+  if (container.is_object) {
+    container.object_items[container.key] = value;
+  } else {
+    container.array_items.push_back(value);
+  }
+}
+
+void TreeWriter::write_null() { add_value(create_null_value()); }
+
+void TreeWriter::write_number(const double value) {
+  add_value(create_number_value(value));
+}
+
+void TreeWriter::write_float32(const float value) {
+  add_value(create_float32_value(value));
+}
+
+void TreeWriter::write_int(const int64_t value) {
+  add_value(create_int_value(value));
+}
+
+void TreeWriter::write_uint(const uint64_t value) {
+  add_value(create_uint_value(value));
+}
+
+void TreeWriter::write_bool(const bool value) {
+  add_value(create_bool_value(value));
+}
+
+void TreeWriter::write_string(const std::string &value) {
+  add_value(create_string_value(value));
+}
+
+void TreeWriter::write_blob(const uint8_t *data, const size_t size) {
+  add_value(create_blob_value(data, size));
+}
+
+void TreeWriter::begin_array(const size_t size) {
+  containers.push_back(Container(false));
+  containers.back().array_items.reserve(size);
+}
+
+void TreeWriter::end_array() {
+  const auto array = create_array(containers.back().array_items);
+  containers.pop_back();
+
+  add_value(array);
+}
+
+void TreeWriter::begin_object(const size_t size) {
+  containers.push_back(Container(true));
+}
+
+void TreeWriter::write_key(const std::string &key) {
+  containers.back().key = key;
+}
+
+void TreeWriter::end_object() {
+  const auto object = create_object(containers.back().object_items);
+  containers.pop_back();
+
+  add_value(object);
+}
+
+void TreeWriter::write_packed(const uint32_t schema_hash,
+                              const std::string &bytes) {
+  add_value(create_packed_value(schema_hash, bytes));
+}
+
+/**
+ * Returns the value that was written, or a null value if nothing was written.
+ */
+std::shared_ptr<GenericValue> TreeWriter::get_result() const {
+  if (!result) {
+    return create_null_value();
+  }
+
+  return result;
+}
+}  // namespace data_object
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../DataObject.h"
+#include "Writer.h"
+
+namespace data_object {
+/**
+ * A Writer that builds a tree of GenericValues from what is written to it.
+ */
+struct TreeWriter : public Writer {
+ private:
+  struct Container {
+    bool is_object;
+    GenericValue::array array_items;
+    GenericValue::object object_items;
+    std::string key;
+
+    Container(const bool is_object) : is_object(is_object) {}
+  };
+
+  std::vector<Container> containers;
+  std::shared_ptr<GenericValue> result;
+
+  void add_value(const std::shared_ptr<GenericValue> value);
+
+ public:
+  void write_null() override;
+  void write_number(const double value) override;
+  void write_float32(const float value) override;
+  void write_int(const int64_t value) override;
+  void write_uint(const uint64_t value) override;
+  void write_bool(const bool value) override;
+  void write_string(const std::string &value) override;
+  void write_blob(const uint8_t *data, const size_t size) override;
+
+  void begin_array(const size_t size) override;
+  void end_array() override;
+
+  void begin_object(const size_t size) override;
+  void write_key(const std::string &key) override;
+  void end_object() override;
+
+  void write_packed(const uint32_t schema_hash,
+                    const std::string &bytes) override;
+
+  std::shared_ptr<GenericValue> get_result() const;
+};
+}  // namespace data_object
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "../Base64/Base64.h"
+
+namespace data_object {
+/**
+ * An abstract base class for serializers that data objects can be written to
+ * value by value, without building an intermediate tree. Codecs implement it
+ * for their wire format.
+ *
+ * Arrays and objects are announced with their number of elements. Inside an
+ * object, every value is preceded by a call to write_key.
+ *
+ * Blobs are written as base64 strings by writers whose format has no binary
+ * type. Packed values are fixed-layout binary records identified by a schema
+ * hash; writers whose format cannot carry them write null instead.
+ */
+struct Writer {
+  virtual void write_null() = 0;
+  virtual void write_number(const double value) = 0;
+  virtual void write_float32(const float value) { write_number(value); }
+  virtual void write_int(const int64_t value) { write_number((double)value); }
+  virtual void write_uint(const uint64_t value) { write_number((double)value); }
+  virtual void write_bool(const bool value) = 0;
+  virtual void write_string(const std::string &value) = 0;
+  virtual void write_blob(const uint8_t *data, const size_t size) {
+    write_string(base64::encode(data, size));
+  }
+
+  virtual void begin_array(const size_t size) = 0;
+  virtual void end_array() = 0;
+
+  virtual void begin_object(const size_t size) = 0;
+  virtual void write_key(const std::string &key) = 0;
+  virtual void end_object() = 0;
+
+  /**
+   * Returns true if values that can be packed should be written with
+   * write_packed instead of field by field.
+   */
+  virtual bool accepts_packed() const { return false; }
+
+  virtual void write_packed(const uint32_t schema_hash,
+                            const std::string &bytes) {
+    write_null();
+  }
+
+  virtual ~Writer() = default;
+};
+}  // namespace data_object
@@ -24,15 +24,21 @@
 
 /*!
  * \file ErriezCRC32.c
- * \brief Flash size optimized CRC32 library for Arduino without using CRC tables
+ * \brief CRC32 library for Arduino with a selectable, optionally table-free
+ *      implementation
  * \details
  *      Source:         https://github.com/Erriez/ErriezCRC32
  *      Documentation:  https://erriez.github.io/ErriezCRC32
  */
 
-#include <string.h> // Needed for strlen()
+#include <string.h> // Needed for strlen() and memcpy()
 
 #include "ErriezCRC32.h"
+#include "ErriezCRC32Tables.h"
+
+#if CRC32_HAS_HARDWARE
+#include <arm_acle.h>
+#endif
 
 
 /*!
@@ -83,6 +89,30 @@ uint32_t crc32Buffer(const void *buffer, size_t bufferLength)
  *      32-bit updated CRC value.
  */
 uint32_t crc32Update(const void *buffer, size_t bufferLength, uint32_t crc)
+{
+#if CRC32_IMPLEMENTATION == CRC32_BITWISE
+    return crc32UpdateBitwise(buffer, bufferLength, crc);
+#elif CRC32_IMPLEMENTATION == CRC32_NIBBLE_TABLE
+    return crc32UpdateNibbleTable(buffer, bufferLength, crc);
+#elif CRC32_IMPLEMENTATION == CRC32_BYTE_TABLE
+    return crc32UpdateByteTable(buffer, bufferLength, crc);
+#elif CRC32_IMPLEMENTATION == CRC32_SLICE_BY_8
+    return crc32UpdateSliceBy8(buffer, bufferLength, crc);
+#elif CRC32_IMPLEMENTATION == CRC32_HARDWARE
+    return crc32UpdateHardware(buffer, bufferLength, crc);
+#else
+#error "Unknown CRC32_IMPLEMENTATION"
+#endif
+}
+
+#if CRC32_HAS_BITWISE
+/*!
+ * \brief crc32Update() one bit at a time, without a table.
+ * \details
+ *      8 shift/xor steps per Byte. Smallest code, slowest.
+ */
+uint32_t crc32UpdateBitwise(const void *buffer, size_t bufferLength,
+                            uint32_t crc)
 {
     size_t i;
     int8_t j;
@@ -98,6 +128,115 @@ uint32_t crc32Update(const void *buffer, size_t bufferLength, uint32_t crc)
 
     return crc;
 }
+#endif
+
+#if CRC32_HAS_NIBBLE_TABLE
+/*!
+ * \brief crc32Update() four bits at a time.
+ * \details
+ *      Uses a 64 Byte table; intended for flash constrained targets such as
+ *      the ESP8266.
+ */
+uint32_t crc32UpdateNibbleTable(const void *buffer, size_t bufferLength,
+                                uint32_t crc)
+{
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    size_t i;
+
+    for (i = 0; i < bufferLength; i++) {
+        crc = crc32NibbleTable[(crc ^ bytes[i]) & 0x0f] ^ (crc >> 4);
+        crc = crc32NibbleTable[(crc ^ (bytes[i] >> 4)) & 0x0f] ^ (crc >> 4);
+    }
+
+    return crc;
+}
+#endif
+
+#if CRC32_HAS_BYTE_TABLE
+/*!
+ * \brief crc32Update() one Byte at a time.
+ * \details
+ *      Uses a 1 KiB table.
+ */
+uint32_t crc32UpdateByteTable(const void *buffer, size_t bufferLength,
+                              uint32_t crc)
+{
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    size_t i;
+
+    for (i = 0; i < bufferLength; i++) {
+        crc = crc32Tables[0][(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+#endif
+
+#if CRC32_HAS_SLICE_BY_8
+/*!
+ * \brief crc32Update() eight Bytes at a time.
+ * \details
+ *      Uses 8 KiB of tables. The input is read Byte by Byte, so neither the
+ *      alignment of the buffer nor the endianness of the target matter.
+ */
+uint32_t crc32UpdateSliceBy8(const void *buffer, size_t bufferLength,
+                             uint32_t crc)
+{
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    uint32_t low;
+    uint32_t high;
+
+    while (bufferLength >= 8) {
+        low = crc ^ ((uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+                     ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24));
+        high = (uint32_t)bytes[4] | ((uint32_t)bytes[5] << 8) |
+               ((uint32_t)bytes[6] << 16) | ((uint32_t)bytes[7] << 24);
+
+        crc = crc32Tables[7][low & 0xff] ^
+              crc32Tables[6][(low >> 8) & 0xff] ^
+              crc32Tables[5][(low >> 16) & 0xff] ^
+              crc32Tables[4][low >> 24] ^
+              crc32Tables[3][high & 0xff] ^
+              crc32Tables[2][(high >> 8) & 0xff] ^
+              crc32Tables[1][(high >> 16) & 0xff] ^
+              crc32Tables[0][high >> 24];
+
+        bytes += 8;
+        bufferLength -= 8;
+    }
+
+    while (bufferLength--) {
+        crc = crc32Tables[0][(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+#endif
+
+#if CRC32_HAS_HARDWARE
+/*!
+ * \brief crc32Update() with the ARMv8 CRC32 instructions.
+ */
+uint32_t crc32UpdateHardware(const void *buffer, size_t bufferLength,
+                             uint32_t crc)
+{
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    uint64_t word;
+
+    while (bufferLength >= 8) {
+        memcpy(&word, bytes, sizeof(word));
+        crc = __crc32d(crc, word);
+        bytes += 8;
+        bufferLength -= 8;
+    }
+
+    while (bufferLength--) {
+        crc = __crc32b(crc, *bytes++);
+    }
+
+    return crc;
+}
+#endif
 
 /*!
  * \brief Finalize CRC32 output
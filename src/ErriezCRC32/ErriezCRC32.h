@@ -50,12 +50,90 @@ extern "C" {
  */
 #define CRC32_POLYNOMIAL    0xEDB88320UL
 
+/*!
+ * \brief CRC32 implementations, selected with CRC32_IMPLEMENTATION
+ */
+#define CRC32_BITWISE       0 //!< One bit at a time, no table
+#define CRC32_NIBBLE_TABLE  1 //!< 16 entry table, 64 Bytes of flash
+#define CRC32_BYTE_TABLE    2 //!< 256 entry table, 1 KiB of flash
+#define CRC32_SLICE_BY_8    3 //!< 8 tables of 256 entries, 8 KiB of flash
+#define CRC32_HARDWARE      4 //!< ARMv8 CRC32 instructions
+
+#if defined(__ARM_FEATURE_CRC32) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CRC32_HARDWARE_AVAILABLE 1
+#else
+#define CRC32_HARDWARE_AVAILABLE 0
+#endif
+
+/*!
+ * \brief Implementation used by crc32Update()
+ * \details
+ *      Defaults to the smallest table on ESP8266, the byte table on ESP32 and
+ *      the fastest available implementation everywhere else.
+ */
+#ifndef CRC32_IMPLEMENTATION
+#if defined(ESP8266)
+#define CRC32_IMPLEMENTATION CRC32_NIBBLE_TABLE
+#elif defined(ESP32)
+#define CRC32_IMPLEMENTATION CRC32_BYTE_TABLE
+#elif CRC32_HARDWARE_AVAILABLE
+#define CRC32_IMPLEMENTATION CRC32_HARDWARE
+#else
+#define CRC32_IMPLEMENTATION CRC32_SLICE_BY_8
+#endif
+#endif
+
+#if CRC32_IMPLEMENTATION == CRC32_HARDWARE && !CRC32_HARDWARE_AVAILABLE
+#error "CRC32_HARDWARE requires a little-endian ARMv8 target with CRC32"
+#endif
+
+/*
+ * Only the selected implementation is compiled in, unless
+ * CRC32_ALL_IMPLEMENTATIONS is defined (e.g. to benchmark them against each
+ * other).
+ */
+#if defined(CRC32_ALL_IMPLEMENTATIONS)
+#define CRC32_HAS_BITWISE       1
+#define CRC32_HAS_NIBBLE_TABLE  1
+#define CRC32_HAS_BYTE_TABLE    1
+#define CRC32_HAS_SLICE_BY_8    1
+#define CRC32_HAS_HARDWARE      CRC32_HARDWARE_AVAILABLE
+#else
+#define CRC32_HAS_BITWISE       (CRC32_IMPLEMENTATION == CRC32_BITWISE)
+#define CRC32_HAS_NIBBLE_TABLE  (CRC32_IMPLEMENTATION == CRC32_NIBBLE_TABLE)
+#define CRC32_HAS_BYTE_TABLE    (CRC32_IMPLEMENTATION == CRC32_BYTE_TABLE)
+#define CRC32_HAS_SLICE_BY_8    (CRC32_IMPLEMENTATION == CRC32_SLICE_BY_8)
+#define CRC32_HAS_HARDWARE      (CRC32_IMPLEMENTATION == CRC32_HARDWARE)
+#endif
+
 uint32_t crc32String(const char *buffer);
 uint32_t crc32Buffer(const void *buffer, size_t bufferLength);
 
 uint32_t crc32Update(const void *buffer, size_t bufferLength, uint32_t crc);
 uint32_t crc32Final(uint32_t crc);
 
+#if CRC32_HAS_BITWISE
+uint32_t crc32UpdateBitwise(const void *buffer, size_t bufferLength,
+                            uint32_t crc);
+#endif
+#if CRC32_HAS_NIBBLE_TABLE
+uint32_t crc32UpdateNibbleTable(const void *buffer, size_t bufferLength,
+                                uint32_t crc);
+#endif
+#if CRC32_HAS_BYTE_TABLE
+uint32_t crc32UpdateByteTable(const void *buffer, size_t bufferLength,
+                              uint32_t crc);
+#endif
+#if CRC32_HAS_SLICE_BY_8
+uint32_t crc32UpdateSliceBy8(const void *buffer, size_t bufferLength,
+                             uint32_t crc);
+#endif
+#if CRC32_HAS_HARDWARE
+uint32_t crc32UpdateHardware(const void *buffer, size_t bufferLength,
+                             uint32_t crc);
+#endif
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
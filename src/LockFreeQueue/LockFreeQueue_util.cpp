@@ -0,0 +1,17 @@
+#include "LockFreeQueue_util.h"
+
+namespace lock_free_queue {
+/**
+ * Returns the smallest power of two that is greater than or equal to the given
+ * value (at least 2).
+ */
+size_t round_up_to_power_of_two(size_t value) {
+  size_t result = 2;
+
+  while (result < value) {
+    result <<= 1;
+  }
+
+  return result;
+}
+}  // namespace lock_free_queue
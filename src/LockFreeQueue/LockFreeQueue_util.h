@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace lock_free_queue {
+size_t round_up_to_power_of_two(size_t value);
+}  // namespace lock_free_queue
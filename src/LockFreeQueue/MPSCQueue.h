@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "LockFreeQueue_util.h"
+#include "optional/include/tl/optional.hpp"
+
+namespace lock_free_queue {
+/**
+ * A bounded, lock-free multi-producer single-consumer queue.
+ *
+ * Any number of threads may push concurrently, but only a single thread may
+ * pop. Every cell carries a sequence number which tells producers whether the
+ * cell is free and tells the consumer whether it has been filled, so producers
+ * only contend on a single compare-and-swap of the enqueue position.
+ *
+ * The capacity is rounded up to the next power of two.
+ */
+template <typename T>
+struct MPSCQueue {
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+
+  std::atomic<size_t> enqueue_position;
+  char padding[64];  // keeps producers and the consumer on separate cache lines
+  size_t dequeue_position = 0;
+
+ public:
+  MPSCQueue(const size_t capacity)
+      : cells(new Cell[round_up_to_power_of_two(capacity)]),
+        mask(round_up_to_power_of_two(capacity) - 1),
+        enqueue_position(0) {
+    for (size_t i = 0; i <= mask; i += 1) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  /**
+   * Pushes the given value into the queue. May be called from any thread.
+   * Returns false if the queue is full.
+   */
+  bool push(T value) {
+    auto position = enqueue_position.load(std::memory_order_relaxed);
+
+    for (;;) {
+      auto& cell = cells[position & mask];
+      const auto sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = (intptr_t)sequence - (intptr_t)position;
+
+      if (difference == 0) {
+        if (enqueue_position.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueue_position.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Pops the oldest value from the queue, if there is one. Must only be called
+   * from the consuming thread.
+   */
+  tl::optional<T> pop() {
+    auto& cell = cells[dequeue_position & mask];
+    const auto sequence = cell.sequence.load(std::memory_order_acquire);
+
+    if ((intptr_t)sequence - (intptr_t)(dequeue_position + 1) < 0) {
+      return {};
+    }
+
+    T value = std::move(cell.value);
+    cell.value = T();
+    cell.sequence.store(dequeue_position + mask + 1, std::memory_order_release);
+    dequeue_position += 1;
+
+    return value;
+  }
+
+  /**
+   * Returns the maximum number of values the queue can hold.
+   */
+  size_t capacity() const { return mask + 1; }
+};
+}  // namespace lock_free_queue
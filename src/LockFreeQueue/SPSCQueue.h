@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+
+#include "LockFreeQueue_util.h"
+#include "optional/include/tl/optional.hpp"
+
+namespace lock_free_queue {
+/**
+ * A bounded, lock-free single-producer single-consumer ring buffer.
+ *
+ * Exactly one thread may push and exactly one (other) thread may pop. The
+ * capacity is rounded up to the next power of two.
+ */
+template <typename T>
+struct SPSCQueue {
+ private:
+  std::unique_ptr<T[]> items;
+  size_t mask;
+
+  std::atomic<size_t> head;  // written by the consumer
+  char padding[64];  // keeps the producer and the consumer on separate cache lines
+  std::atomic<size_t> tail;  // written by the producer
+
+ public:
+  SPSCQueue(const size_t capacity)
+      : items(new T[round_up_to_power_of_two(capacity)]),
+        mask(round_up_to_power_of_two(capacity) - 1),
+        head(0),
+        tail(0) {}
+
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  /**
+   * Pushes the given value into the queue. Must only be called from the
+   * producing thread. Returns false if the queue is full.
+   */
+  bool push(T value) {
+    const auto current_tail = tail.load(std::memory_order_relaxed);
+
+    if (current_tail - head.load(std::memory_order_acquire) > mask) {
+      return false;
+    }
+
+    items[current_tail & mask] = std::move(value);
+    tail.store(current_tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  /**
+   * Pops the oldest value from the queue, if there is one. Must only be called
+   * from the consuming thread.
+   */
+  tl::optional<T> pop() {
+    const auto current_head = head.load(std::memory_order_relaxed);
+
+    if (current_head == tail.load(std::memory_order_acquire)) {
+      return {};
+    }
+
+    T value = std::move(items[current_head & mask]);
+    items[current_head & mask] = T();
+    head.store(current_head + 1, std::memory_order_release);
+
+    return value;
+  }
+
+  /**
+   * Returns true if there is nothing to pop. Must only be called from the
+   * consuming thread.
+   */
+  bool is_empty() const {
+    return head.load(std::memory_order_relaxed) ==
+           tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Returns the maximum number of values the queue can hold.
+   */
+  size_t capacity() const { return mask + 1; }
+};
+}  // namespace lock_free_queue
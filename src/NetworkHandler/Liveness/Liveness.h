@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace liveness {
+/**
+ * Whether a tracked peer is believed to be reachable. A peer is suspected once
+ * nothing was received from it for the suspicion timeout, and becomes alive
+ * again as soon as any packet arrives from it.
+ */
+enum class PeerState : uint8_t {
+  ALIVE,
+  SUSPECTED,
+};
+
+/**
+ * When keepalives are sent and when silent peers are suspected or given up
+ * on, all in deciseconds. A value of 0 disables the respective step.
+ *
+ * Liveness monitoring is off by default: releases without keepalives stay
+ * silent while idle, so they would time out, and keepalives between idle
+ * peers would only cost traffic. Once all peers send keepalives, enable all
+ * three steps together, e.g. with 10, 30 and 100.
+ */
+struct LivenessOptions {
+  uint32_t keepalive_interval = 0;
+  uint32_t suspicion_timeout = 0;
+  uint32_t dead_timeout = 0;
+};
+
+/**
+ * What a NetworkHandler knows about the reachability of a tracked peer.
+ */
+struct PeerLiveness {
+  uint32_t last_seen_time = 0;
+  uint32_t last_send_time = 0;
+  PeerState state = PeerState::ALIVE;
+};
+}  // namespace liveness
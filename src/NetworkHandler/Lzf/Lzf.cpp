@@ -0,0 +1,172 @@
+#include "Lzf.h"
+
+#include <cstring>
+#include <vector>
+
+namespace lzf {
+namespace {
+const unsigned int hash_bits = 9;
+const size_t max_literal_run = 32;
+const size_t max_offset = 8192;
+const size_t min_match_length = 3;
+const size_t max_match_length = 264;
+
+unsigned int hash(const uint8_t *data) {
+  const uint32_t value = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) |
+                         (uint32_t)data[2];
+
+  return (value * 2654435761u) >> (32 - hash_bits);
+}
+
+void flush_literals(std::string &output, const uint8_t *literals,
+                    size_t count) {
+  while (count > 0) {
+    const auto run = count < max_literal_run ? count : max_literal_run;
+    output += (char)(run - 1);
+    output.append((const char *)literals, run);
+
+    literals += run;
+    count -= run;
+  }
+}
+}  // namespace
+
+/**
+ * Compresses the given bytes with an LZF-style compressor that needs 1 KB of
+ * working memory. The output starts with the uncompressed size as a 2-byte
+ * little-endian integer, followed by runs of literals (a control byte below
+ * 32 followed by that many bytes plus one) and back-references (length in the
+ * top three bits, extended by a byte when 7, and a 13-bit offset).
+ *
+ * Returns nothing if the input is larger than max_size or does not get
+ * smaller.
+ */
+tl::optional<std::string> compress(const std::string &input) {
+  if (input.size() > max_size || input.size() < min_match_length) {
+    return {};
+  }
+
+  const auto data = (const uint8_t *)input.data();
+  const auto size = input.size();
+
+  std::vector<uint16_t> table(1u << hash_bits, 0);
+
+  std::string output;
+  output.reserve(size);
+  output += (char)(size & 0xff);
+  output += (char)(size >> 8);
+
+  size_t position = 0;
+  size_t literal_start = 0;
+
+  while (position + min_match_length <= size) {
+    const auto slot = hash(data + position);
+    const size_t candidate = table[slot];
+    table[slot] = (uint16_t)position;
+
+    const auto offset = position - candidate;
+    if (candidate >= position || offset > max_offset ||
+        std::memcmp(data + candidate, data + position, min_match_length) !=
+            0) {
+      position += 1;
+      continue;
+    }
+
+    auto length = min_match_length;
+    while (position + length < size && length < max_match_length &&
+           data[candidate + length] == data[position + length]) {
+      length += 1;
+    }
+
+    flush_literals(output, data + literal_start, position - literal_start);
+
+    const auto encoded_length = length - 2;
+    const auto encoded_offset = offset - 1;
+    if (encoded_length < 7) {
+      output += (char)((encoded_length << 5) | (encoded_offset >> 8));
+    } else {
+      output += (char)((7 << 5) | (encoded_offset >> 8));
+      output += (char)(encoded_length - 7);
+    }
+    output += (char)(encoded_offset & 0xff);
+
+    if (output.size() >= size) {
+      return {};
+    }
+
+    position += length;
+    literal_start = position;
+  }
+
+  flush_literals(output, data + literal_start, size - literal_start);
+
+  if (output.size() >= size) {
+    return {};
+  }
+
+  return output;
+}
+
+/**
+ * Decompresses the output of compress. Returns nothing if the input is
+ * malformed.
+ */
+tl::optional<std::string> decompress(const std::string &compressed) {
+  if (compressed.size() < 2) {
+    return {};
+  }
+
+  const auto data = (const uint8_t *)compressed.data();
+  const auto size = compressed.size();
+  const size_t expected_size = (size_t)data[0] | ((size_t)data[1] << 8);
+
+  std::string output;
+  output.reserve(expected_size);
+
+  size_t position = 2;
+  while (position < size) {
+    const size_t control = data[position++];
+
+    if (control < max_literal_run) {
+      const auto run = control + 1;
+      if (position + run > size || output.size() + run > expected_size) {
+        return {};
+      }
+
+      output.append((const char *)data + position, run);
+      position += run;
+      continue;
+    }
+
+    size_t length = control >> 5;
+    if (length == 7) {
+      if (position >= size) {
+        return {};
+      }
+      length += data[position++];
+    }
+    length += 2;
+
+    if (position >= size) {
+      return {};
+    }
+    const size_t offset = (((control & 0x1f) << 8) | data[position++]) + 1;
+
+    if (offset > output.size() || output.size() + length > expected_size) {
+      return {};
+    }
+
+    // copied byte by byte, since the reference may overlap its own output
+    auto source = output.size() - offset;
+    for (size_t i = 0; i < length; i += 1) {
+      output += output[source + i];
+    }
+  }
+
+  if (output.size() != expected_size) {
+    return {};
+  }
+
+  return output;
+}
+}  // namespace lzf
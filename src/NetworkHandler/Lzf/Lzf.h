@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "optional/include/tl/optional.hpp"
+
+namespace lzf {
+/**
+ * The largest input that can be compressed, and the largest output that
+ * decompress accepts to produce.
+ */
+const size_t max_size = 65535;
+
+tl::optional<std::string> compress(const std::string &input);
+
+tl::optional<std::string> decompress(const std::string &compressed);
+}  // namespace lzf
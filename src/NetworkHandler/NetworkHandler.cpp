@@ -1,7 +1,12 @@
 #include "NetworkHandler.h"
 
+#include <climits>
+
 #include "DataFormat/DataFormat_util.h"
+#include "ErriezCRC32/ErriezCRC32.h"
+#include "Lzf/Lzf.h"
 #include "MessageType/MessageType_util.h"
+#include "Tracing/Tracing.h"
 
 /**
  * Returns a data object containing any information contained in this message.
@@ -45,6 +50,11 @@ unsigned int ActiveNetworkMessage::get_retries_left() const {
   return retries_left;
 }
 
+/**
+ * Returns the priority class of the message.
+ */
+MessagePriority ActiveNetworkMessage::get_priority() const { return priority; }
+
 /**
  * Decrements the number of retries left.
  */
@@ -58,6 +68,141 @@ bool ActiveNetworkMessage::decrement_retries() {
   return true;
 }
 
+/**
+ * Assigns a new ID to this message, replenishes its retries, and picks up its
+ * current priority.
+ */
+void ActiveNetworkMessage::renew(const unsigned int new_message_id) {
+  message_id = new_message_id;
+  retries_left = max_retries;
+  priority = message->get_priority();
+  fragmented_packet.clear();
+  fragment_size = 0;
+  fragment_window = 0;
+  fragment_states.clear();
+  first_send_time = {};
+}
+
+/**
+ * Returns true if the packet of this message is sent in fragments.
+ */
+bool ActiveNetworkMessage::is_fragmented() const { return fragment_size > 0; }
+
+const std::string& ActiveNetworkMessage::get_fragmented_packet() const {
+  return fragmented_packet;
+}
+
+/**
+ * Stores the packet of this message so that every retry sends the same
+ * fragments, even if the contents of the NetworkMessage change in between. At
+ * most fragment_window fragments are in flight at once.
+ */
+void ActiveNetworkMessage::set_fragmented_packet(const std::string packet,
+                                                 const size_t fragment_size,
+                                                 const size_t fragment_window) {
+  fragmented_packet = packet;
+  this->fragment_size = fragment_size;
+  this->fragment_window = fragment_window;
+  fragment_states.assign(get_fragment_count(), FragmentState::UNSENT);
+}
+
+size_t ActiveNetworkMessage::get_fragment_size() const { return fragment_size; }
+
+/**
+ * Returns the number of fragments the packet after its format byte is split
+ * into, or 0 if the message is not fragmented.
+ */
+size_t ActiveNetworkMessage::get_fragment_count() const {
+  if (fragment_size == 0) {
+    return 0;
+  }
+
+  return (fragmented_packet.size() - 1 + fragment_size - 1) / fragment_size;
+}
+
+ActiveNetworkMessage::FragmentState ActiveNetworkMessage::get_fragment_state(
+    const size_t index) const {
+  return fragment_states.at(index);
+}
+
+void ActiveNetworkMessage::set_fragment_state(const size_t index,
+                                              const FragmentState state) {
+  fragment_states.at(index) = state;
+}
+
+/**
+ * Marks the given fragment as acknowledged. Returns true if it was not
+ * acknowledged before.
+ */
+bool ActiveNetworkMessage::ack_fragment(const size_t index) {
+  if (index >= fragment_states.size() ||
+      fragment_states[index] == FragmentState::ACKED) {
+    return false;
+  }
+
+  fragment_states[index] = FragmentState::ACKED;
+  return true;
+}
+
+bool ActiveNetworkMessage::are_all_fragments_acked() const {
+  for (const auto state : fragment_states) {
+    if (state != FragmentState::ACKED) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void ActiveNetworkMessage::reset_fragment_states() {
+  fragment_states.assign(fragment_states.size(), FragmentState::UNSENT);
+}
+
+size_t ActiveNetworkMessage::count_fragments_in_flight() const {
+  size_t count = 0;
+  for (const auto state : fragment_states) {
+    if (state == FragmentState::IN_FLIGHT) {
+      count += 1;
+    }
+  }
+
+  return count;
+}
+
+size_t ActiveNetworkMessage::get_fragment_window() const {
+  return fragment_window;
+}
+
+void ActiveNetworkMessage::set_fragment_window(const size_t new_window) {
+  fragment_window = new_window;
+}
+
+/**
+ * Restores the full number of retries, e.g. after a long transfer made
+ * progress.
+ */
+void ActiveNetworkMessage::replenish_retries() { retries_left = max_retries; }
+
+/**
+ * Returns when this message was first sent under its current ID, if it was.
+ */
+tl::optional<uint32_t> ActiveNetworkMessage::get_first_send_time() const {
+  return first_send_time;
+}
+
+void ActiveNetworkMessage::set_first_send_time(
+    const uint32_t time_in_deciseconds) {
+  first_send_time = time_in_deciseconds;
+}
+
+/**
+ * Returns true if this message cannot be sent, since its packet needs more
+ * fragments than the fragment count can hold.
+ */
+bool ActiveNetworkMessage::is_refused() const { return refused; }
+
+void ActiveNetworkMessage::refuse() { refused = true; }
+
 /**
  * Returns the ID of the next active message to send.
  */
@@ -70,51 +215,267 @@ unsigned int NetworkHandler::get_next_active_message_id() {
 }
 
 /**
- * Sends the given active message over the network.
+ * Renews the given active message if the contents of its NetworkMessage were
+ * replaced since it was last sent. Returns true if it was renewed.
+ */
+bool NetworkHandler::renew_if_updated(ActiveNetworkMessage& message) {
+  if (!message.get_network_message()->take_pending_update()) {
+    return false;
+  }
+
+  message.renew(get_next_active_message_id());
+
+  return true;
+}
+
+/**
+ * Prefixes the given encoding with the format byte of the given codec,
+ * compressing it first if it reaches the compression threshold and gets
+ * smaller.
+ */
+std::string NetworkHandler::create_packet(const std::shared_ptr<Codec> codec,
+                                          const std::string& encoding) const {
+  auto format_byte = get_format_byte_from_data_format(codec->get_format());
+
+  if (compression_threshold > 0 && encoding.size() >= compression_threshold) {
+    const auto compressed = lzf::compress(encoding);
+    if (compressed.has_value()) {
+      format_byte |= compressed_format_flag;
+      return (char)format_byte + compressed.value();
+    }
+  }
+
+  return (char)format_byte + encoding;
+}
+
+/**
+ * Sends the given packet to the given endpoint, appending a checksum if
+ * checksums are enabled. If the endpoint is a tracked peer, no keepalive is
+ * due until another keepalive interval has passed.
+ * Throws an exception if no UDP interface is provided.
+ */
+bool NetworkHandler::send_packet(const udp_interface::Endpoint& endpoint,
+                                 const std::string& packet) const {
+  if (udp_interface == nullptr) {
+    throw std::runtime_error(
+        "Network handler was not provided a UDP interface.");
+  }
+
+  TRACE_SCOPE(SEND_PACKET);
+
+  auto& endpoint_metrics = get_endpoint_metrics(endpoint);
+  endpoint_metrics.packets_sent += 1;
+
+  const auto liveness_it = peer_liveness.find(endpoint);
+  if (liveness_it != peer_liveness.end()) {
+    liveness_it->second.last_send_time = time_in_deciseconds;
+  }
+
+  if (!are_checksums_enabled || packet.empty()) {
+    endpoint_metrics.bytes_sent += packet.size();
+    return udp_interface->send_packet(endpoint, packet);
+  }
+
+  std::string checked_packet;
+  checked_packet.reserve(packet.size() + checksum_size);
+  checked_packet += (char)((uint8_t)packet[0] | checksum_format_flag);
+  checked_packet.append(packet, 1, std::string::npos);
+
+  const auto checksum =
+      crc32Buffer(checked_packet.data(), checked_packet.size());
+  for (int i = 3; i >= 0; i -= 1) {
+    checked_packet += (char)((checksum >> (i * 8)) & 0xff);
+  }
+
+  endpoint_metrics.bytes_sent += checked_packet.size();
+  return udp_interface->send_packet(endpoint, checked_packet);
+}
+
+/**
+ * Sends fragments of the given message, at most max_packets of them. Retries
+ * resend the fragments still in flight, since they were presumably lost. Then
+ * unsent fragments are sent until the window is full. If all fragments were
+ * acknowledged, but the message still was not, either its ack was lost or the
+ * receiver had to drop the reassembly, so a retry starts over. Returns the
+ * number of packets sent.
+ */
+unsigned int NetworkHandler::send_fragments(ActiveNetworkMessage& message,
+                                            const unsigned int max_packets,
+                                            const bool is_retry) const {
+  typedef ActiveNetworkMessage::FragmentState FragmentState;
+
+  const auto& packet = message.get_fragmented_packet();
+  const auto message_id = message.get_message_id();
+  const auto fragment_size = message.get_fragment_size();
+  const auto fragment_count = message.get_fragment_count();
+
+  unsigned int packets_sent = 0;
+  size_t bytes_sent = 0;
+  auto send_fragment = [&](const size_t index) {
+    std::string fragment;
+    fragment.reserve(fragment_header_size + fragment_size);
+    fragment += (char)((uint8_t)packet[0] | fragment_format_flag);
+    fragment += (char)((message_id >> 16) & 0xff);
+    fragment += (char)((message_id >> 8) & 0xff);
+    fragment += (char)(message_id & 0xff);
+    fragment += (char)((index >> 8) & 0xff);
+    fragment += (char)(index & 0xff);
+    fragment += (char)((fragment_count >> 8) & 0xff);
+    fragment += (char)(fragment_count & 0xff);
+    fragment.append(packet, 1 + index * fragment_size, fragment_size);
+
+    send_packet(message.get_endpoint(), fragment);
+    message.set_fragment_state(index, FragmentState::IN_FLIGHT);
+    packets_sent += 1;
+    bytes_sent += fragment.size();
+  };
+
+  if (is_retry && message.are_all_fragments_acked()) {
+    message.reset_fragment_states();
+  }
+
+  auto fragments_in_flight = message.count_fragments_in_flight();
+  if (is_retry) {
+    for (size_t i = 0; i < fragment_count && packets_sent < max_packets;
+         i += 1) {
+      if (message.get_fragment_state(i) == FragmentState::IN_FLIGHT) {
+        send_fragment(i);
+        get_endpoint_metrics(message.get_endpoint()).retransmissions += 1;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < fragment_count && packets_sent < max_packets &&
+                     fragments_in_flight < message.get_fragment_window();
+       i += 1) {
+    if (message.get_fragment_state(i) == FragmentState::UNSENT) {
+      send_fragment(i);
+      fragments_in_flight += 1;
+    }
+  }
+
+  if (packets_sent > 0) {
+    message.get_network_message()->on_emitted(bytes_sent);
+    delegate->on_message_emitted(message.get_network_message());
+  }
+
+  return packets_sent;
+}
+
+/**
+ * Sends the given active message over the network, in fragments if its packet
+ * is larger than the max packet size. Returns the number of packets sent,
+ * which is at most max_packets.
  * Throws an exception if no UDP interface is provided.
  */
-bool NetworkHandler::send_active_message(
-    const ActiveNetworkMessage& message) const {
+unsigned int NetworkHandler::send_active_message(
+    ActiveNetworkMessage& message, const unsigned int max_packets) const {
+  if (message.is_fragmented()) {
+    return send_fragments(message, max_packets, true);
+  }
+
   const auto endpoint = message.get_endpoint();
 
-  const auto message_data_object = message.to_data_object();
+  if (message.get_first_send_time().has_value()) {
+    get_endpoint_metrics(endpoint).retransmissions += 1;
+  } else {
+    message.set_first_send_time(time_in_deciseconds);
+  }
+
+  const auto message_data_object =
+      TRACE_CALL(TO_DATA_OBJECT, message.to_data_object());
   const auto message_type = message.get_network_message()->get_message_type();
   const auto message_type_string = get_string_from_message_type(message_type);
   const auto packet_data_object = data_object::create_array({
       data_object::create_string_value(message_type_string),
-      data_object::create_number_value((int)message.get_message_id()),
+      data_object::create_int_value(message.get_message_id()),
       message_data_object,
   });
 
   const auto codec = message.get_codec();
-  const auto serialized_packet = codec->encode(packet_data_object);
+  const auto packet = TRACE_CALL(
+      ENCODE, create_packet(codec, codec->encode(packet_data_object)));
+  const auto trailer_size = are_checksums_enabled ? checksum_size : 0;
+
+  if (max_packet_size > 0 && packet.size() + trailer_size > max_packet_size) {
+    const auto fragment_size =
+        max_packet_size - fragment_header_size - trailer_size;
+    if ((packet.size() - 1 + fragment_size - 1) / fragment_size >
+        max_fragment_count) {
+      message.refuse();
+      return 0;
+    }
+
+    message.set_fragmented_packet(packet, fragment_size,
+                                  initial_fragment_window);
 
-  const auto format = codec->get_format();
-  const auto format_byte = get_format_byte_from_data_format(format);
-  const auto packet = (char)format_byte + serialized_packet;
+    return send_fragments(message, max_packets, false);
+  }
 
+  message.get_network_message()->on_emitted(packet.size());
   delegate->on_message_emitted(message.get_network_message());
 
-  if (udp_interface == nullptr) {
-    throw std::runtime_error(
-        "Network handler was not provided a UDP interface.");
+  send_packet(endpoint, packet);
+
+  return 1;
+}
+
+/**
+ * Returns true if another message may be sent within the current 100 ms
+ * period.
+ */
+bool NetworkHandler::has_send_budget() const {
+  return max_messages_per_decisecond == 0 ||
+         messages_sent_this_decisecond < max_messages_per_decisecond;
+}
+
+/**
+ * Returns how many more packets may be sent within the current 100 ms period.
+ */
+unsigned int NetworkHandler::get_remaining_send_budget() const {
+  if (max_messages_per_decisecond == 0) {
+    return UINT_MAX;
+  }
+
+  if (messages_sent_this_decisecond >= max_messages_per_decisecond) {
+    return 0;
   }
 
-  return udp_interface->send_packet(endpoint, packet);
+  return max_messages_per_decisecond - messages_sent_this_decisecond;
 }
 
 /**
- * Sends all active messages that are currently queued for sending.
+ * Sends the active messages of the given priority in the order they were
+ * queued, as long as the send budget allows. Messages to suspected peers are
+ * skipped without using up their retries.
  */
-void NetworkHandler::send_active_messages() {
+void NetworkHandler::send_active_messages_with_priority(
+    const MessagePriority priority) {
+  // failures are reported once the loop is done, since a failed message may
+  // cancel other active messages
+  std::vector<ActiveNetworkMessage> failed_messages;
+
   auto it = active_messages.begin();
-  while (it != active_messages.end()) {
-    send_active_message(*it);
+  while (it != active_messages.end() && has_send_budget()) {
+    if (it->get_priority() != priority ||
+        is_peer_suspected(it->get_endpoint())) {
+      it++;
+      continue;
+    }
+
+    renew_if_updated(*it);
+
+    messages_sent_this_decisecond +=
+        send_active_message(*it, get_remaining_send_budget());
+    if (it->is_refused()) {
+      it++;
+      continue;
+    }
+
     it->decrement_retries();
 
     if (it->get_retries_left() == 0) {
-      it->get_network_message()->on_send_failed();
-      delegate->on_message_discarded(it->get_message_id());
+      failed_messages.push_back(*it);
 
       it = active_messages.erase(it);
       continue;
@@ -122,6 +483,49 @@ void NetworkHandler::send_active_messages() {
 
     it++;
   }
+
+  for (const auto& failed_message : failed_messages) {
+    failed_message.get_network_message()->on_send_failed();
+    delegate->on_message_discarded(failed_message.get_message_id());
+  }
+}
+
+/**
+ * Sends all active messages that are currently queued for sending, highest
+ * priority first.
+ */
+void NetworkHandler::send_active_messages() {
+  send_active_messages_with_priority(MessagePriority::HIGH);
+  send_active_messages_with_priority(MessagePriority::NORMAL);
+  send_active_messages_with_priority(MessagePriority::LOW);
+
+  discard_refused_messages();
+}
+
+/**
+ * Gives up on the active messages that were refused since their packet needs
+ * too many fragments. Like messages a receiver refuses, they are cancelled
+ * without counting as a failure of the peer.
+ */
+void NetworkHandler::discard_refused_messages() {
+  std::vector<ActiveNetworkMessage> refused_messages;
+
+  auto it = active_messages.begin();
+  while (it != active_messages.end()) {
+    if (!it->is_refused()) {
+      it++;
+      continue;
+    }
+
+    refused_messages.push_back(*it);
+    it = active_messages.erase(it);
+  }
+
+  for (const auto& refused_message : refused_messages) {
+    metrics.capacity.refused_messages += 1;
+    refused_message.get_network_message()->on_cancelled();
+    delegate->on_message_discarded(refused_message.get_message_id());
+  }
 }
 
 /**
@@ -134,13 +538,14 @@ NetworkHandler::get_codec_from_incoming_message(
     return {};
   }
 
-  const auto codec_byte = incoming_message.data.at(0);
-  const auto codec_optional = get_data_format_from_format_byte(codec_byte);
+  const uint8_t codec_byte = incoming_message.data.at(0);
+  const auto codec_optional =
+      get_data_format_from_format_byte(codec_byte & ~compressed_format_flag);
 
   if (codec_optional.has_value()) {
     const auto codec_enum = codec_optional.value();
 
-    return create_codec_from_format(codec_enum);
+    return create_codec_from_format(codec_enum, codec_options);
   }
 
   return {};
@@ -160,6 +565,17 @@ NetworkHandler::get_data_object_from_incoming_message(
 
   auto encoding = incoming_message.data.substr(1);
 
+  const uint8_t format_byte = incoming_message.data.at(0);
+  if (format_byte & compressed_format_flag) {
+    const auto decompressed = lzf::decompress(encoding);
+    if (!decompressed.has_value()) {
+      delegate->on_decode_failed("Failed to decompress the message.", codec);
+      return {};
+    }
+
+    encoding = decompressed.value();
+  }
+
   std::string error_string;
   auto decoded_message = codec->decode(encoding, error_string);
   if (!error_string.empty()) {
@@ -172,12 +588,32 @@ NetworkHandler::get_data_object_from_incoming_message(
 
 /**
  * Called when an ack is received for a message. Removes the corresponding
- * active message.
+ * active message, unless its contents were replaced while it was in flight, in
+ * which case the new contents are sent right away under a new ID.
  */
 void NetworkHandler::on_received_ack(const unsigned int message_id) {
   auto it = active_messages.begin();
   while (it != active_messages.end()) {
     if (it->get_message_id() == message_id) {
+      if (renew_if_updated(*it)) {
+        delegate->on_ack_received(message_id);
+
+        if (has_send_budget()) {
+          messages_sent_this_decisecond +=
+              send_active_message(*it, get_remaining_send_budget());
+          it->decrement_retries();
+        }
+
+        discard_refused_messages();
+        return;
+      }
+
+      const auto first_send_time = it->get_first_send_time();
+      if (first_send_time.has_value()) {
+        metrics.ack_latencies.record(time_in_deciseconds -
+                                     first_send_time.value());
+      }
+
       it->get_network_message()->on_send_succeeded();
       delegate->on_ack_received(it->get_message_id());
 
@@ -189,6 +625,84 @@ void NetworkHandler::on_received_ack(const unsigned int message_id) {
   }
 }
 
+/**
+ * Called when a fragment of a message is acknowledged, so that retries skip
+ * it. Adopts the window advertised by the receiver and sends the fragments
+ * that fit into it, as far as the send budget allows. While messages of a
+ * higher priority are queued, the next fragments wait for the next round of
+ * sending instead, so that bulk transfers do not crowd them out. A window of 0
+ * means that the receiver can never buffer the whole message, which is then
+ * given up on without counting as a failure of the peer.
+ */
+void NetworkHandler::on_received_fragment_ack(const unsigned int message_id,
+                                              const size_t fragment_index,
+                                              const size_t fragment_window) {
+  for (auto it = active_messages.begin(); it != active_messages.end(); it++) {
+    auto& message = *it;
+    if (message.get_message_id() != message_id || !message.is_fragmented()) {
+      continue;
+    }
+
+    if (fragment_window == 0) {
+      metrics.capacity.refused_messages += 1;
+      message.get_network_message()->on_cancelled();
+      delegate->on_message_discarded(message_id);
+
+      active_messages.erase(it);
+      return;
+    }
+
+    if (message.ack_fragment(fragment_index)) {
+      message.replenish_retries();
+    }
+    message.set_fragment_window(fragment_window);
+
+    if (has_active_messages_above(message.get_priority())) {
+      return;
+    }
+
+    messages_sent_this_decisecond +=
+        send_fragments(message, get_remaining_send_budget(), false);
+    return;
+  }
+}
+
+/**
+ * Returns true if an active message of a higher priority than the given one
+ * is queued for a peer that is not suspected.
+ */
+bool NetworkHandler::has_active_messages_above(
+    const MessagePriority priority) const {
+  for (const auto& message : active_messages) {
+    if (message.get_priority() > priority &&
+        !is_peer_suspected(message.get_endpoint())) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Sends an ack for the given fragment of the given message ID to the given
+ * endpoint formatted with the provided codec, advertising how many more
+ * fragments can be buffered.
+ * Throws an exception if no UDP interface is provided.
+ */
+void NetworkHandler::send_fragment_ack(
+    const unsigned int message_id, const size_t fragment_index,
+    const size_t fragment_window, const udp_interface::Endpoint& endpoint,
+    const std::shared_ptr<Codec> codec) const {
+  const auto data = data_object::create_array({
+      data_object::create_string_value("fack"),
+      data_object::create_int_value(message_id),
+      data_object::create_int_value(fragment_index),
+      data_object::create_int_value(fragment_window),
+  });
+
+  send_packet(endpoint, create_packet(codec, codec->encode(data)));
+}
+
 /**
  * Sends an ack for the given message ID to the given endpoint formatted with
  * the provided codec.
@@ -199,44 +713,163 @@ void NetworkHandler::send_ack(const unsigned int message_id,
                               const std::shared_ptr<Codec> codec) const {
   const auto data = data_object::create_array({
       data_object::create_string_value("ack"),
-      data_object::create_number_value((int)message_id),
+      data_object::create_int_value(message_id),
   });
-  const auto encoded = codec->encode(data);
-  const auto format = codec->get_format();
-  const auto format_byte = get_format_byte_from_data_format(format);
-  const auto packet = (char)format_byte + encoded;
+  send_packet(endpoint, create_packet(codec, codec->encode(data)));
+}
 
-  if (udp_interface == nullptr) {
-    throw std::runtime_error(
-        "Network handler was not provided a UDP interface.");
+/**
+ * Sends a keepalive to the given endpoint formatted with the provided codec.
+ * Keepalives have no ID and are not acknowledged.
+ * Throws an exception if no UDP interface is provided.
+ */
+void NetworkHandler::send_keepalive(const udp_interface::Endpoint& endpoint,
+                                    const std::shared_ptr<Codec> codec) const {
+  const auto data = data_object::create_array({
+      data_object::create_string_value("alive"),
+  });
+  send_packet(endpoint, create_packet(codec, codec->encode(data)));
+  metrics.liveness.keepalives_sent += 1;
+}
+
+/**
+ * Records that a valid packet arrived from the given endpoint. If it is a
+ * tracked peer, it is considered alive again.
+ */
+void NetworkHandler::on_peer_seen(const udp_interface::Endpoint& endpoint) {
+  const auto it = peer_liveness.find(endpoint);
+  if (it == peer_liveness.end()) {
+    return;
   }
-  udp_interface->send_packet(endpoint, packet);
+
+  it->second.last_seen_time = time_in_deciseconds;
+  it->second.state = liveness::PeerState::ALIVE;
 }
 
 /**
- * Handles an incoming decoded message.
+ * Returns true if the given endpoint is a tracked peer that is currently
+ * suspected to be unreachable.
  */
-void NetworkHandler::handle_decoded_message(
-    const std::shared_ptr<data_object::GenericValue> decoded_message,
-    const udp_interface::Endpoint& endpoint,
-    const std::shared_ptr<Codec> codec) {
-  if (decoded_message->is_array()) {
-    const auto array_items = decoded_message->array_items().value();
-    if (array_items->size() == 0) {
-      return;
-    }
+bool NetworkHandler::is_peer_suspected(
+    const udp_interface::Endpoint& endpoint) const {
+  if (peer_liveness.empty()) {
+    return false;
+  }
 
-    const auto type = array_items->at(0)->string_value().value_or("");
+  const auto it = peer_liveness.find(endpoint);
+  return it != peer_liveness.end() &&
+         it->second.state == liveness::PeerState::SUSPECTED;
+}
 
-    if (type == "ack") {
-      if (array_items->size() < 2) {
-        return;
-      }
-      const auto message_id = array_items->at(1)->int_value().value_or(-1);
-      if (message_id < 0) {
-        return;
-      }
-      on_received_ack((unsigned int)message_id);
+/**
+ * Discards the active messages to the given endpoint as if they had run out
+ * of retries.
+ */
+void NetworkHandler::fail_active_messages(
+    const udp_interface::Endpoint& endpoint) {
+  std::vector<ActiveNetworkMessage> failed_messages;
+
+  auto it = active_messages.begin();
+  while (it != active_messages.end()) {
+    if (!(it->get_endpoint() == endpoint)) {
+      it++;
+      continue;
+    }
+
+    failed_messages.push_back(*it);
+    it = active_messages.erase(it);
+  }
+
+  for (const auto& failed_message : failed_messages) {
+    failed_message.get_network_message()->on_send_failed();
+    delegate->on_message_discarded(failed_message.get_message_id());
+  }
+}
+
+/**
+ * Suspects tracked peers that were silent for the suspicion timeout, gives up
+ * on those that were silent for the dead timeout, and sends keepalives to the
+ * others if nothing was sent to them for the keepalive interval.
+ */
+void NetworkHandler::update_peer_liveness() {
+  std::shared_ptr<Codec> keepalive_codec;
+  std::vector<udp_interface::Endpoint> timed_out_endpoints;
+
+  for (auto& entry : peer_liveness) {
+    auto& peer = entry.second;
+    const auto silence = time_in_deciseconds - peer.last_seen_time;
+
+    if (liveness_options.dead_timeout != 0 &&
+        silence >= liveness_options.dead_timeout) {
+      timed_out_endpoints.push_back(entry.first);
+      continue;
+    }
+
+    if (liveness_options.suspicion_timeout != 0 &&
+        silence >= liveness_options.suspicion_timeout &&
+        peer.state == liveness::PeerState::ALIVE) {
+      peer.state = liveness::PeerState::SUSPECTED;
+      metrics.liveness.suspected_peers += 1;
+    }
+
+    if (liveness_options.keepalive_interval != 0 &&
+        time_in_deciseconds - peer.last_send_time >=
+            liveness_options.keepalive_interval) {
+      if (keepalive_codec == nullptr) {
+        keepalive_codec =
+            create_codec_from_format(default_data_format, codec_options);
+      }
+      send_keepalive(entry.first, keepalive_codec);
+    }
+  }
+
+  for (const auto& endpoint : timed_out_endpoints) {
+    untrack_peer(endpoint);
+    metrics.liveness.timed_out_peers += 1;
+
+    fail_active_messages(endpoint);
+    delegate->on_endpoint_timed_out(endpoint);
+  }
+}
+
+/**
+ * Handles an incoming decoded message.
+ */
+void NetworkHandler::handle_decoded_message(
+    const std::shared_ptr<data_object::GenericValue> decoded_message,
+    const udp_interface::Endpoint& endpoint,
+    const std::shared_ptr<Codec> codec) {
+  if (decoded_message->is_array()) {
+    const auto array_items = decoded_message->array_items().value();
+    if (array_items->size() == 0) {
+      return;
+    }
+
+    const auto type = array_items->at(0)->string_value().value_or("");
+
+    if (type == "ack") {
+      if (array_items->size() < 2) {
+        return;
+      }
+      const auto message_id = array_items->at(1)->int_value().value_or(-1);
+      if (message_id < 0) {
+        return;
+      }
+      on_received_ack((unsigned int)message_id);
+
+    } else if (type == "fack") {
+      if (array_items->size() < 4) {
+        return;
+      }
+      const auto message_id = array_items->at(1)->int_value().value_or(-1);
+      const auto fragment_index = array_items->at(2)->int_value().value_or(-1);
+      const auto fragment_window = array_items->at(3)->int_value().value_or(1);
+      if (message_id < 0 || fragment_index < 0) {
+        return;
+      }
+      on_received_fragment_ack(
+          (unsigned int)message_id, (size_t)fragment_index,
+          fragment_window < 0 ? 1 : (size_t)fragment_window);
 
     } else if (type == "msg" || type == "sync" || type == "req_init_sync") {
       if (array_items->size() < 3) {
@@ -249,15 +882,19 @@ void NetworkHandler::handle_decoded_message(
 
       send_ack(message_id, endpoint, codec);
 
+      TRACE_MARK(dedup_start_time);
       const auto message_already_handled =
           get_message_reception_time(endpoint, message_id).has_value();
 
       update_message_reception_time(endpoint, message_id);
+      TRACE_SINCE(DEDUP, dedup_start_time);
 
       const auto message_type =
           get_message_type_from_string(type.c_str()).value();
 
-      if (!message_already_handled) {
+      if (message_already_handled) {
+        get_endpoint_metrics(endpoint).duplicates_dropped += 1;
+      } else {
         const auto decoded_message =
             IncomingDecodedMessage(endpoint, array_items->at(2), message_type);
         delegate->on_message_received(decoded_message);
@@ -266,6 +903,48 @@ void NetworkHandler::handle_decoded_message(
   }
 }
 
+/**
+ * Verifies and removes the checksum of the given packet, if it has one.
+ * Returns nothing, and counts the rejection, if the checksum does not match
+ * or if the packet has none while checksums are enabled.
+ */
+tl::optional<std::string> NetworkHandler::remove_checksum(
+    const std::string& packet) {
+  if (packet.empty()) {
+    return packet;
+  }
+
+  const uint8_t format_byte = packet[0];
+  if (!(format_byte & checksum_format_flag)) {
+    if (are_checksums_enabled) {
+      metrics.rejections.missing_checksums += 1;
+      return {};
+    }
+
+    return packet;
+  }
+
+  if (packet.size() < 1 + checksum_size) {
+    metrics.rejections.checksum_mismatches += 1;
+    return {};
+  }
+
+  const auto checked_size = packet.size() - checksum_size;
+  const auto bytes = (const uint8_t*)packet.data() + checked_size;
+  const uint32_t checksum = ((uint32_t)bytes[0] << 24) |
+                            ((uint32_t)bytes[1] << 16) |
+                            ((uint32_t)bytes[2] << 8) | bytes[3];
+  if (crc32Buffer(packet.data(), checked_size) != checksum) {
+    metrics.rejections.checksum_mismatches += 1;
+    return {};
+  }
+
+  std::string unchecked_packet = packet.substr(0, checked_size);
+  unchecked_packet[0] = (char)(format_byte & ~checksum_format_flag);
+
+  return unchecked_packet;
+}
+
 /**
  * Handles any incoming messages.
  * Throws an exception if no UDP interface is provided.
@@ -276,24 +955,55 @@ void NetworkHandler::handle_packet_reception() {
         "Network handler was not provided a UDP interface.");
   }
 
-  const auto incoming_message_optional = udp_interface->receive_packet();
+  TRACE_MARK(receive_start_time);
+  const auto received_message_optional = udp_interface->receive_packet();
+
+  if (!received_message_optional.has_value()) {
+    return;
+  }
+
+  const auto& received_message = received_message_optional.value();
+  auto& endpoint_metrics = get_endpoint_metrics(received_message.endpoint);
+  endpoint_metrics.packets_received += 1;
+  endpoint_metrics.bytes_received += received_message.data.size();
+
+  const auto packet = remove_checksum(received_message.data);
+  if (!packet.has_value()) {
+    return;
+  }
+
+  on_peer_seen(received_message.endpoint);
 
-  if (!incoming_message_optional.has_value()) {
+  const udp_interface::IncomingMessage incoming_message(
+      received_message.endpoint, packet.value());
+  TRACE_SINCE(RECEIVE, receive_start_time);
+  if (incoming_message.data.length() > 0 &&
+      ((uint8_t)incoming_message.data.at(0) & fragment_format_flag)) {
+    handle_incoming_fragment(incoming_message);
     return;
   }
 
-  const auto incoming_message = incoming_message_optional.value();
+  handle_incoming_packet(incoming_message);
+}
+
+/**
+ * Decodes and handles a complete incoming packet.
+ */
+void NetworkHandler::handle_incoming_packet(
+    const udp_interface::IncomingMessage& incoming_message) {
   const auto codec_optional = get_codec_from_incoming_message(incoming_message);
 
   if (!codec_optional.has_value()) {
+    metrics.rejections.unknown_formats += 1;
     return;
   }
 
   const auto codec = codec_optional.value();
-  const auto decoded_message_optional =
-      get_data_object_from_incoming_message(incoming_message, codec);
+  const auto decoded_message_optional = TRACE_CALL(
+      DECODE, get_data_object_from_incoming_message(incoming_message, codec));
 
   if (!decoded_message_optional.has_value()) {
+    metrics.rejections.decode_failures += 1;
     return;
   }
 
@@ -302,6 +1012,192 @@ void NetworkHandler::handle_packet_reception() {
   handle_decoded_message(decoded_message, incoming_message.endpoint, codec);
 }
 
+/**
+ * Adds an incoming fragment to the reassembly of its message and acknowledges
+ * it, unless the reassembly limits do not leave room for it. Once all
+ * fragments have arrived, the reassembled packet is handled. Fragments of
+ * messages that were already handled are answered with an ack of the whole
+ * message, in case it was lost.
+ */
+void NetworkHandler::handle_incoming_fragment(
+    const udp_interface::IncomingMessage& incoming_message) {
+  const auto& data = incoming_message.data;
+  if (data.length() <= fragment_header_size) {
+    return;
+  }
+
+  const uint8_t format_byte = (uint8_t)data[0] & ~fragment_format_flag;
+  const auto format =
+      get_data_format_from_format_byte(format_byte & ~compressed_format_flag);
+  if (!format.has_value()) {
+    metrics.rejections.unknown_formats += 1;
+    return;
+  }
+
+  const auto bytes = (const uint8_t*)data.data();
+  const unsigned int message_id =
+      ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8) | bytes[3];
+  const size_t fragment_index = ((size_t)bytes[4] << 8) | bytes[5];
+  const size_t fragment_count = ((size_t)bytes[6] << 8) | bytes[7];
+  if (fragment_index >= fragment_count) {
+    return;
+  }
+
+  const auto& endpoint = incoming_message.endpoint;
+  const auto codec = create_codec_from_format(format.value(), codec_options);
+
+  if (get_message_reception_time(endpoint, message_id).has_value()) {
+    get_endpoint_metrics(endpoint).duplicates_dropped += 1;
+    send_fragment_ack(message_id, fragment_index, 1, endpoint, codec);
+    send_ack(message_id, endpoint, codec);
+    return;
+  }
+
+  const auto key = std::make_pair(endpoint, message_id);
+  auto it = reassemblies.find(key);
+  if (it != reassemblies.end() &&
+      (it->second.fragment_count != fragment_count ||
+       it->second.format_byte != format_byte)) {
+    reassemblies.erase(it);
+    it = reassemblies.end();
+  }
+
+  const auto fragment_byte_count = data.length() - fragment_header_size;
+
+  // all fragments but the last are full, so a message whose other fragments
+  // alone fill the buffer can never be reassembled
+  if (fragment_index + 1 < fragment_count &&
+      (fragment_count - 1) * fragment_byte_count >= max_reassembly_bytes) {
+    if (it != reassemblies.end()) {
+      reassemblies.erase(it);
+    }
+    send_fragment_ack(message_id, fragment_index, 0, endpoint, codec);
+    return;
+  }
+
+  if (it == reassemblies.end()) {
+    while (reassemblies.size() >= max_reassemblies) {
+      if (!remove_oldest_reassembly(key)) {
+        return;
+      }
+    }
+
+    it = reassemblies
+             .insert(std::make_pair(
+                 key, Reassembly(format_byte, fragment_count,
+                                 time_in_deciseconds)))
+             .first;
+  }
+
+  auto& reassembly = it->second;
+  reassembly.last_update_time = time_in_deciseconds;
+
+  if (reassembly.fragments.count(fragment_index) > 0) {
+    get_endpoint_metrics(endpoint).duplicates_dropped += 1;
+    send_fragment_ack(message_id, fragment_index,
+                      get_fragment_window(fragment_byte_count), endpoint,
+                      codec);
+    return;
+  }
+
+  while (get_reassembly_byte_count() + fragment_byte_count >
+         max_reassembly_bytes) {
+    if (!remove_oldest_reassembly(key)) {
+      reassemblies.erase(key);
+      send_fragment_ack(message_id, fragment_index, 0, endpoint, codec);
+      return;
+    }
+  }
+
+  reassembly.fragments[fragment_index] = data.substr(fragment_header_size);
+  reassembly.byte_count += fragment_byte_count;
+
+  send_fragment_ack(message_id, fragment_index,
+                    get_fragment_window(fragment_byte_count), endpoint, codec);
+
+  if (reassembly.fragments.size() < reassembly.fragment_count) {
+    return;
+  }
+
+  std::string packet;
+  packet.reserve(1 + reassembly.byte_count);
+  packet += (char)reassembly.format_byte;
+  for (const auto& fragment : reassembly.fragments) {
+    packet += fragment.second;
+  }
+  reassemblies.erase(key);
+
+  handle_incoming_packet(udp_interface::IncomingMessage(endpoint, packet));
+}
+
+/**
+ * Returns how many more fragments of the given size fit into the reassembly
+ * buffer, between 1 and 64, to be advertised to the sender.
+ */
+size_t NetworkHandler::get_fragment_window(
+    const size_t fragment_byte_count) const {
+  const auto byte_count = get_reassembly_byte_count();
+  const auto free_byte_count =
+      byte_count < max_reassembly_bytes ? max_reassembly_bytes - byte_count : 0;
+  const auto window = free_byte_count / fragment_byte_count;
+
+  return window < 1 ? 1 : window > 64 ? 64 : window;
+}
+
+/**
+ * Returns the number of bytes held by all reassemblies.
+ */
+size_t NetworkHandler::get_reassembly_byte_count() const {
+  size_t byte_count = 0;
+  for (const auto& reassembly : reassemblies) {
+    byte_count += reassembly.second.byte_count;
+  }
+
+  return byte_count;
+}
+
+/**
+ * Removes the least recently updated reassembly other than the one with the
+ * given key. Returns false if there is none.
+ */
+bool NetworkHandler::remove_oldest_reassembly(
+    const std::pair<udp_interface::Endpoint, unsigned int>& key_to_keep) {
+  auto oldest = reassemblies.end();
+  for (auto it = reassemblies.begin(); it != reassemblies.end(); it++) {
+    if (it->first == key_to_keep) {
+      continue;
+    }
+
+    if (oldest == reassemblies.end() ||
+        time_in_deciseconds - it->second.last_update_time >
+            time_in_deciseconds - oldest->second.last_update_time) {
+      oldest = it;
+    }
+  }
+
+  if (oldest == reassemblies.end()) {
+    return false;
+  }
+
+  reassemblies.erase(oldest);
+  return true;
+}
+
+/**
+ * Removes all reassemblies that have not received a fragment for a while.
+ */
+void NetworkHandler::remove_expired_reassemblies() {
+  auto it = reassemblies.begin();
+  while (it != reassemblies.end()) {
+    uint32_t age = time_in_deciseconds - it->second.last_update_time;
+    if (age > reassembly_timeout_in_deciseconds) {
+      it = reassemblies.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
 /**
  * Returns the reception time of the message with the given ID from the given
  * endpoint, if it exists and has not expired.
@@ -325,9 +1221,36 @@ tl::optional<uint32_t> NetworkHandler::get_message_reception_time(
 void NetworkHandler::update_message_reception_time(
     const udp_interface::Endpoint endpoint, const unsigned int message_id) {
   const auto key = std::make_pair(endpoint, message_id);
+
+  if (capacity::is_full(message_reception_times.size(),
+                        capacity::max_dedup_entries) &&
+      message_reception_times.count(key) == 0) {
+    remove_oldest_message_reception_time();
+  }
+
   message_reception_times[key] = time_in_deciseconds;
 }
 
+/**
+ * Forgets the message that was received the longest time ago, to make room
+ * for another one in bounded mode.
+ */
+void NetworkHandler::remove_oldest_message_reception_time() {
+  auto oldest = message_reception_times.begin();
+  for (auto it = message_reception_times.begin();
+       it != message_reception_times.end(); it++) {
+    if (time_in_deciseconds - it->second >
+        time_in_deciseconds - oldest->second) {
+      oldest = it;
+    }
+  }
+
+  if (oldest != message_reception_times.end()) {
+    message_reception_times.erase(oldest);
+    metrics.capacity.forgotten_message_ids += 1;
+  }
+}
+
 /**
  * Removes all message reception times that have expired.
  */
@@ -343,19 +1266,67 @@ void NetworkHandler::remove_expired_message_reception_times() {
   }
 }
 
+/**
+ * Makes room for a message of the given priority by evicting the oldest
+ * active message of the lowest priority below it. Returns false if no active
+ * message has a lower priority.
+ */
+bool NetworkHandler::evict_active_message(const MessagePriority priority) {
+  auto evicted = active_messages.end();
+  for (auto it = active_messages.begin(); it != active_messages.end(); it++) {
+    if (it->get_priority() < priority &&
+        (evicted == active_messages.end() ||
+         it->get_priority() < evicted->get_priority())) {
+      evicted = it;
+    }
+  }
+
+  if (evicted == active_messages.end()) {
+    return false;
+  }
+
+  const auto message = evicted->get_network_message();
+  const auto message_id = evicted->get_message_id();
+  active_messages.erase(evicted);
+  metrics.capacity.evicted_messages += 1;
+
+  message->on_rejected();
+  delegate->on_message_discarded(message_id);
+
+  return true;
+}
+
 /**
  * Sends the given message and adds it to the list of active messages. The
- * message will be retried if it fails to be transmitted.
+ * message will be retried if it fails to be transmitted. If the send budget of
+ * the current 100 ms period is exhausted, or if the endpoint is suspected to
+ * be unreachable, the message is only queued and sent in order of priority
+ * once budget is available and the endpoint was heard from. If the number of
+ * active messages is limited and reached, a message of a lower priority is
+ * evicted to make room, or the message is rejected.
  */
 void NetworkHandler::send_message(const std::shared_ptr<NetworkMessage> message,
                                   const udp_interface::Endpoint endpoint,
                                   const unsigned int max_retries,
                                   const std::shared_ptr<Codec> codec) {
-  const auto active_network_message = ActiveNetworkMessage(
-      message, endpoint, codec, get_next_active_message_id(), max_retries);
-  active_messages.push_back(active_network_message);
+  if (capacity::is_full(active_messages.size(), capacity::max_in_flight) &&
+      !evict_active_message(message->get_priority())) {
+    metrics.capacity.rejected_messages += 1;
+    message->on_rejected();
+    return;
+  }
 
-  send_active_message(active_network_message);
+  active_messages.push_back(ActiveNetworkMessage(
+      message, endpoint, codec, get_next_active_message_id(), max_retries));
+  if (active_messages.size() > metrics.max_active_message_count) {
+    metrics.max_active_message_count = active_messages.size();
+  }
+
+  if (has_send_budget() && !is_peer_suspected(endpoint)) {
+    messages_sent_this_decisecond += send_active_message(
+        active_messages.back(), get_remaining_send_budget());
+    discard_refused_messages();
+  }
 }
 
 /**
@@ -366,7 +1337,7 @@ void NetworkHandler::send_message(const std::shared_ptr<NetworkMessage> message,
                                   const udp_interface::Endpoint endpoint,
                                   const unsigned int max_retries) {
   send_message(message, endpoint, max_retries,
-               create_codec_from_format(default_data_format));
+               create_codec_from_format(default_data_format, codec_options));
 }
 
 /**
@@ -393,6 +1364,231 @@ void NetworkHandler::set_default_data_format(
   default_data_format = new_default_data_format;
 }
 
+const CodecOptions& NetworkHandler::get_codec_options() const {
+  return codec_options;
+}
+
+/**
+ * Sets the options used to create codecs for incoming messages and for
+ * messages sent in the default data format.
+ */
+void NetworkHandler::set_codec_options(const CodecOptions new_codec_options) {
+  codec_options = new_codec_options;
+}
+
+size_t NetworkHandler::get_compression_threshold() const {
+  return compression_threshold;
+}
+
+/**
+ * Compresses outgoing packets whose encoding is at least the given number of
+ * bytes long. Pass 0 to disable compression. Compressed packets are always
+ * accepted, regardless of this setting.
+ */
+void NetworkHandler::set_compression_threshold(const size_t new_threshold) {
+  compression_threshold = new_threshold;
+}
+
+size_t NetworkHandler::get_max_packet_size() const { return max_packet_size; }
+
+/**
+ * Sets the size above which packets are sent in fragments. Pass 0 to never
+ * fragment. Sizes below 64 bytes are raised to 64.
+ */
+void NetworkHandler::set_max_packet_size(const size_t new_max_size) {
+  if (new_max_size == 0) {
+    max_packet_size = 0;
+    return;
+  }
+
+  max_packet_size = new_max_size < 64 ? 64 : new_max_size;
+}
+
+/**
+ * Sets how many fragments of a message are sent before the receiver has
+ * advertised how many it can buffer.
+ */
+void NetworkHandler::set_initial_fragment_window(const size_t new_window) {
+  initial_fragment_window = new_window < 1 ? 1 : new_window;
+}
+
+bool NetworkHandler::get_checksums_enabled() const {
+  return are_checksums_enabled;
+}
+
+/**
+ * Enables or disables checksums. While enabled, every outgoing packet ends
+ * with a CRC32, and incoming packets without one are rejected, so every
+ * endpoint of a group must use the same setting. Packets with a checksum are
+ * always verified, regardless of this setting.
+ */
+void NetworkHandler::set_checksums_enabled(const bool new_checksums_enabled) {
+  are_checksums_enabled = new_checksums_enabled;
+}
+
+/**
+ * Returns how many incoming packets were rejected so far, by reason.
+ */
+const PacketRejectionCounts& NetworkHandler::get_packet_rejection_counts()
+    const {
+  return metrics.rejections;
+}
+
+/**
+ * Decodes the given packet without handling it, e.g. to find out where to
+ * route it before it is handed to the NetworkHandler that handles it. Returns
+ * nothing if the packet is a fragment, or if its checksum does not match or
+ * it cannot be decoded, which is counted like for handled packets.
+ */
+tl::optional<std::shared_ptr<data_object::GenericValue>>
+NetworkHandler::peek_packet(const std::string& packet) {
+  const auto unchecked_packet = remove_checksum(packet);
+  if (!unchecked_packet.has_value() || unchecked_packet.value().empty() ||
+      ((uint8_t)unchecked_packet.value()[0] & fragment_format_flag)) {
+    return {};
+  }
+
+  const udp_interface::IncomingMessage incoming_message(
+      udp_interface::Endpoint(), unchecked_packet.value());
+  const auto codec = get_codec_from_incoming_message(incoming_message);
+  if (!codec.has_value()) {
+    metrics.rejections.unknown_formats += 1;
+    return {};
+  }
+
+  const auto decoded_message =
+      get_data_object_from_incoming_message(incoming_message, codec.value());
+  if (!decoded_message.has_value()) {
+    metrics.rejections.decode_failures += 1;
+  }
+
+  return decoded_message;
+}
+
+/**
+ * Returns the traffic counters, rejection counts, ack latencies, and queue
+ * depths recorded since the NetworkHandler was created or its metrics were
+ * last reset. The reference stays valid for the lifetime of the
+ * NetworkHandler and its counters keep changing as it runs; the current queue
+ * depth is only filled in by each call.
+ */
+const NetworkMetrics& NetworkHandler::get_metrics() const {
+  metrics.active_message_count = active_messages.size();
+
+  return metrics;
+}
+
+/**
+ * Clears all metrics. The high-water mark of the queue restarts at the
+ * current queue depth, and tracked peers keep their (now empty) counters.
+ */
+void NetworkHandler::reset_metrics() {
+  metrics = NetworkMetrics();
+  metrics.max_active_message_count = active_messages.size();
+  capacity::reserve(metrics.endpoints, capacity::max_peers);
+
+  for (const auto& peer : peer_liveness) {
+    metrics.endpoints[peer.first];
+  }
+}
+
+/**
+ * Returns the traffic counters of the given endpoint if it is a tracked peer,
+ * and the untracked_endpoints counters otherwise. Never adds an entry, so
+ * that packets from arbitrary sources cannot grow the metrics.
+ */
+EndpointMetrics& NetworkHandler::get_endpoint_metrics(
+    const udp_interface::Endpoint& endpoint) const {
+  const auto it = metrics.endpoints.find(endpoint);
+  if (it != metrics.endpoints.end()) {
+    return it->second;
+  }
+
+  return metrics.untracked_endpoints;
+}
+
+/**
+ * Reserves the storage of the containers whose size is limited in bounded
+ * mode, so that they do not allocate later on. Does nothing otherwise.
+ */
+void NetworkHandler::reserve_capacity() {
+  capacity::reserve(active_messages, capacity::max_in_flight);
+  capacity::reserve(message_reception_times, capacity::max_dedup_entries);
+  capacity::reserve(metrics.endpoints, capacity::max_peers);
+  capacity::reserve(peer_liveness, capacity::max_peers);
+}
+
+const liveness::LivenessOptions& NetworkHandler::get_liveness_options() const {
+  return liveness_options;
+}
+
+/**
+ * Sets when keepalives are sent to tracked peers and when silent peers are
+ * suspected or given up on.
+ */
+void NetworkHandler::set_liveness_options(
+    const liveness::LivenessOptions new_options) {
+  liveness_options = new_options;
+}
+
+/**
+ * Starts monitoring the reachability of the given endpoint and counting its
+ * traffic separately. It is considered alive until it stays silent for the
+ * suspicion timeout. If the number of peers is limited and reached, the
+ * endpoint is not tracked.
+ */
+void NetworkHandler::track_peer(const udp_interface::Endpoint endpoint) {
+  if (peer_liveness.count(endpoint) != 0 ||
+      capacity::is_full(peer_liveness.size(), capacity::max_peers)) {
+    return;
+  }
+
+  auto& peer = peer_liveness[endpoint];
+  peer.last_seen_time = time_in_deciseconds;
+  peer.last_send_time = time_in_deciseconds;
+  metrics.endpoints[endpoint];
+}
+
+/**
+ * Stops monitoring the reachability of the given endpoint and drops its
+ * traffic counters; further traffic is added to untracked_endpoints. Its
+ * active messages are retried as usual.
+ */
+void NetworkHandler::untrack_peer(const udp_interface::Endpoint endpoint) {
+  peer_liveness.erase(endpoint);
+  metrics.endpoints.erase(endpoint);
+}
+
+/**
+ * Returns what is known about the reachability of the given endpoint, or
+ * nothing if it is not tracked.
+ */
+tl::optional<liveness::PeerLiveness> NetworkHandler::get_peer_liveness(
+    const udp_interface::Endpoint endpoint) const {
+  const auto it = peer_liveness.find(endpoint);
+  if (it == peer_liveness.end()) {
+    return {};
+  }
+
+  return it->second;
+}
+
+/**
+ * Limits how many fragmented messages are reassembled at once and how many
+ * bytes they may hold in total. When a limit is reached, the least recently
+ * updated reassembly is dropped; its sender will retry the missing fragments.
+ * Messages larger than the byte limit are refused. The byte limit defaults to
+ * a few KiB (see capacity::default_reassembly_bytes); objects of tens of KiB
+ * need a larger one. In bounded mode, it cannot exceed
+ * SMALL_DATA_SYNC_MAX_REASSEMBLY_BYTES.
+ */
+void NetworkHandler::set_reassembly_limits(const size_t new_max_reassemblies,
+                                           const size_t new_max_bytes) {
+  max_reassemblies = new_max_reassemblies;
+  max_reassembly_bytes =
+      capacity::limit_to(new_max_bytes, capacity::max_reassembly_bytes);
+}
+
 /**
  * Sets this NetworkHandler’s max message reception time in deciseconds.
  * Messages reception times expire after this duration.
@@ -402,6 +1598,23 @@ void NetworkHandler::set_max_message_reception_time_in_deciseconds(
   max_message_reception_time_in_deciseconds = new_max_time;
 }
 
+/**
+ * Returns how many messages may be sent (or resent) per 100 ms, or 0 if the
+ * number is unlimited.
+ */
+unsigned int NetworkHandler::get_max_messages_per_decisecond() const {
+  return max_messages_per_decisecond;
+}
+
+/**
+ * Limits how many messages may be sent (or resent) per 100 ms. Pass 0 to lift
+ * the limit.
+ */
+void NetworkHandler::set_max_messages_per_decisecond(
+    const unsigned int new_max_messages) {
+  max_messages_per_decisecond = new_max_messages;
+}
+
 /**
  * Cancels active messages that match the given filter.
  */
@@ -420,17 +1633,38 @@ void NetworkHandler::cancel_active_messages(
   }
 }
 
+/**
+ * Cancels the active messages to the given endpoint, e.g. since it was
+ * removed, so that they are no longer retransmitted.
+ */
+void NetworkHandler::cancel_active_messages(
+    const udp_interface::Endpoint& endpoint) {
+  auto it = active_messages.begin();
+  while (it != active_messages.end()) {
+    if (it->get_endpoint() == endpoint) {
+      it->get_network_message()->on_cancelled();
+      it = active_messages.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
 /**
  * To be called once every 100 ms.
  */
 void NetworkHandler::on_100_ms_passed() {
   time_in_deciseconds += 1;
+  messages_sent_this_decisecond = 0;
 
+  update_peer_liveness();
   send_active_messages();
 
   if (time_in_deciseconds % 16 == 0) {
     remove_expired_message_reception_times();
   }
+
+  remove_expired_reassemblies();
 }
 
 /**
@@ -2,10 +2,16 @@
 
 #include <deque>
 #include <functional>
+#include <map>
+#include <string>
+#include <vector>
 
+#include "Capacity/Capacity.h"
 #include "Codec/Codec.h"
 #include "DataFormat/DataFormat.h"
+#include "Liveness/Liveness.h"
 #include "NetworkHandlerDelegate/NetworkHandlerDelegate.h"
+#include "NetworkMetrics/NetworkMetrics.h"
 #include "NetworkMessage/NetworkMessage.h"
 #include "interfaces/UDPInterface/UDPInterface.h"
 #include "optional/include/tl/optional.hpp"
@@ -14,12 +20,23 @@
  * A network message that is actively being sent or retried.
  */
 struct ActiveNetworkMessage {
+ public:
+  enum class FragmentState : uint8_t { UNSENT, IN_FLIGHT, ACKED };
+
  private:
   std::shared_ptr<NetworkMessage> message;
   udp_interface::Endpoint endpoint;
   std::shared_ptr<Codec> codec;
   unsigned int message_id;
+  unsigned int max_retries;
   unsigned int retries_left;
+  MessagePriority priority;
+  std::string fragmented_packet;
+  size_t fragment_size = 0;
+  size_t fragment_window = 0;
+  std::vector<FragmentState> fragment_states;
+  tl::optional<uint32_t> first_send_time;
+  bool refused = false;
 
  public:
   ActiveNetworkMessage(const std::shared_ptr<NetworkMessage> message,
@@ -30,7 +47,9 @@ struct ActiveNetworkMessage {
         endpoint(endpoint),
         codec(codec),
         message_id(message_id),
-        retries_left(retries_left) {}
+        max_retries(retries_left),
+        retries_left(retries_left),
+        priority(message->get_priority()) {}
 
   std::shared_ptr<data_object::GenericValue> to_data_object() const;
 
@@ -44,7 +63,49 @@ struct ActiveNetworkMessage {
 
   unsigned int get_retries_left() const;
 
+  MessagePriority get_priority() const;
+
   bool decrement_retries();
+
+  void renew(const unsigned int new_message_id);
+
+  bool is_fragmented() const;
+
+  const std::string& get_fragmented_packet() const;
+
+  void set_fragmented_packet(const std::string packet,
+                             const size_t fragment_size,
+                             const size_t fragment_window);
+
+  size_t get_fragment_size() const;
+
+  size_t get_fragment_count() const;
+
+  FragmentState get_fragment_state(const size_t index) const;
+
+  void set_fragment_state(const size_t index, const FragmentState state);
+
+  bool ack_fragment(const size_t index);
+
+  bool are_all_fragments_acked() const;
+
+  void reset_fragment_states();
+
+  size_t count_fragments_in_flight() const;
+
+  size_t get_fragment_window() const;
+
+  void set_fragment_window(const size_t new_window);
+
+  void replenish_retries();
+
+  tl::optional<uint32_t> get_first_send_time() const;
+
+  void set_first_send_time(const uint32_t time_in_deciseconds);
+
+  bool is_refused() const;
+
+  void refuse();
 };
 
 /**
@@ -59,10 +120,38 @@ struct ActiveNetworkMessage {
  * out of order.
  *
  * Messages are formatted as follows:
- * A message can be either formatted as JSON or MessagePack depending on the
- * Codec used. The first byte of the message indicates the format:
+ * A message can be formatted as JSON, MessagePack, or packed MessagePack
+ * depending on the Codec used. The first byte of the message indicates the
+ * format:
  * 0x01 — JSON
  * 0x02 — MessagePack
+ * 0x03 — MessagePack with fixed-layout records (see PackedCodec)
+ *
+ * If the 0x80 bit of the format byte is set, the rest of the packet is
+ * compressed (see lzf::compress). Only packets at least as large as the
+ * compression threshold are compressed, and only if that makes them smaller.
+ *
+ * If a max packet size is set, larger packets are split into fragments.
+ * Fragmentation is off by default, since peers running a release without it
+ * drop fragments as packets of an unknown format. A fragment has the 0x40 bit
+ * of its format byte set, followed by the message ID (3 bytes), the fragment
+ * index (2 bytes), and the fragment count (2 bytes), all big-endian, and a
+ * slice of the packet after the format byte. Each
+ * fragment is acknowledged with a message whose type is “fack” and which
+ * contains the message ID, the fragment index, and how many more fragments
+ * the receiver can buffer. Only that many fragments are in flight at once;
+ * acknowledgments release the next ones right away unless messages of a higher
+ * priority are queued, and retries only resend fragments that were not
+ * acknowledged. Once all fragments have arrived, the packet is handled and
+ * acknowledged like any other. A receiver that can never buffer the whole
+ * message advertises a window of 0, and the sender gives up on the message.
+ * The sender gives up on messages that need more fragments than the fragment
+ * count can hold as well.
+ *
+ * If the 0x20 bit of the format byte is set, the packet ends with a big-endian
+ * CRC32 of all preceding bytes, which is verified before anything else. Every
+ * fragment carries its own checksum. Packets whose checksum does not match are
+ * dropped, as are packets without one while checksums are enabled.
  *
  * The actual message consists of an array with the following elements:
  * - The message type as a string.
@@ -71,6 +160,18 @@ struct ActiveNetworkMessage {
  *
  * Messages are acknowledged by sending a message whose type is “ack” and whose
  * ID matches the original message’s ID.
+ *
+ * The reachability of tracked peers can be monitored (see track_peer). Any
+ * packet received from a peer counts as a sign of life. If a keepalive
+ * interval is set and nothing was sent to a peer for that long, a message
+ * whose type is “alive” and which has no ID is sent to it; it is neither
+ * acknowledged nor handed to the delegate. If a suspicion timeout is set, a
+ * silent peer is suspected; its active messages are then kept but not
+ * retransmitted, apart from the keepalives that probe it. If a dead timeout
+ * is set and the peer times out, its active messages fail and the delegate is
+ * told. All three are off by default, since peers running a release without
+ * keepalives never send any and would time out while idle (see
+ * LivenessOptions).
  */
 struct NetworkHandler {
  private:
@@ -78,19 +179,75 @@ struct NetworkHandler {
       std::make_shared<EmptyNetworkHandlerDelegate>();
   std::shared_ptr<udp_interface::UDPInterface> udp_interface;
   DataFormat default_data_format = DataFormat::MSGPACK;
-  std::deque<ActiveNetworkMessage> active_messages;
+  CodecOptions codec_options;
+  capacity::Queue<ActiveNetworkMessage> active_messages;
   unsigned int next_active_message_id = 0;
   uint32_t time_in_deciseconds = 0;  // a decisecond is 100 ms
-  std::map<std::pair<udp_interface::Endpoint, unsigned int>, uint32_t>
+  capacity::Map<std::pair<udp_interface::Endpoint, unsigned int>, uint32_t>
       message_reception_times;
   uint32_t max_message_reception_time_in_deciseconds = 600;
+  unsigned int max_messages_per_decisecond = 0;  // 0 means unlimited
+  unsigned int messages_sent_this_decisecond = 0;
+  size_t compression_threshold = 0;  // 0 means never compress
+  size_t max_packet_size = 0;  // 0 means never fragment
+  size_t initial_fragment_window = 4;
+  bool are_checksums_enabled = false;
+  liveness::LivenessOptions liveness_options;
+  mutable capacity::Map<udp_interface::Endpoint, liveness::PeerLiveness>
+      peer_liveness;
+  mutable NetworkMetrics metrics;
+
+  /**
+   * The fragments of a message that have arrived so far.
+   */
+  struct Reassembly {
+    uint8_t format_byte;
+    size_t fragment_count;
+    std::map<size_t, std::string> fragments;
+    size_t byte_count = 0;
+    uint32_t last_update_time;
+
+    Reassembly(const uint8_t format_byte, const size_t fragment_count,
+               const uint32_t time)
+        : format_byte(format_byte),
+          fragment_count(fragment_count),
+          last_update_time(time) {}
+  };
+
+  std::map<std::pair<udp_interface::Endpoint, unsigned int>, Reassembly>
+      reassemblies;
+  size_t max_reassemblies = 4;
+  size_t max_reassembly_bytes = capacity::limit_to(
+      capacity::default_reassembly_bytes, capacity::max_reassembly_bytes);
+  uint32_t reassembly_timeout_in_deciseconds = 50;
 
   unsigned int get_next_active_message_id();
 
-  bool send_active_message(const ActiveNetworkMessage& message) const;
+  bool renew_if_updated(ActiveNetworkMessage& message);
+
+  std::string create_packet(const std::shared_ptr<Codec> codec,
+                            const std::string& encoding) const;
+
+  bool send_packet(const udp_interface::Endpoint& endpoint,
+                   const std::string& packet) const;
+
+  unsigned int send_fragments(ActiveNetworkMessage& message,
+                              const unsigned int max_packets,
+                              const bool is_retry) const;
+
+  unsigned int send_active_message(ActiveNetworkMessage& message,
+                                   const unsigned int max_packets) const;
+
+  bool has_send_budget() const;
+
+  unsigned int get_remaining_send_budget() const;
+
+  void send_active_messages_with_priority(const MessagePriority priority);
 
   void send_active_messages();
 
+  void discard_refused_messages();
+
   tl::optional<std::shared_ptr<Codec>> get_codec_from_incoming_message(
       const udp_interface::IncomingMessage incoming_message) const;
 
@@ -101,15 +258,55 @@ struct NetworkHandler {
 
   void on_received_ack(const unsigned int message_id);
 
+  void on_received_fragment_ack(const unsigned int message_id,
+                                const size_t fragment_index,
+                                const size_t fragment_window);
+
+  bool has_active_messages_above(const MessagePriority priority) const;
+
+  void send_fragment_ack(const unsigned int message_id,
+                         const size_t fragment_index,
+                         const size_t fragment_window,
+                         const udp_interface::Endpoint& endpoint,
+                         const std::shared_ptr<Codec> codec) const;
+
   void send_ack(const unsigned int message_id,
                 const udp_interface::Endpoint& endpoint,
                 const std::shared_ptr<Codec> codec) const;
 
+  void send_keepalive(const udp_interface::Endpoint& endpoint,
+                      const std::shared_ptr<Codec> codec) const;
+
+  void on_peer_seen(const udp_interface::Endpoint& endpoint);
+
+  bool is_peer_suspected(const udp_interface::Endpoint& endpoint) const;
+
+  void fail_active_messages(const udp_interface::Endpoint& endpoint);
+
+  void update_peer_liveness();
+
   void handle_decoded_message(
       const std::shared_ptr<data_object::GenericValue> decoded_message,
       const udp_interface::Endpoint& endpoint,
       const std::shared_ptr<Codec> codec);
 
+  void handle_incoming_packet(
+      const udp_interface::IncomingMessage& incoming_message);
+
+  void handle_incoming_fragment(
+      const udp_interface::IncomingMessage& incoming_message);
+
+  size_t get_reassembly_byte_count() const;
+
+  size_t get_fragment_window(const size_t fragment_byte_count) const;
+
+  bool remove_oldest_reassembly(
+      const std::pair<udp_interface::Endpoint, unsigned int>& key_to_keep);
+
+  void remove_expired_reassemblies();
+
+  tl::optional<std::string> remove_checksum(const std::string& packet);
+
   void handle_packet_reception();
 
   tl::optional<uint32_t> get_message_reception_time(
@@ -119,8 +316,15 @@ struct NetworkHandler {
   void update_message_reception_time(const udp_interface::Endpoint endpoint,
                                      const unsigned int message_id);
 
+  void remove_oldest_message_reception_time();
+
   void remove_expired_message_reception_times();
 
+  bool evict_active_message(const MessagePriority priority);
+
+  EndpointMetrics& get_endpoint_metrics(
+      const udp_interface::Endpoint& endpoint) const;
+
  public:
   void send_message(const std::shared_ptr<NetworkMessage> message,
                     const udp_interface::Endpoint endpoint,
@@ -138,13 +342,53 @@ struct NetworkHandler {
 
   void set_default_data_format(const DataFormat new_default_data_format);
 
+  const CodecOptions& get_codec_options() const;
+  void set_codec_options(const CodecOptions new_codec_options);
+
+  size_t get_compression_threshold() const;
+  void set_compression_threshold(const size_t new_threshold);
+
+  size_t get_max_packet_size() const;
+  void set_max_packet_size(const size_t new_max_size);
+
+  void set_reassembly_limits(const size_t new_max_reassemblies,
+                             const size_t new_max_bytes);
+
+  void set_initial_fragment_window(const size_t new_window);
+
+  bool get_checksums_enabled() const;
+  void set_checksums_enabled(const bool new_checksums_enabled);
+
+  const PacketRejectionCounts& get_packet_rejection_counts() const;
+
+  tl::optional<std::shared_ptr<data_object::GenericValue>> peek_packet(
+      const std::string& packet);
+
+  const NetworkMetrics& get_metrics() const;
+  void reset_metrics();
+
+  void reserve_capacity();
+
+  const liveness::LivenessOptions& get_liveness_options() const;
+  void set_liveness_options(const liveness::LivenessOptions new_options);
+
+  void track_peer(const udp_interface::Endpoint endpoint);
+  void untrack_peer(const udp_interface::Endpoint endpoint);
+
+  tl::optional<liveness::PeerLiveness> get_peer_liveness(
+      const udp_interface::Endpoint endpoint) const;
+
   void set_max_message_reception_time_in_deciseconds(
       const uint32_t new_max_time);
 
+  unsigned int get_max_messages_per_decisecond() const;
+  void set_max_messages_per_decisecond(const unsigned int new_max_messages);
+
   void cancel_active_messages(
       const std::function<
           bool(const std::shared_ptr<data_object::GenericValue> info)>
           filter);
+  void cancel_active_messages(const udp_interface::Endpoint& endpoint);
 
   void on_100_ms_passed();
   void heartbeat();
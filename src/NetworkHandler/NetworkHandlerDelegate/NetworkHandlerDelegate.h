@@ -29,6 +29,8 @@ struct NetworkHandlerDelegate {
   virtual void on_decode_failed(std::string error,
                                 std::shared_ptr<Codec> codec) const {};
 
+  virtual void on_endpoint_timed_out(udp_interface::Endpoint endpoint) const {};
+
   virtual ~NetworkHandlerDelegate() = default;
 };
 
@@ -0,0 +1,40 @@
+#include "NetworkMetrics.h"
+
+#include <cstdint>
+
+/**
+ * Adds the given latency to the bucket it falls into.
+ */
+void AckLatencyHistogram::record(const uint32_t latency_in_deciseconds) {
+  size_t bucket_index = 0;
+  while (bucket_index < bucket_count - 1 &&
+         latency_in_deciseconds > get_upper_bound(bucket_index)) {
+    bucket_index += 1;
+  }
+
+  buckets[bucket_index] += 1;
+}
+
+/**
+ * Returns the number of recorded latencies.
+ */
+uint32_t AckLatencyHistogram::get_count() const {
+  uint32_t count = 0;
+  for (const auto bucket : buckets) {
+    count += bucket;
+  }
+
+  return count;
+}
+
+/**
+ * Returns the largest latency in deciseconds counted by the given bucket:
+ * 0, 1, 2, 4, 8, 16, 32, and UINT32_MAX for the last bucket.
+ */
+uint32_t AckLatencyHistogram::get_upper_bound(const size_t bucket_index) {
+  if (bucket_index >= bucket_count - 1) {
+    return UINT32_MAX;
+  }
+
+  return bucket_index == 0 ? 0 : 1u << (bucket_index - 1);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Capacity/Capacity.h"
+#include "interfaces/UDPInterface/UDPInterface.h"
+
+/**
+ * How many incoming packets were rejected before being decoded, and why.
+ */
+struct PacketRejectionCounts {
+  uint32_t checksum_mismatches = 0;
+  uint32_t missing_checksums = 0;
+  uint32_t unknown_formats = 0;
+  uint32_t decode_failures = 0;
+};
+
+/**
+ * Traffic exchanged with a single endpoint.
+ */
+struct EndpointMetrics {
+  uint32_t packets_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint32_t packets_received = 0;
+  uint64_t bytes_received = 0;
+  uint32_t retransmissions = 0;
+  uint32_t duplicates_dropped = 0;
+};
+
+/**
+ * Counts how long messages took to be acknowledged, measured from their first
+ * transmission in deciseconds. Bucket i holds latencies up to
+ * get_upper_bound(i); the bounds double from bucket to bucket, and the last
+ * bucket holds everything above.
+ */
+struct AckLatencyHistogram {
+  static const size_t bucket_count = 8;
+
+  uint32_t buckets[bucket_count] = {};
+
+  void record(const uint32_t latency_in_deciseconds);
+
+  uint32_t get_count() const;
+
+  static uint32_t get_upper_bound(const size_t bucket_index);
+};
+
+/**
+ * How often a NetworkHandler ran out of room in bounded mode (see
+ * Capacity.h), and how many of its messages were refused, either by
+ * receivers that could not reassemble them or since they needed more
+ * fragments than a fragment header can count.
+ */
+struct CapacityCounts {
+  uint32_t evicted_messages = 0;
+  uint32_t rejected_messages = 0;
+  uint32_t forgotten_message_ids = 0;
+  uint32_t refused_messages = 0;
+};
+
+/**
+ * How often a NetworkHandler sent keepalives, suspected a peer, and gave up on
+ * a peer (see Liveness.h).
+ */
+struct LivenessCounts {
+  uint32_t keepalives_sent = 0;
+  uint32_t suspected_peers = 0;
+  uint32_t timed_out_peers = 0;
+};
+
+/**
+ * Counters kept by a NetworkHandler. Only tracked peers (see
+ * NetworkHandler::track_peer) get an entry in endpoints, which is added when
+ * they are tracked and removed when they are untracked. The traffic of all
+ * other endpoints, including packets that fail verification, is added up in
+ * untracked_endpoints, so updating the counters never allocates.
+ */
+struct NetworkMetrics {
+  capacity::Map<udp_interface::Endpoint, EndpointMetrics> endpoints;
+  EndpointMetrics untracked_endpoints;
+  PacketRejectionCounts rejections;
+  CapacityCounts capacity;
+  LivenessCounts liveness;
+  AckLatencyHistogram ack_latencies;
+  size_t active_message_count = 0;
+  size_t max_active_message_count = 0;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * The priority class of an outgoing network message. When the NetworkHandler’s
+ * send budget is limited, messages of a higher priority are sent first.
+ */
+enum class MessagePriority {
+  LOW = 0,
+  NORMAL = 1,
+  HIGH = 2,
+};
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "DataObject/DataObject.h"
+#include "MessagePriority/MessagePriority.h"
 #include "NetworkHandler/MessageType/MessageType.h"
 
 /**
@@ -20,6 +21,19 @@ struct NetworkMessage {
    */
   virtual MessageType get_message_type() const { return MessageType::MSG; }
 
+  /**
+   * Returns the priority class of this message.
+   */
+  virtual MessagePriority get_priority() const {
+    return MessagePriority::NORMAL;
+  }
+
+  /**
+   * Called each time the message is put on the wire, with the size of the
+   * packet in bytes.
+   */
+  virtual void on_emitted(const size_t packet_size) const {}
+
   /**
    * Called when the message has been successfully sent over the network.
    */
@@ -35,6 +49,22 @@ struct NetworkMessage {
    */
   virtual void on_cancelled() const {}
 
+  /**
+   * Called when a NetworkHandler with a limited number of active messages had
+   * no room for the message, either when it was sent or later on, when a
+   * message of a higher priority took its place. Behaves like a cancellation
+   * by default.
+   */
+  virtual void on_rejected() const { on_cancelled(); }
+
+  /**
+   * Returns true if the message’s contents were replaced since it was last
+   * sent, and clears that state. The NetworkHandler then sends the message
+   * under a new message ID with its retries replenished, so the receiver does
+   * not discard the new contents as a duplicate.
+   */
+  virtual bool take_pending_update() { return false; }
+
   /**
    * Returns a data object containing metadata about this message. This can be
    * overridden by subclasses to return additional type-specific metadata.
@@ -0,0 +1,163 @@
+#include "OS.h"
+
+#include <chrono>
+
+#if defined(SMALL_DATA_SYNC_FREERTOS)
+#include <esp_timer.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+#include <Arduino.h>
+#endif
+
+namespace os {
+#ifdef SMALL_DATA_SYNC_HAS_TASKS
+/**
+ * Waits for the task to finish, if it has been started.
+ */
+Task::~Task() { join(); }
+
+#if defined(SMALL_DATA_SYNC_FREERTOS)
+/**
+ * The FreeRTOS entry point of every task. Signals completion to `join` and
+ * deletes the task once the function returns.
+ */
+void Task::run(void *task) {
+  const auto self = static_cast<Task *>(task);
+
+  self->function();
+
+  xSemaphoreGive(self->finished);
+  vTaskDelete(nullptr);
+}
+
+/**
+ * Starts running the given function in a new task. Returns false if the task
+ * is already running or could not be created.
+ */
+bool Task::start(const std::function<void()> new_function,
+                 const TaskConfig &config) {
+  if (is_started()) {
+    return false;
+  }
+
+  function = new_function;
+  finished = xSemaphoreCreateBinary();
+  if (finished == nullptr) {
+    return false;
+  }
+
+  const auto core = config.core >= 0 && config.core < portNUM_PROCESSORS
+                        ? config.core
+                        : tskNO_AFFINITY;
+  const auto result = xTaskCreatePinnedToCore(
+      &Task::run, config.name, config.stack_size_in_bytes, this,
+      config.priority, &handle, core);
+
+  if (result != pdPASS) {
+    vSemaphoreDelete(finished);
+    finished = nullptr;
+    handle = nullptr;
+
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Blocks until the task’s function has returned.
+ */
+void Task::join() {
+  if (!is_started()) {
+    return;
+  }
+
+  xSemaphoreTake(finished, portMAX_DELAY);
+  vSemaphoreDelete(finished);
+  finished = nullptr;
+  handle = nullptr;
+}
+
+/**
+ * Returns true if the task has been started and not joined yet.
+ */
+bool Task::is_started() const { return handle != nullptr; }
+
+#elif defined(SMALL_DATA_SYNC_STD_THREAD)
+/**
+ * Starts running the given function in a new thread. Returns false if the
+ * task is already running.
+ */
+bool Task::start(const std::function<void()> new_function,
+                 const TaskConfig &config) {
+  if (is_started()) {
+    return false;
+  }
+
+  function = new_function;
+  thread = std::thread(function);
+
+  return true;
+}
+
+/**
+ * Blocks until the task’s function has returned.
+ */
+void Task::join() {
+  if (!is_started()) {
+    return;
+  }
+
+  thread.join();
+}
+
+/**
+ * Returns true if the task has been started and not joined yet.
+ */
+bool Task::is_started() const { return thread.joinable(); }
+#endif
+#endif
+
+/**
+ * Returns a monotonic timestamp in microseconds.
+ */
+uint64_t get_time_in_microseconds() {
+#if defined(SMALL_DATA_SYNC_FREERTOS)
+  return esp_timer_get_time();
+#elif defined(ARDUINO_ARCH_ESP8266)
+  return micros64();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/**
+ * Suspends the calling task for (at least) the given duration. On FreeRTOS,
+ * the duration is rounded up to whole ticks.
+ */
+void sleep_for_microseconds(uint32_t duration) {
+#if defined(SMALL_DATA_SYNC_FREERTOS)
+  const auto tick_in_microseconds = portTICK_PERIOD_MS * 1000;
+  vTaskDelay((duration + tick_in_microseconds - 1) / tick_in_microseconds);
+#elif defined(SMALL_DATA_SYNC_STD_THREAD)
+  std::this_thread::sleep_for(std::chrono::microseconds(duration));
+#elif defined(ARDUINO_ARCH_ESP8266)
+  delay(duration / 1000);
+  delayMicroseconds(duration % 1000);
+#endif
+}
+
+/**
+ * Lets other tasks of the same priority run.
+ */
+void yield() {
+#if defined(SMALL_DATA_SYNC_FREERTOS)
+  taskYIELD();
+#elif defined(SMALL_DATA_SYNC_STD_THREAD)
+  std::this_thread::yield();
+#elif defined(ARDUINO_ARCH_ESP8266)
+  ::yield();
+#endif
+}
+}  // namespace os
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+#if defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_ESP32)
+#define SMALL_DATA_SYNC_FREERTOS 1
+#define SMALL_DATA_SYNC_HAS_TASKS 1
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#elif defined(__linux__)
+#define SMALL_DATA_SYNC_STD_THREAD 1
+#define SMALL_DATA_SYNC_HAS_TASKS 1
+#include <thread>
+#endif
+
+/**
+ * A minimal operating system abstraction for running work in the background.
+ * Tasks are FreeRTOS tasks on the ESP32 and std::threads on Linux. Platforms
+ * without either (such as the ESP8266) do not define
+ * SMALL_DATA_SYNC_HAS_TASKS and cannot run tasks.
+ */
+namespace os {
+/**
+ * The core running the Wi-Fi stack on the ESP32 (PRO_CPU).
+ */
+const int PRO_CORE = 0;
+
+/**
+ * The core running the Arduino loop on the ESP32 (APP_CPU).
+ */
+const int APP_CORE = 1;
+
+/**
+ * Lets the operating system schedule a task on any core.
+ */
+const int NO_CORE_AFFINITY = -1;
+
+/**
+ * Describes how a task is created. The stack size, priority and core are only
+ * honored by FreeRTOS.
+ */
+struct TaskConfig {
+  const char *name = "small_data_sync";
+  uint32_t stack_size_in_bytes = 8192;
+  unsigned int priority = 5;
+  int core = NO_CORE_AFFINITY;
+
+  TaskConfig() = default;
+
+  TaskConfig(const char *name, uint32_t stack_size_in_bytes,
+             unsigned int priority, int core)
+      : name(name),
+        stack_size_in_bytes(stack_size_in_bytes),
+        priority(priority),
+        core(core) {}
+};
+
+#ifdef SMALL_DATA_SYNC_HAS_TASKS
+/**
+ * A function running in the background until it returns.
+ */
+struct Task {
+ private:
+  std::function<void()> function;
+#if defined(SMALL_DATA_SYNC_FREERTOS)
+  TaskHandle_t handle = nullptr;
+  SemaphoreHandle_t finished = nullptr;
+
+  static void run(void *task);
+#elif defined(SMALL_DATA_SYNC_STD_THREAD)
+  std::thread thread;
+#endif
+
+ public:
+  Task() = default;
+
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task();
+
+  bool start(const std::function<void()> new_function,
+             const TaskConfig &config);
+
+  void join();
+
+  bool is_started() const;
+};
+#endif
+
+uint64_t get_time_in_microseconds();
+
+void sleep_for_microseconds(uint32_t duration);
+
+void yield();
+}  // namespace os
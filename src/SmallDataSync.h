@@ -3,10 +3,16 @@
 #include "Codec/Codec.h"
 #include "Codec/codecs/JsonCodec.h"
 #include "Codec/codecs/MsgPackCodec.h"
+#include "Codec/codecs/PackedCodec.h"
 #include "DataObject/DataObject.h"
+#include "NetworkHandler/Lzf/Lzf.h"
 #include "NetworkHandler/NetworkHandler.h"
 #include "Synchronizable/Synchronizable.h"
+#include "Synchronizable/TypedSynchronizable/TypedSynchronizable.h"
+#include "Synchronizer/MultiGroupHost/MultiGroupHost.h"
 #include "Synchronizer/Synchronizer.h"
+#include "Synchronizer/ThreadedSynchronizer/ThreadedSynchronizer.h"
+#include "Tracing/Tracing.h"
 
 struct SmallDataSync {
  public:
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Synchronizable.h"
+
+/**
+ * An immutable copy of a synchronizable’s name and data object, taken at the
+ * time the snapshot is created. Used to hand a synchronizable’s state to
+ * another thread without sharing the (mutable) original.
+ */
+struct SynchronizableSnapshot : public Synchronizable {
+ private:
+  std::string name;
+  std::shared_ptr<data_object::GenericValue> data_object;
+
+ public:
+  SynchronizableSnapshot(const std::string name,
+                         const std::shared_ptr<data_object::GenericValue> data_object)
+      : name(name), data_object(data_object) {}
+
+  /**
+   * Creates a snapshot of the given synchronizable’s current state.
+   */
+  static std::shared_ptr<SynchronizableSnapshot> of(
+      const Synchronizable& synchronizable) {
+    return std::make_shared<SynchronizableSnapshot>(
+        synchronizable.get_name(), synchronizable.to_data_object());
+  }
+
+  std::string get_name() const override { return name; }
+
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return data_object;
+  }
+
+  /**
+   * Snapshots are immutable; this always returns false.
+   */
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) override {
+    return false;
+  }
+};
@@ -0,0 +1,687 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../Synchronizable.h"
+#include "DataObject/DataObject.h"
+#include "ErriezCRC32/ErriezCRC32.h"
+
+// Expands to action(field) for each of up to 16 fields.
+#define SMALL_DATA_SYNC_EXPAND(x) x
+#define SMALL_DATA_SYNC_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, \
+                               _12, _13, _14, _15, _16, NAME, ...)           \
+  NAME
+#define SMALL_DATA_SYNC_FOR_EACH(action, ...)                   \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_SELECT(                \
+      __VA_ARGS__,                                              \
+      SMALL_DATA_SYNC_FOR_EACH_16, SMALL_DATA_SYNC_FOR_EACH_15, \
+      SMALL_DATA_SYNC_FOR_EACH_14, SMALL_DATA_SYNC_FOR_EACH_13, \
+      SMALL_DATA_SYNC_FOR_EACH_12, SMALL_DATA_SYNC_FOR_EACH_11, \
+      SMALL_DATA_SYNC_FOR_EACH_10, SMALL_DATA_SYNC_FOR_EACH_9,  \
+      SMALL_DATA_SYNC_FOR_EACH_8, SMALL_DATA_SYNC_FOR_EACH_7,   \
+      SMALL_DATA_SYNC_FOR_EACH_6, SMALL_DATA_SYNC_FOR_EACH_5,   \
+      SMALL_DATA_SYNC_FOR_EACH_4, SMALL_DATA_SYNC_FOR_EACH_3,   \
+      SMALL_DATA_SYNC_FOR_EACH_2, SMALL_DATA_SYNC_FOR_EACH_1)   \
+  (action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_1(action, x) action(x)
+#define SMALL_DATA_SYNC_FOR_EACH_2(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_1(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_3(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_2(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_4(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_3(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_5(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_4(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_6(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_5(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_7(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_6(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_8(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_7(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_9(action, x, ...) \
+  action(x)                                        \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_8(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_10(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_9(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_11(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_10(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_12(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_11(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_13(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_12(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_14(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_13(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_15(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_14(action, __VA_ARGS__))
+#define SMALL_DATA_SYNC_FOR_EACH_16(action, x, ...) \
+  action(x)                                         \
+  SMALL_DATA_SYNC_EXPAND(SMALL_DATA_SYNC_FOR_EACH_15(action, __VA_ARGS__))
+
+#define SMALL_DATA_SYNC_VISIT_FIELD(field) visitor(#field, field);
+
+/**
+ * Declares the fields of a TypedSynchronizable that are synchronized. Must be
+ * placed in a public section of the struct. Supports up to 16 fields of type
+ * bool, any arithmetic type, FixedPoint, std::string, or std::vector<uint8_t>
+ * (sent as a blob). float fields are sent as float32.
+ */
+#define SMALL_DATA_SYNC_FIELDS(...)                                         \
+  template <typename Visitor>                                              \
+  void visit_fields(Visitor& visitor) {                                    \
+    SMALL_DATA_SYNC_FOR_EACH(SMALL_DATA_SYNC_VISIT_FIELD, __VA_ARGS__)     \
+  }                                                                        \
+  template <typename Visitor>                                              \
+  void visit_fields(Visitor& visitor) const {                              \
+    SMALL_DATA_SYNC_FOR_EACH(SMALL_DATA_SYNC_VISIT_FIELD, __VA_ARGS__)     \
+  }
+
+/**
+ * A number that is sent as an integer holding the value multiplied by Scale,
+ * e.g. a temperature with Scale 100 is sent with two decimal places. Small
+ * scaled values fit in 1 to 3 bytes instead of the 9 bytes of a float64.
+ * Values that are not finite, or whose scaled value does not fit into an
+ * int64, are sent as null, which the receiver refuses to apply.
+ */
+template <int64_t Scale>
+struct FixedPoint {
+  static_assert(Scale > 0, "The scale of a FixedPoint must be positive");
+
+  double value = 0;
+
+  FixedPoint() = default;
+  FixedPoint(const double value) : value(value) {}
+
+  operator double() const { return value; }
+};
+
+namespace typed_synchronizable {
+inline void write_field(data_object::Writer& writer, const bool value) {
+  writer.write_bool(value);
+}
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type write_field(
+    data_object::Writer& writer, const T value) {
+  if (std::is_floating_point<T>::value && sizeof(T) == sizeof(float)) {
+    writer.write_float32((float)value);
+  } else if (std::is_floating_point<T>::value) {
+    writer.write_number((double)value);
+  } else if (std::is_signed<T>::value) {
+    writer.write_int((int64_t)value);
+  } else {
+    writer.write_uint((uint64_t)value);
+  }
+}
+
+/**
+ * Returns true if the given scaled FixedPoint value is finite and rounds to a
+ * number that fits into an int64.
+ */
+inline bool is_scaled_value_in_range(const double scaled_value) {
+  return std::isfinite(scaled_value) &&
+         std::fabs(scaled_value) < 9223372036854775808.0;  // 2^63
+}
+
+template <int64_t Scale>
+void write_field(data_object::Writer& writer, const FixedPoint<Scale> value) {
+  const auto scaled_value = value.value * Scale;
+  if (!is_scaled_value_in_range(scaled_value)) {
+    writer.write_null();
+    return;
+  }
+
+  writer.write_int((int64_t)std::llround(scaled_value));
+}
+
+inline void write_field(data_object::Writer& writer, const std::string& value) {
+  writer.write_string(value);
+}
+
+inline void write_field(data_object::Writer& writer,
+                        const std::vector<uint8_t>& value) {
+  writer.write_blob(value.data(), value.size());
+}
+
+inline bool read_field(const data_object::GenericValue& value, bool& field) {
+  if (!value.is_bool()) {
+    return false;
+  }
+
+  field = value.bool_value().value();
+  return true;
+}
+
+/**
+ * Returns true if the given number is an integer, or a whole floating-point
+ * number (e.g. from JSON) that converts to an integer exactly.
+ */
+inline bool is_whole_number(const data_object::GenericValue& value) {
+  if (value.is_integer()) {
+    return true;
+  }
+
+  const auto number = value.number_value().value();
+  return std::isfinite(number) && number == std::trunc(number) &&
+         std::fabs(number) <= 9007199254740992.0;  // 2^53
+}
+
+/**
+ * Reads a signed integer field. Numbers that are not whole or do not fit into
+ * the field are rejected.
+ */
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value,
+                        bool>::type
+read_field(const data_object::GenericValue& value, T& field) {
+  if (!value.is_number() || !is_whole_number(value)) {
+    return false;
+  }
+
+  const auto int_value = value.int_value();
+  if (!int_value.has_value() ||
+      int_value.value() < std::numeric_limits<T>::min() ||
+      int_value.value() > std::numeric_limits<T>::max()) {
+    return false;
+  }
+
+  field = static_cast<T>(int_value.value());
+  return true;
+}
+
+/**
+ * Reads an unsigned integer field. Numbers that are not whole or do not fit
+ * into the field are rejected.
+ */
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_signed<T>::value &&
+                            !std::is_same<T, bool>::value,
+                        bool>::type
+read_field(const data_object::GenericValue& value, T& field) {
+  if (!value.is_number() || !is_whole_number(value)) {
+    return false;
+  }
+
+  const auto uint_value = value.uint_value();
+  if (!uint_value.has_value() ||
+      uint_value.value() > std::numeric_limits<T>::max()) {
+    return false;
+  }
+
+  field = static_cast<T>(uint_value.value());
+  return true;
+}
+
+/**
+ * Reads a floating-point field. Non-finite numbers, which JSON cannot carry
+ * either, and numbers beyond the range of the field are rejected.
+ */
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+read_field(const data_object::GenericValue& value, T& field) {
+  if (!value.is_number()) {
+    return false;
+  }
+
+  const auto number = value.number_value().value();
+  if (!std::isfinite(number) ||
+      std::fabs(number) > (double)std::numeric_limits<T>::max()) {
+    return false;
+  }
+
+  field = static_cast<T>(number);
+  return true;
+}
+
+/**
+ * Reads a FixedPoint field. Non-finite scaled values, and those a sender
+ * could not have written, are rejected.
+ */
+template <int64_t Scale>
+bool read_field(const data_object::GenericValue& value,
+                FixedPoint<Scale>& field) {
+  if (!value.is_number()) {
+    return false;
+  }
+
+  const auto scaled_value = value.number_value().value();
+  if (!is_scaled_value_in_range(scaled_value)) {
+    return false;
+  }
+
+  field.value = scaled_value / Scale;
+  return true;
+}
+
+inline bool read_field(const data_object::GenericValue& value,
+                       std::string& field) {
+  if (!value.is_string()) {
+    return false;
+  }
+
+  field = value.string_value().value();
+  return true;
+}
+
+/**
+ * Reads a blob field. Blobs that were sent over JSON arrive as base64 strings.
+ */
+inline bool read_field(const data_object::GenericValue& value,
+                       std::vector<uint8_t>& field) {
+  if (value.is_blob()) {
+    const auto view = value.blob_value().value();
+    field.assign(view.data, view.data + view.size);
+    return true;
+  }
+
+  if (value.is_string()) {
+    const auto decoded = base64::decode(value.string_value().value());
+    if (!decoded.has_value()) {
+      return false;
+    }
+
+    field = decoded.value();
+    return true;
+  }
+
+  return false;
+}
+
+inline bool is_little_endian() {
+  const uint16_t value = 1;
+  uint8_t first_byte;
+  std::memcpy(&first_byte, &value, 1);
+
+  return first_byte == 1;
+}
+
+/**
+ * Returns the code of a field type in a packed schema, or nullptr if fields of
+ * the type cannot be packed.
+ */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, const char*>::type
+get_packed_type_code(const T& field) {
+  if (std::is_same<T, bool>::value) {
+    return "b";
+  }
+
+  if (std::is_floating_point<T>::value) {
+    switch (sizeof(T)) {
+      case 4:
+        return "f4";
+      case 8:
+        return "f8";
+      default:
+        return nullptr;
+    }
+  }
+
+  static const char* const signed_codes[] = {"", "i1", "i2", "", "i4",
+                                             "", "",   "",   "i8"};
+  static const char* const unsigned_codes[] = {"", "u1", "u2", "", "u4",
+                                               "", "",   "",   "u8"};
+
+  return std::is_signed<T>::value ? signed_codes[sizeof(T)]
+                                  : unsigned_codes[sizeof(T)];
+}
+
+template <int64_t Scale>
+const char* get_packed_type_code(const FixedPoint<Scale>& field) {
+  return nullptr;
+}
+
+inline const char* get_packed_type_code(const std::string& field) {
+  return nullptr;
+}
+
+inline const char* get_packed_type_code(const std::vector<uint8_t>& field) {
+  return nullptr;
+}
+
+template <typename T>
+void pack_field(std::string& bytes, const T& field) {
+  char buffer[sizeof(T)];
+  std::memcpy(buffer, &field, sizeof(T));
+
+  if (!is_little_endian()) {
+    for (size_t i = 0; i < sizeof(T) / 2; i += 1) {
+      std::swap(buffer[i], buffer[sizeof(T) - 1 - i]);
+    }
+  }
+
+  bytes.append(buffer, sizeof(T));
+}
+
+inline void pack_field(std::string& bytes, const bool field) {
+  bytes += (char)(field ? 1 : 0);
+}
+
+template <int64_t Scale>
+void pack_field(std::string& bytes, const FixedPoint<Scale>& field) {}
+
+inline void pack_field(std::string& bytes, const std::string& field) {}
+
+inline void pack_field(std::string& bytes, const std::vector<uint8_t>& field) {}
+
+template <typename T>
+void unpack_field(const char* data, T& field) {
+  if (is_little_endian()) {
+    std::memcpy(&field, data, sizeof(T));
+    return;
+  }
+
+  char buffer[sizeof(T)];
+  for (size_t i = 0; i < sizeof(T); i += 1) {
+    buffer[i] = data[sizeof(T) - 1 - i];
+  }
+  std::memcpy(&field, buffer, sizeof(T));
+}
+
+/**
+ * Reads a bool from a single byte. Any byte other than 0 is true, so that a
+ * peer cannot produce a bool whose representation is invalid.
+ */
+inline void unpack_field(const char* data, bool& field) {
+  static_assert(sizeof(bool) == 1, "Packed bools take up a single byte");
+  field = data[0] != 0;
+}
+
+template <int64_t Scale>
+void unpack_field(const char* data, FixedPoint<Scale>& field) {}
+
+/**
+ * Returns false for values a packed record must not carry, i.e. non-finite
+ * floating-point numbers.
+ */
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+is_valid_packed_value(const T value) {
+  return std::isfinite(value);
+}
+
+template <typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, bool>::type
+is_valid_packed_value(const T& value) {
+  return true;
+}
+
+inline void unpack_field(const char* data, std::string& field) {}
+
+inline void unpack_field(const char* data, std::vector<uint8_t>& field) {}
+
+/**
+ * Describes the packed layout of a TypedSynchronizable: whether all of its
+ * fields can be packed, the hash identifying the layout, and its size.
+ */
+struct PackedSchema {
+  bool is_packable = true;
+  uint32_t hash = 0;
+  size_t size = 0;
+};
+
+/**
+ * Builds the PackedSchema of a TypedSynchronizable from its fields. The hash
+ * covers the names, types, and order of the fields.
+ */
+struct PackedSchemaBuilder {
+  PackedSchema schema;
+  std::string description;
+
+  template <typename T>
+  void operator()(const char* name, const T& field) {
+    const auto type_code = get_packed_type_code(field);
+    if (type_code == nullptr) {
+      schema.is_packable = false;
+      return;
+    }
+
+    description += std::string(name) + ":" + type_code + ";";
+    schema.size += sizeof(T);
+  }
+};
+
+/**
+ * Returns the PackedSchema of the given TypedSynchronizable’s type. It is built
+ * once per type.
+ */
+template <typename T>
+const PackedSchema& get_packed_schema(const T& instance) {
+  static const PackedSchema schema = [&instance]() {
+    auto builder = PackedSchemaBuilder();
+    instance.visit_fields(builder);
+    builder.schema.hash = crc32String(builder.description.c_str());
+
+    return builder.schema;
+  }();
+
+  return schema;
+}
+
+struct FieldPacker {
+  std::string& bytes;
+
+  FieldPacker(std::string& bytes) : bytes(bytes) {}
+
+  template <typename T>
+  void operator()(const char* name, const T& field) {
+    pack_field(bytes, field);
+  }
+};
+
+/**
+ * Checks the fields of a packed record before any of them is unpacked into
+ * the target.
+ */
+struct PackedFieldChecker {
+  const char* data;
+  bool is_valid = true;
+
+  PackedFieldChecker(const char* data) : data(data) {}
+
+  template <typename T>
+  void operator()(const char* name, const T& field) {
+    T value;
+    unpack_field(data, value);
+    is_valid = is_valid && is_valid_packed_value(value);
+    data += sizeof(T);
+  }
+};
+
+struct FieldUnpacker {
+  const char* data;
+
+  FieldUnpacker(const char* data) : data(data) {}
+
+  template <typename T>
+  void operator()(const char* name, T& field) {
+    unpack_field(data, field);
+    data += sizeof(T);
+  }
+};
+
+/**
+ * Counts the fields of a TypedSynchronizable.
+ */
+struct FieldCounter {
+  size_t count = 0;
+
+  template <typename T>
+  void operator()(const char* name, const T& field) {
+    count += 1;
+  }
+};
+
+/**
+ * Writes each field of a TypedSynchronizable as a key-value pair.
+ */
+struct FieldWriter {
+  data_object::Writer& writer;
+
+  FieldWriter(data_object::Writer& writer) : writer(writer) {}
+
+  template <typename T>
+  void operator()(const char* name, const T& field) {
+    writer.write_key(name);
+    write_field(writer, field);
+  }
+};
+
+/**
+ * Reads each field of a TypedSynchronizable from an object. Fields missing
+ * from the object are left unchanged.
+ */
+struct FieldReader {
+  const data_object::GenericValue& object;
+  bool has_failed = false;
+
+  FieldReader(const data_object::GenericValue& object) : object(object) {}
+
+  template <typename T>
+  void operator()(const char* name, T& field) {
+    const auto value = object[std::string(name)];
+    if (!value.has_value()) {
+      return;
+    }
+
+    if (!read_field(*value.value(), field)) {
+      has_failed = true;
+    }
+  }
+};
+
+/**
+ * A copy of a TypedSynchronizable’s fields that writes itself straight into
+ * a codec’s wire format.
+ */
+template <typename T>
+struct TypedValue : public data_object::EncodableValue {
+ private:
+  T fields;
+
+ public:
+  TypedValue(const T& fields) : fields(fields) {}
+
+  void write_to(data_object::Writer& writer) const override {
+    const auto& schema = get_packed_schema(fields);
+    if (writer.accepts_packed() && schema.is_packable) {
+      std::string bytes;
+      bytes.reserve(schema.size);
+      auto packer = FieldPacker(bytes);
+      fields.visit_fields(packer);
+
+      writer.write_packed(schema.hash, bytes);
+      return;
+    }
+
+    auto counter = FieldCounter();
+    fields.visit_fields(counter);
+
+    writer.begin_object(counter.count);
+    auto field_writer = FieldWriter(writer);
+    fields.visit_fields(field_writer);
+    writer.end_object();
+  }
+};
+}  // namespace typed_synchronizable
+
+/**
+ * A Synchronizable whose data object representation is generated from a list
+ * of fields declared with SMALL_DATA_SYNC_FIELDS:
+ *
+ *   struct Position : public TypedSynchronizable<Position> {
+ *     double x = 0;
+ *     double y = 0;
+ *
+ *     std::string get_name() const override { return "position"; }
+ *
+ *     SMALL_DATA_SYNC_FIELDS(x, y)
+ *   };
+ *
+ * The fields are synchronized as an object keyed by field name. When sent,
+ * they are written directly into the codec’s output instead of being converted
+ * to a tree of data objects first. The struct must be copyable, since a copy
+ * of it is taken each time it is synchronized.
+ *
+ * Received JSON and MessagePack objects are read from the decoded tree of data
+ * objects, since a packet is decoded before it is known which synchronizable
+ * it carries. Only packed records (see below) are read without a tree. Numbers
+ * that do not fit into their field, and non-whole numbers for integer fields,
+ * are rejected, which makes applying fail.
+ *
+ * If all fields are numeric or bool, the packed codec sends them as a
+ * fixed-layout binary record instead, which is copied back into the fields
+ * with memcpy. Records holding non-finite floating-point numbers are rejected
+ * as a whole, and any non-zero byte is read as true. Both sides must declare
+ * the same fields in the same order with the same types; records with a
+ * different schema hash are rejected.
+ */
+template <typename Derived>
+struct TypedSynchronizable : public Synchronizable {
+ private:
+  bool apply_from_packed_value(const data_object::GenericValue& value) {
+    const auto& schema =
+        typed_synchronizable::get_packed_schema(static_cast<Derived&>(*this));
+    if (!schema.is_packable ||
+        value.packed_schema_hash().value() != schema.hash) {
+      return false;
+    }
+
+    const auto bytes = value.packed_bytes().value();
+    if (bytes.size() != schema.size) {
+      return false;
+    }
+
+    auto checker = typed_synchronizable::PackedFieldChecker(bytes.data());
+    static_cast<Derived*>(this)->visit_fields(checker);
+    if (!checker.is_valid) {
+      return false;
+    }
+
+    auto unpacker = typed_synchronizable::FieldUnpacker(bytes.data());
+    static_cast<Derived*>(this)->visit_fields(unpacker);
+
+    return true;
+  }
+
+ public:
+  std::shared_ptr<data_object::GenericValue> to_data_object() const override {
+    return std::make_shared<typed_synchronizable::TypedValue<Derived>>(
+        static_cast<const Derived&>(*this));
+  }
+
+  bool apply_from_data_object(
+      const std::shared_ptr<data_object::GenericValue> data_object) override {
+    if (data_object->is_packed()) {
+      return apply_from_packed_value(*data_object);
+    }
+
+    if (!data_object->is_object()) {
+      return false;
+    }
+
+    auto reader = typed_synchronizable::FieldReader(*data_object);
+    static_cast<Derived*>(this)->visit_fields(reader);
+
+    return !reader.has_failed;
+  }
+};
@@ -101,6 +101,10 @@ void MDNSHandler::commit_scan_results() {
 
     if (!synchronizer->is_endpoint_known(endpoint)) {
       synchronizer->add_endpoint(endpoint);
+      if (!synchronizer->is_endpoint_known(endpoint)) {
+        // the synchronizer has no room for another peer
+        continue;
+      }
 
       synchronizer->perform_initial_synchronization(endpoint);
       synchronizer->request_initial_synchronization_from_endpoint(endpoint);
@@ -0,0 +1,423 @@
+#include "MultiGroupHost.h"
+
+#ifdef SMALL_DATA_SYNC_HAS_TASKS
+
+#include "Synchronizable/SynchronizableSnapshot.h"
+
+namespace synchronizer {
+MultiGroupHost::MultiGroupHost(
+    const std::shared_ptr<udp_interface::UDPInterface> udp_interface,
+    const size_t shard_count, const size_t queue_capacity)
+    : udp_interface(udp_interface),
+      queue_capacity(queue_capacity),
+      outgoing_packets(queue_capacity * 4),
+      should_run(false),
+      dropped_packet_count(0) {
+  const auto effective_shard_count = shard_count > 0 ? shard_count : 1;
+
+  for (size_t i = 0; i < effective_shard_count; i += 1) {
+    shards.push_back(std::unique_ptr<Shard>(new Shard(queue_capacity)));
+  }
+}
+
+MultiGroupHost::~MultiGroupHost() { stop(); }
+
+/**
+ * Hands a remote update over to the application thread. Updates that do not
+ * fit into the shard’s queue are kept on the shard’s task and handed over
+ * later, so none are lost.
+ */
+void MultiGroupHost::hand_over_remote_update(Shard& shard,
+                                             const GroupRemoteUpdate update) {
+  if (!shard.overflowing_remote_updates.empty() ||
+      !shard.remote_updates.push(update)) {
+    shard.overflowing_remote_updates.push_back(update);
+  }
+}
+
+/**
+ * Retries handing over remote updates that did not fit into the shard’s queue.
+ */
+void MultiGroupHost::flush_overflowing_remote_updates(Shard& shard) {
+  while (!shard.overflowing_remote_updates.empty()) {
+    if (!shard.remote_updates.push(shard.overflowing_remote_updates.front())) {
+      return;
+    }
+
+    shard.overflowing_remote_updates.pop_front();
+  }
+}
+
+/**
+ * Returns the group name hash the given packet carries if it is a
+ * synchronization message.
+ */
+tl::optional<uint32_t> MultiGroupHost::get_synchronization_group_name_hash(
+    const std::string& packet) {
+  const auto message = packet_decoder.peek_packet(packet);
+  if (!message.has_value() || !message.value()->is_array()) {
+    return {};
+  }
+
+  const auto items = message.value()->array_items().value();
+  if (items->size() < 3 ||
+      items->at(0)->string_value().value_or("") != "sync" ||
+      !items->at(2)->is_array()) {
+    return {};
+  }
+
+  const auto data_items = items->at(2)->array_items().value();
+  if (data_items->empty()) {
+    return {};
+  }
+
+  const auto group_name_hash = data_items->at(0)->int_value();
+  if (!group_name_hash.has_value()) {
+    return {};
+  }
+
+  return (uint32_t)group_name_hash.value();
+}
+
+/**
+ * Delivers a received packet to the inbox of the group its sender belongs
+ * to. A synchronization makes its sender belong to the group it is addressed
+ * to, even if the sender belonged to another group before, e.g. since it
+ * changed its group name. Synchronizations for groups that are not hosted
+ * drop the sender’s route.
+ */
+void MultiGroupHost::dispatch_incoming_packet(
+    const udp_interface::IncomingMessage& packet) {
+  auto group_name_hash = get_synchronization_group_name_hash(packet.data);
+  auto route = endpoint_to_group_name_hash.find(packet.endpoint);
+
+  if (!group_name_hash.has_value() &&
+      route != endpoint_to_group_name_hash.end()) {
+    group_name_hash = route->second;
+  }
+
+  if (!group_name_hash.has_value()) {
+    dropped_packet_count += 1;
+    return;
+  }
+
+  const auto it = groups.find(group_name_hash.value());
+  if (it == groups.end()) {
+    if (route != endpoint_to_group_name_hash.end()) {
+      endpoint_to_group_name_hash.erase(route);
+    }
+
+    dropped_packet_count += 1;
+    return;
+  }
+
+  endpoint_to_group_name_hash[packet.endpoint] = group_name_hash.value();
+
+  if (!it->second->udp_interface->deliver(packet.endpoint, packet.data)) {
+    dropped_packet_count += 1;
+  }
+}
+
+/**
+ * The I/O task’s main loop. Sends outgoing packets and dispatches incoming
+ * ones.
+ */
+void MultiGroupHost::run_io() {
+  while (should_run.load(std::memory_order_acquire)) {
+    for (unsigned int i = 0; i < packets_per_poll; i += 1) {
+      const auto packet = outgoing_packets.pop();
+
+      if (!packet.has_value()) {
+        break;
+      }
+
+      const auto& endpoint = packet.value().endpoint;
+      const auto& group_name_hash = packet.value().group_name_hash;
+
+      if (packet.value().releases_route) {
+        const auto route = endpoint_to_group_name_hash.find(endpoint);
+        if (route != endpoint_to_group_name_hash.end() &&
+            group_name_hash.has_value() &&
+            route->second == group_name_hash.value()) {
+          endpoint_to_group_name_hash.erase(route);
+        }
+
+        continue;
+      }
+
+      udp_interface->send_packet(endpoint, packet.value().packet);
+
+      // a group sending to a peer does not take it over from another group
+      if (group_name_hash.has_value()) {
+        endpoint_to_group_name_hash.emplace(endpoint, group_name_hash.value());
+      }
+    }
+
+    for (unsigned int i = 0; i < packets_per_poll; i += 1) {
+      const auto packet = udp_interface->receive_packet();
+
+      if (!packet.has_value()) {
+        break;
+      }
+
+      dispatch_incoming_packet(packet.value());
+    }
+
+    os::sleep_for_microseconds(poll_interval_in_microseconds);
+  }
+}
+
+/**
+ * A shard task’s main loop. Synchronizes posted synchronizables, handles
+ * incoming packets and ticks every Synchronizer of the shard.
+ */
+void MultiGroupHost::run_shard(Shard& shard) {
+  const uint64_t tick_interval_in_microseconds = 100000;
+  auto next_tick =
+      os::get_time_in_microseconds() + tick_interval_in_microseconds;
+
+  while (should_run.load(std::memory_order_acquire)) {
+    for (const auto group : shard.groups) {
+      while (true) {
+        const auto synchronizable = group->outgoing_synchronizables.pop();
+
+        if (!synchronizable.has_value()) {
+          break;
+        }
+
+        group->synchronizer->synchronize(synchronizable.value().first,
+                                         synchronizable.value().second);
+      }
+
+      unsigned int handled_packets = 0;
+      do {
+        group->synchronizer->heartbeat();
+        handled_packets += 1;
+      } while (!group->udp_interface->is_inbox_empty() &&
+               handled_packets < packets_per_poll);
+    }
+
+    const auto now = os::get_time_in_microseconds();
+    while (now >= next_tick) {
+      for (const auto group : shard.groups) {
+        group->synchronizer->on_100_ms_passed();
+        group->udp_interface->release_unknown_endpoints();
+      }
+
+      next_tick += tick_interval_in_microseconds;
+    }
+
+    flush_overflowing_remote_updates(shard);
+
+    os::sleep_for_microseconds(poll_interval_in_microseconds);
+  }
+}
+
+/**
+ * Adds the given Synchronizer to the host, keyed by its group name hash, and
+ * provides it with its multiplexed UDP interface. Must be called before
+ * `start`. Returns false if the host is running or already hosts a
+ * Synchronizer of the same group.
+ */
+bool MultiGroupHost::add_group(
+    const std::shared_ptr<Synchronizer> synchronizer) {
+  const auto group_name_hash = synchronizer->get_group_name_hash();
+
+  if (is_running() || groups.count(group_name_hash) != 0) {
+    return false;
+  }
+
+  // the interface is owned by the synchronizer, so it must not own it in turn
+  const auto synchronizer_pointer = synchronizer.get();
+  const auto group_udp_interface = std::make_shared<MultiplexedUdpInterface>(
+      group_name_hash,
+      [synchronizer_pointer](const udp_interface::Endpoint endpoint) {
+        return synchronizer_pointer->is_endpoint_known(endpoint);
+      },
+      outgoing_packets, queue_capacity);
+  synchronizer->set_udp_interface(group_udp_interface);
+
+  const auto group = new Group(group_name_hash, synchronizer,
+                               group_udp_interface, queue_capacity);
+  shards[groups.size() % shards.size()]->groups.push_back(group);
+  groups[group_name_hash] = std::unique_ptr<Group>(group);
+
+  return true;
+}
+
+/**
+ * Starts the I/O task and one task per shard. From now on, the hosted
+ * Synchronizers must not be accessed directly anymore until `stop` returns.
+ */
+void MultiGroupHost::start() {
+  if (is_running()) {
+    return;
+  }
+
+  for (const auto& shard : shards) {
+    const auto shard_pointer = shard.get();
+
+    for (const auto group : shard->groups) {
+      const auto group_name_hash = group->group_name_hash;
+
+      group->synchronizer->set_remote_update_handler(
+          [this, shard_pointer, group_name_hash](
+              const udp_interface::Endpoint endpoint,
+              const std::shared_ptr<Synchronizable> synchronizable,
+              const std::shared_ptr<data_object::GenericValue> data_object) {
+            hand_over_remote_update(
+                *shard_pointer,
+                GroupRemoteUpdate(group_name_hash,
+                                  RemoteUpdate(endpoint, synchronizable,
+                                               data_object)));
+          });
+    }
+  }
+
+  should_run.store(true, std::memory_order_release);
+
+  io_task.start([this]() { run_io(); }, io_task_config);
+
+  for (const auto& shard : shards) {
+    const auto shard_pointer = shard.get();
+    shard->task.start([this, shard_pointer]() { run_shard(*shard_pointer); },
+                      shard_task_config);
+  }
+}
+
+/**
+ * Stops all tasks and waits for them to finish. Remote updates that have not
+ * been applied yet can still be applied afterwards.
+ */
+void MultiGroupHost::stop() {
+  if (!is_running()) {
+    return;
+  }
+
+  should_run.store(false, std::memory_order_release);
+
+  io_task.join();
+  for (const auto& shard : shards) {
+    shard->task.join();
+  }
+
+  for (const auto& group : groups) {
+    group.second->synchronizer->set_remote_update_handler(nullptr);
+  }
+}
+
+/**
+ * Returns true if the host’s tasks are running.
+ */
+bool MultiGroupHost::is_running() const { return io_task.is_started(); }
+
+/**
+ * Takes a snapshot of the given synchronizable and posts it to the shard of
+ * the given group, which synchronizes it with all of the group’s endpoints
+ * using the given priority. May be called from any thread. Returns false if
+ * the group is unknown or its queue is full.
+ */
+bool MultiGroupHost::synchronize(
+    const uint32_t group_name_hash,
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const MessagePriority priority) {
+  const auto it = groups.find(group_name_hash);
+  if (it == groups.end()) {
+    return false;
+  }
+
+  return it->second->outgoing_synchronizables.push(std::make_pair(
+      std::static_pointer_cast<Synchronizable>(
+          SynchronizableSnapshot::of(*synchronizable)),
+      priority));
+}
+
+/**
+ * Applies all updates that have been received by any group since the last
+ * call and returns their number. Must always be called from the same
+ * (application) thread.
+ */
+unsigned int MultiGroupHost::apply_remote_updates() {
+  unsigned int count = 0;
+
+  for (const auto& shard : shards) {
+    while (true) {
+      const auto update_optional = shard->remote_updates.pop();
+
+      if (!update_optional.has_value()) {
+        break;
+      }
+
+      const auto& group_update = update_optional.value();
+      const auto& update = group_update.update;
+      update.apply();
+      group_to_synchronizables[group_update.group_name_hash][update.endpoint]
+                              [update.synchronizable->get_name()] =
+                                  update.synchronizable;
+
+      count += 1;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Returns the number of hosted groups.
+ */
+size_t MultiGroupHost::get_group_count() const { return groups.size(); }
+
+/**
+ * Returns the number of shards (and thereby shard tasks).
+ */
+size_t MultiGroupHost::get_shard_count() const { return shards.size(); }
+
+/**
+ * Returns how many received packets have been dropped because their sender
+ * did not belong to a hosted group or their group’s inbox was full.
+ */
+uint32_t MultiGroupHost::get_dropped_packet_count() const {
+  return dropped_packet_count.load();
+}
+
+/**
+ * Sets the options used to decode synchronizations from unknown senders. They
+ * should match those of the hosted Synchronizers. Must be called before
+ * `start`.
+ */
+void MultiGroupHost::set_codec_options(const CodecOptions new_codec_options) {
+  packet_decoder.set_codec_options(new_codec_options);
+}
+
+/**
+ * Sets how long the tasks sleep between polls. Must be called before `start`.
+ */
+void MultiGroupHost::set_poll_interval_in_microseconds(
+    unsigned int new_poll_interval) {
+  poll_interval_in_microseconds = new_poll_interval;
+}
+
+/**
+ * Sets how many packets are sent and received by the I/O task, and handled per
+ * group by the shard tasks, per poll. Must be called before `start`.
+ */
+void MultiGroupHost::set_packets_per_poll(unsigned int new_packets_per_poll) {
+  packets_per_poll = new_packets_per_poll;
+}
+
+/**
+ * Sets how the I/O task is created. Must be called before `start`.
+ */
+void MultiGroupHost::set_io_task_config(const os::TaskConfig& new_config) {
+  io_task_config = new_config;
+}
+
+/**
+ * Sets how the shard tasks are created. Must be called before `start`.
+ */
+void MultiGroupHost::set_shard_task_config(const os::TaskConfig& new_config) {
+  shard_task_config = new_config;
+}
+}  // namespace synchronizer
+
+#endif
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "OS/OS.h"
+
+#ifdef SMALL_DATA_SYNC_HAS_TASKS
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LockFreeQueue/MPSCQueue.h"
+#include "LockFreeQueue/SPSCQueue.h"
+#include "MultiplexedUdpInterface.h"
+#include "NetworkHandler/NetworkHandler.h"
+#include "Synchronizable/Synchronizable.h"
+#include "Synchronizer/RemoteUpdate/RemoteUpdate.h"
+#include "Synchronizer/Synchronizer.h"
+#include "interfaces/UDPInterface/UDPInterface.h"
+#include "optional/include/tl/optional.hpp"
+
+namespace synchronizer {
+/**
+ * Hosts many Synchronizers (one per group) on a single UDP socket.
+ *
+ * Packets are sent unchanged, so the hosted groups talk to ordinary
+ * Synchronizers. A dedicated I/O task owns the socket: it sends the packets
+ * the Synchronizers have posted to a lock-free MPSC queue and dispatches
+ * received packets into the inbox of the group their sender belongs to. A
+ * sender belongs to a group once that group sends to it as a known peer while
+ * it belongs to no other group, or once it sends a synchronization carrying
+ * the group name hash of a hosted group, which takes precedence over the group
+ * it belonged to before. It no longer belongs to a group once that group
+ * removes it, e.g. since it timed out. Other packets from unknown senders,
+ * and packets that do not fit into a full inbox, are dropped (and later
+ * retransmitted by the sender).
+ *
+ * The groups are spread evenly across a fixed number of shards. Each shard runs
+ * its own task which ticks and heartbeats all of its Synchronizers, so no
+ * Synchronizer is ever touched by more than one task. As with the
+ * ThreadedSynchronizer, application threads call `synchronize` and remote
+ * updates are applied on the application thread by `apply_remote_updates`.
+ *
+ * Each remote endpoint belongs to one group at a time, as is the case for
+ * plain Synchronizers, which have one socket per group. Groups must be added,
+ * configured and initialized before `start` is called.
+ */
+struct MultiGroupHost {
+ private:
+  struct Group {
+    uint32_t group_name_hash;
+    std::shared_ptr<Synchronizer> synchronizer;
+    std::shared_ptr<MultiplexedUdpInterface> udp_interface;
+    lock_free_queue::MPSCQueue<
+        std::pair<std::shared_ptr<Synchronizable>, MessagePriority>>
+        outgoing_synchronizables;
+
+    Group(const uint32_t group_name_hash,
+          const std::shared_ptr<Synchronizer> synchronizer,
+          const std::shared_ptr<MultiplexedUdpInterface> udp_interface,
+          const size_t queue_capacity)
+        : group_name_hash(group_name_hash),
+          synchronizer(synchronizer),
+          udp_interface(udp_interface),
+          outgoing_synchronizables(queue_capacity) {}
+  };
+
+  struct GroupRemoteUpdate {
+    uint32_t group_name_hash = 0;
+    RemoteUpdate update;
+
+    GroupRemoteUpdate() = default;
+
+    GroupRemoteUpdate(const uint32_t group_name_hash,
+                      const RemoteUpdate update)
+        : group_name_hash(group_name_hash), update(update) {}
+  };
+
+  struct Shard {
+    std::vector<Group*> groups;
+    lock_free_queue::SPSCQueue<GroupRemoteUpdate> remote_updates;
+    std::deque<GroupRemoteUpdate> overflowing_remote_updates;
+    os::Task task;
+
+    Shard(const size_t queue_capacity) : remote_updates(queue_capacity) {}
+  };
+
+  std::shared_ptr<udp_interface::UDPInterface> udp_interface;
+  size_t queue_capacity;
+  std::map<uint32_t, std::unique_ptr<Group>> groups;
+  std::vector<std::unique_ptr<Shard>> shards;
+  lock_free_queue::MPSCQueue<AddressedPacket> outgoing_packets;
+  std::map<udp_interface::Endpoint, uint32_t>
+      endpoint_to_group_name_hash;  // I/O task only
+  NetworkHandler packet_decoder;      // I/O task only
+  std::map<uint32_t,
+           std::map<udp_interface::Endpoint,
+                    std::map<std::string, std::shared_ptr<Synchronizable>>>>
+      group_to_synchronizables;  // application thread only
+  os::Task io_task;
+  os::TaskConfig io_task_config =
+      os::TaskConfig("sds_io", 8192, 5, os::PRO_CORE);
+  os::TaskConfig shard_task_config =
+      os::TaskConfig("sds_shard", 8192, 4, os::NO_CORE_AFFINITY);
+  std::atomic<bool> should_run;
+  std::atomic<uint32_t> dropped_packet_count;
+  uint32_t poll_interval_in_microseconds = 1000;
+  unsigned int packets_per_poll = 64;
+
+  void hand_over_remote_update(Shard& shard, const GroupRemoteUpdate update);
+
+  void flush_overflowing_remote_updates(Shard& shard);
+
+  tl::optional<uint32_t> get_synchronization_group_name_hash(
+      const std::string& packet);
+
+  void dispatch_incoming_packet(const udp_interface::IncomingMessage& packet);
+
+  void run_io();
+
+  void run_shard(Shard& shard);
+
+ public:
+  MultiGroupHost(
+      const std::shared_ptr<udp_interface::UDPInterface> udp_interface,
+      const size_t shard_count, const size_t queue_capacity = 256);
+
+  MultiGroupHost(const MultiGroupHost&) = delete;
+  MultiGroupHost& operator=(const MultiGroupHost&) = delete;
+
+  ~MultiGroupHost();
+
+  bool add_group(const std::shared_ptr<Synchronizer> synchronizer);
+
+  void start();
+  void stop();
+
+  bool is_running() const;
+
+  bool synchronize(const uint32_t group_name_hash,
+                   const std::shared_ptr<Synchronizable> synchronizable,
+                   const MessagePriority priority = MessagePriority::NORMAL);
+
+  unsigned int apply_remote_updates();
+
+  template <typename T = Synchronizable>
+  tl::optional<std::shared_ptr<T>> get_synchronizable_for_endpoint(
+      const uint32_t group_name_hash, const udp_interface::Endpoint endpoint,
+      const std::string synchronizable_name) const {
+    const auto group_it = group_to_synchronizables.find(group_name_hash);
+    if (group_it == group_to_synchronizables.end()) {
+      return {};
+    }
+
+    const auto endpoint_it = group_it->second.find(endpoint);
+    if (endpoint_it == group_it->second.end()) {
+      return {};
+    }
+
+    const auto it = endpoint_it->second.find(synchronizable_name);
+    if (it == endpoint_it->second.end()) {
+      return {};
+    }
+
+#ifdef ALLOW_DYNAMIC_CAST
+    const auto cast_value = std::dynamic_pointer_cast<T>(it->second);
+    if (cast_value) {
+      return cast_value;
+    }
+#endif
+    return std::static_pointer_cast<T>(it->second);
+  }
+
+  size_t get_group_count() const;
+
+  size_t get_shard_count() const;
+
+  uint32_t get_dropped_packet_count() const;
+
+  void set_codec_options(const CodecOptions new_codec_options);
+
+  void set_poll_interval_in_microseconds(unsigned int new_poll_interval);
+
+  void set_packets_per_poll(unsigned int new_packets_per_poll);
+
+  void set_io_task_config(const os::TaskConfig& new_config);
+
+  void set_shard_task_config(const os::TaskConfig& new_config);
+};
+}  // namespace synchronizer
+
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "LockFreeQueue/MPSCQueue.h"
+#include "LockFreeQueue/SPSCQueue.h"
+#include "interfaces/UDPInterface/UDPInterface.h"
+#include "optional/include/tl/optional.hpp"
+
+namespace synchronizer {
+/**
+ * A packet together with the endpoint it is sent to or received from. Outgoing
+ * packets carry the group name hash of the sending group if that group knows
+ * the endpoint as a peer. An outgoing entry that releases the route is not
+ * sent; it tells the I/O task that the group no longer knows the endpoint.
+ */
+struct AddressedPacket {
+  udp_interface::Endpoint endpoint;
+  std::string packet;
+  tl::optional<uint32_t> group_name_hash;
+  bool releases_route = false;
+
+  AddressedPacket() = default;
+
+  AddressedPacket(const udp_interface::Endpoint endpoint,
+                  const std::string packet,
+                  const tl::optional<uint32_t> group_name_hash = {},
+                  const bool releases_route = false)
+      : endpoint(endpoint),
+        packet(packet),
+        group_name_hash(group_name_hash),
+        releases_route(releases_route) {}
+};
+
+/**
+ * The UDP interface a MultiGroupHost hands to each of its Synchronizers.
+ *
+ * Outgoing packets are posted unchanged to the host’s outgoing queue, which is
+ * drained by the host’s I/O task. Packets to endpoints the group knows are
+ * marked with its group name hash, so that the I/O task routes the replies of
+ * those endpoints to this group. Incoming packets are taken from the group’s
+ * inbox, which the I/O task fills. Once the group forgets an endpoint it sent
+ * to or received from, its route is released (see release_unknown_endpoints).
+ */
+struct MultiplexedUdpInterface : public udp_interface::UDPInterface {
+ private:
+  uint32_t group_name_hash;
+  std::function<bool(const udp_interface::Endpoint)> is_endpoint_known;
+  lock_free_queue::MPSCQueue<AddressedPacket>& outgoing_packets;
+  lock_free_queue::SPSCQueue<AddressedPacket> inbox;
+  std::set<udp_interface::Endpoint> routed_endpoints;  // shard task only
+
+ public:
+  MultiplexedUdpInterface(
+      const uint32_t group_name_hash,
+      const std::function<bool(const udp_interface::Endpoint)>
+          is_endpoint_known,
+      lock_free_queue::MPSCQueue<AddressedPacket>& outgoing_packets,
+      const size_t inbox_capacity)
+      : group_name_hash(group_name_hash),
+        is_endpoint_known(is_endpoint_known),
+        outgoing_packets(outgoing_packets),
+        inbox(inbox_capacity) {}
+
+  /**
+   * Delivers a packet into this group’s inbox.
+   * Must only be called from the host’s I/O task. Returns false if the inbox
+   * is full, in which case the packet is dropped.
+   */
+  bool deliver(const udp_interface::Endpoint endpoint,
+               const std::string packet) {
+    return inbox.push(AddressedPacket(endpoint, packet));
+  }
+
+  /**
+   * Returns true if there are no packets waiting in the inbox.
+   */
+  bool is_inbox_empty() const { return inbox.is_empty(); }
+
+  /**
+   * Posts the given packet to the host’s outgoing queue. Must only be called
+   * from the task of the group’s shard.
+   */
+  bool send_packet(const udp_interface::Endpoint endpoint,
+                   const std::string packet) override {
+    tl::optional<uint32_t> member_group_name_hash;
+    if (is_endpoint_known(endpoint)) {
+      member_group_name_hash = group_name_hash;
+      routed_endpoints.insert(endpoint);
+    }
+
+    return outgoing_packets.push(
+        AddressedPacket(endpoint, packet, member_group_name_hash));
+  }
+
+  bool is_incoming_packet_available() override { return !inbox.is_empty(); }
+
+  tl::optional<udp_interface::IncomingMessage> receive_packet() override {
+    const auto packet = inbox.pop();
+
+    if (!packet.has_value()) {
+      return {};
+    }
+
+    routed_endpoints.insert(packet.value().endpoint);
+
+    return udp_interface::IncomingMessage(packet.value().endpoint,
+                                          packet.value().packet);
+  }
+
+  /**
+   * Tells the I/O task to stop routing packets to this group from the
+   * endpoints the group was in contact with, but no longer knows, e.g. since
+   * they were removed or timed out. Must only be called from the task of the
+   * group’s shard. Endpoints whose release does not fit into the outgoing
+   * queue are released on a later call.
+   */
+  void release_unknown_endpoints() {
+    auto it = routed_endpoints.begin();
+    while (it != routed_endpoints.end()) {
+      if (is_endpoint_known(*it) ||
+          !outgoing_packets.push(
+              AddressedPacket(*it, "", group_name_hash, true))) {
+        it++;
+        continue;
+      }
+
+      it = routed_endpoints.erase(it);
+    }
+  }
+};
+}  // namespace synchronizer
@@ -5,8 +5,9 @@
 
 /**
  * An implementation of the NetworkHandlerDelegate interface for use with the
- * Synchronizer. Forwards incoming messages to the synchronizer’s delegate and
- * handles incoming sync, dereg, and req_init_sync messages.
+ * Synchronizer. Forwards incoming messages to the synchronizer’s delegate,
+ * handles incoming sync, dereg, and req_init_sync messages, and removes peers
+ * that timed out.
  */
 struct NetworkHandlerDelegateImpl : public NetworkHandlerDelegate {
  private:
@@ -79,4 +80,8 @@ struct NetworkHandlerDelegateImpl : public NetworkHandlerDelegate {
       synchronizer_delegate->on_decode_failed(error, codec);
     }
   };
+
+  void on_endpoint_timed_out(udp_interface::Endpoint endpoint) const {
+    synchronizer->remove_endpoint(endpoint);
+  };
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "RateLimiter.h"
+
+namespace rate_limiter {
+/**
+ * Returns true if both the interval and the byte limit of the given state allow
+ * sending right now.
+ */
+bool RateLimiter::may_send(const State& state) const {
+  if (state.has_been_sent && state.limit.min_interval_in_deciseconds != 0) {
+    const uint32_t elapsed =
+        time_in_deciseconds - state.last_sent_time_in_deciseconds;
+    if (elapsed < state.limit.min_interval_in_deciseconds) {
+      return false;
+    }
+  }
+
+  if (state.limit.max_bytes_per_second != 0 && state.byte_allowance <= 0) {
+    return false;
+  }
+
+  return true;
+}
+
+void RateLimiter::mark_as_sent(State& state) {
+  state.has_been_sent = true;
+  state.last_sent_time_in_deciseconds = time_in_deciseconds;
+  state.is_pending = false;
+}
+
+/**
+ * Sets or replaces the rate limit of the synchronizable with the given name.
+ */
+void RateLimiter::set_rate_limit(const std::string synchronizable_name,
+                                 const RateLimit limit) {
+  auto it = states.find(synchronizable_name);
+  if (it == states.end()) {
+    states.insert(std::make_pair(synchronizable_name, State(limit)));
+    return;
+  }
+
+  it->second.limit = limit;
+  if (it->second.byte_allowance > (int64_t)limit.max_bytes_per_second) {
+    it->second.byte_allowance = limit.max_bytes_per_second;
+  }
+}
+
+void RateLimiter::remove_rate_limit(const std::string synchronizable_name) {
+  states.erase(synchronizable_name);
+}
+
+bool RateLimiter::is_rate_limited(
+    const std::string& synchronizable_name) const {
+  return states.count(synchronizable_name) != 0;
+}
+
+/**
+ * Returns true if the synchronizable with the given name may be sent now, and
+ * records the send. Otherwise, the synchronizable is marked as pending and will
+ * be returned by on_100_ms_passed once its limits allow it to be sent.
+ * Synchronizables without a rate limit may always be sent.
+ */
+bool RateLimiter::try_acquire(const std::string& synchronizable_name) {
+  auto it = states.find(synchronizable_name);
+  if (it == states.end()) {
+    return true;
+  }
+
+  auto& state = it->second;
+  if (state.is_pending || !may_send(state)) {
+    state.is_pending = true;
+    return false;
+  }
+
+  mark_as_sent(state);
+
+  return true;
+}
+
+/**
+ * Debits the byte allowance of the synchronizable with the given name.
+ */
+void RateLimiter::record_bytes_sent(const std::string& synchronizable_name,
+                                    const size_t byte_count) {
+  auto it = states.find(synchronizable_name);
+  if (it == states.end() || it->second.limit.max_bytes_per_second == 0) {
+    return;
+  }
+
+  it->second.byte_allowance -= (int64_t)byte_count;
+}
+
+/**
+ * To be called once every 100 ms. Refills byte allowances and returns the names
+ * of pending synchronizables that may be sent now. These are considered sent.
+ */
+std::vector<std::string> RateLimiter::on_100_ms_passed() {
+  time_in_deciseconds += 1;
+
+  std::vector<std::string> released;
+
+  for (auto& name_and_state : states) {
+    auto& state = name_and_state.second;
+    const int64_t max_bytes = state.limit.max_bytes_per_second;
+
+    if (max_bytes != 0) {
+      const int64_t refill = max_bytes / 10 > 0 ? max_bytes / 10 : 1;
+      state.byte_allowance += refill;
+      if (state.byte_allowance > max_bytes) {
+        state.byte_allowance = max_bytes;
+      }
+    }
+
+    if (state.is_pending && may_send(state)) {
+      mark_as_sent(state);
+      released.push_back(name_and_state.first);
+    }
+  }
+
+  return released;
+}
+}  // namespace rate_limiter
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rate_limiter {
+/**
+ * Limits on how often a synchronizable may be sent. A value of 0 lifts the
+ * respective limit.
+ */
+struct RateLimit {
+  unsigned int min_interval_in_deciseconds;
+  unsigned int max_bytes_per_second;
+
+  RateLimit(const unsigned int min_interval_in_deciseconds,
+            const unsigned int max_bytes_per_second = 0)
+      : min_interval_in_deciseconds(min_interval_in_deciseconds),
+        max_bytes_per_second(max_bytes_per_second) {}
+};
+
+/**
+ * Decides when rate-limited synchronizables may be sent. A synchronizable that
+ * is updated while it is being held back is marked as pending and released on
+ * a later tick, so that its last value always goes out.
+ *
+ * Byte limits are enforced with a token bucket that holds up to one second’s
+ * worth of bytes and is refilled every 100 ms. The bucket may go into debt, so
+ * a state larger than the allowance is still sent eventually.
+ */
+struct RateLimiter {
+ private:
+  struct State {
+    RateLimit limit;
+    bool has_been_sent = false;
+    uint32_t last_sent_time_in_deciseconds = 0;
+    int64_t byte_allowance;
+    bool is_pending = false;
+
+    State(const RateLimit limit)
+        : limit(limit), byte_allowance(limit.max_bytes_per_second) {}
+  };
+
+  std::map<std::string, State> states;
+  uint32_t time_in_deciseconds = 0;  // a decisecond is 100 ms
+
+  bool may_send(const State& state) const;
+  void mark_as_sent(State& state);
+
+ public:
+  void set_rate_limit(const std::string synchronizable_name,
+                      const RateLimit limit);
+  void remove_rate_limit(const std::string synchronizable_name);
+
+  bool is_rate_limited(const std::string& synchronizable_name) const;
+
+  bool try_acquire(const std::string& synchronizable_name);
+
+  void record_bytes_sent(const std::string& synchronizable_name,
+                         const size_t byte_count);
+
+  std::vector<std::string> on_100_ms_passed();
+};
+}  // namespace rate_limiter
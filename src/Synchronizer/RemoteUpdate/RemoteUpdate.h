@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+
+#include "DataObject/DataObject.h"
+#include "Synchronizable/Synchronizable.h"
+#include "interfaces/UDPInterface/UDPInterface.h"
+
+namespace synchronizer {
+/**
+ * Synchronization data received from an endpoint that is yet to be applied to
+ * the endpoint’s synchronizable.
+ */
+struct RemoteUpdate {
+  udp_interface::Endpoint endpoint;
+  std::shared_ptr<Synchronizable> synchronizable;
+  std::shared_ptr<data_object::GenericValue> data_object;
+
+  RemoteUpdate() = default;
+
+  RemoteUpdate(const udp_interface::Endpoint endpoint,
+               const std::shared_ptr<Synchronizable> synchronizable,
+               const std::shared_ptr<data_object::GenericValue> data_object)
+      : endpoint(endpoint),
+        synchronizable(synchronizable),
+        data_object(data_object) {}
+
+  /**
+   * Applies the data to the synchronizable.
+   */
+  bool apply() const {
+    return synchronizable->apply_from_data_object(data_object);
+  }
+};
+}  // namespace synchronizer
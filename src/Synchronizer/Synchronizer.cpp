@@ -2,34 +2,80 @@
 
 #include "ErriezCRC32/ErriezCRC32.h"
 #include "NetworkHandlerDelegateImpl/NetworkHandlerDelegateImpl.h"
+#include "Tracing/Tracing.h"
 #include "network_messages/DeregistrationMessage.h"
 #include "network_messages/RequestInitialSynchronizationMessage.h"
 #include "network_messages/SynchronizationMessage.h"
 
 namespace synchronizer {
-bool Synchronizer::is_message_related_to_synchronizable(
-    const std::shared_ptr<data_object::GenericValue> message_info,
-    const std::shared_ptr<Synchronizable> synchronizable) const {
-  if (!message_info->is_array()) {
-    return false;
+/**
+ * Sends the given synchronizable to the given endpoint through the endpoint’s
+ * slot for that synchronizable. If the slot’s previous state is still in
+ * flight, it is overwritten and goes out with the next transmission; the
+ * receiver only ever gets the latest state.
+ */
+void Synchronizer::send_synchronization(
+    const udp_interface::Endpoint endpoint,
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const MessagePriority priority) {
+  auto& slots = synchronization_slots[endpoint];
+  if (slots.empty()) {
+    capacity::reserve(slots, capacity::max_own_synchronizables);
   }
 
-  auto array_items = message_info->array_items().value();
-
-  if (array_items->size() < 3) {
-    return false;
+  auto& slot = slots[synchronizable->get_name()];
+  if (!slot) {
+    slot = std::make_shared<SynchronizationMessage>(
+        synchronizable, endpoint, shared_from_this(), priority);
   }
 
-  if (array_items->at(0)->string_value().value_or("") != "sync") {
-    return false;
+  const auto is_in_flight = slot->replace_contents(synchronizable, priority);
+  if (is_in_flight) {
+    return;
   }
 
-  if (array_items->at(2)->string_value().value_or("") !=
-      synchronizable->get_name()) {
-    return false;
+  network_handler.send_message(slot, endpoint, 100u);
+}
+
+void Synchronizer::send_to_all_endpoints(
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const MessagePriority priority) {
+  for_each_endpoint(
+      [synchronizable, priority, this](const udp_interface::Endpoint endpoint) {
+        send_synchronization(endpoint, synchronizable, priority);
+      });
+}
+
+/**
+ * Sends the latest state of each rate-limited synchronizable that was held back
+ * and whose limits allow it to be sent now.
+ */
+void Synchronizer::send_released_synchronizables() {
+  const auto released_names = rate_limiter.on_100_ms_passed();
+
+  for (const auto& name : released_names) {
+    for (const auto& own_synchronizable : own_synchronizables) {
+      if (own_synchronizable.synchronizable->get_name() == name) {
+        send_to_all_endpoints(own_synchronizable.synchronizable,
+                              own_synchronizable.priority);
+        break;
+      }
+    }
   }
+}
 
-  return true;
+/**
+ * Sends the synchronization messages again that the NetworkHandler had no
+ * room for when they were sent.
+ */
+void Synchronizer::send_deferred_synchronizations() {
+  for (auto& endpoint_slots : synchronization_slots) {
+    for (auto& slot : endpoint_slots.second) {
+      if (slot.second->resume_if_deferred()) {
+        network_handler.send_message(slot.second, endpoint_slots.first, 100u);
+      }
+    }
+  }
 }
 
 tl::optional<std::shared_ptr<Synchronizable>>
@@ -50,16 +96,29 @@ Synchronizer::get_synchronizable_instance_for_endpoint(
   return {};
 }
 
-void Synchronizer::add_or_update_own_synchronizable(
-    const std::shared_ptr<Synchronizable> synchronizable) {
+/**
+ * Remembers the given synchronizable as the latest state under its name.
+ * Returns false if it has a new name and the number of own synchronizables is
+ * limited and reached.
+ */
+bool Synchronizer::add_or_update_own_synchronizable(
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const MessagePriority priority) {
   for (size_t i = 0; i < own_synchronizables.size(); i += 1) {
-    if (own_synchronizables[i]->get_name() == synchronizable->get_name()) {
-      own_synchronizables[i] = synchronizable;
-      return;
+    if (own_synchronizables[i].synchronizable->get_name() ==
+        synchronizable->get_name()) {
+      own_synchronizables[i] = OwnSynchronizable(synchronizable, priority);
+      return true;
     }
   }
 
-  own_synchronizables.push_back(synchronizable);
+  if (capacity::is_full(own_synchronizables.size(),
+                        capacity::max_own_synchronizables)) {
+    return false;
+  }
+
+  own_synchronizables.push_back(OwnSynchronizable(synchronizable, priority));
+  return true;
 }
 
 std::shared_ptr<Synchronizer> Synchronizer::create(const char* hostname) {
@@ -74,28 +133,36 @@ void Synchronizer::init() {
       std::make_shared<NetworkHandlerDelegateImpl>(shared_from_this());
   network_handler.set_delegate(network_handler_delegate);
 
+  // in bounded mode, all containers whose size is limited get their storage
+  // now, so that they do not allocate while running
+  capacity::reserve(endpoint_to_synchronizables, capacity::max_peers);
+  capacity::reserve(endpoint_to_endpoint_info, capacity::max_peers);
+  capacity::reserve(synchronization_slots, capacity::max_peers);
+  capacity::reserve(own_synchronizables, capacity::max_own_synchronizables);
+  network_handler.reserve_capacity();
+
   mdns_handler.init();
 }
 
+/**
+ * Sends the given synchronizable to all known endpoints with the given
+ * priority, replacing any of its previous states that are still being sent.
+ * If the synchronizable has a rate limit that does not allow sending it right
+ * now, it is sent once the limit allows it. A synchronizable with a new name
+ * is ignored if the number of own synchronizables is limited and reached.
+ */
 void Synchronizer::synchronize(
-    const std::shared_ptr<Synchronizable> synchronizable) {
-  network_handler.cancel_active_messages(
-      [this,
-       synchronizable](std::shared_ptr<data_object::GenericValue> data_object) {
-        return is_message_related_to_synchronizable(data_object,
-                                                    synchronizable);
-      });
-
-  for_each_endpoint(
-      [synchronizable, this](const udp_interface::Endpoint endpoint) {
-        const std::shared_ptr<NetworkMessage> message =
-            std::make_shared<SynchronizationMessage>(synchronizable, endpoint,
-                                                     shared_from_this());
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const MessagePriority priority) {
+  if (!add_or_update_own_synchronizable(synchronizable, priority)) {
+    return;
+  }
 
-        network_handler.send_message(message, endpoint, 100u);
-      });
+  if (!rate_limiter.try_acquire(synchronizable->get_name())) {
+    return;
+  }
 
-  add_or_update_own_synchronizable(synchronizable);
+  send_to_all_endpoints(synchronizable, priority);
 }
 
 void Synchronizer::handle_synchronization_message(
@@ -117,25 +184,27 @@ void Synchronizer::handle_synchronization_message(
       get_synchronizable_for_endpoint(endpoint, synchronizable_name);
   if (synchronizable.has_value()) {
     const auto value = synchronizable.value();
+
+    if (remote_update_handler) {
+      remote_update_handler(endpoint, value, data_object);
+      return;
+    }
+
+    TRACE_SCOPE(APPLY);
     value->apply_from_data_object(data_object);
   }
 }
 
 void Synchronizer::perform_initial_synchronization(
     const udp_interface::Endpoint endpoint) {
-  for (const auto& synchronizable : own_synchronizables) {
-    network_handler.cancel_active_messages(
-        [this, synchronizable](
-            std::shared_ptr<data_object::GenericValue> data_object) {
-          return is_message_related_to_synchronizable(data_object,
-                                                      synchronizable);
-        });
-
-    const std::shared_ptr<NetworkMessage> message =
-        std::make_shared<SynchronizationMessage>(synchronizable, endpoint,
-                                                 shared_from_this());
-
-    network_handler.send_message(message, endpoint, 100u);
+  // without room for the endpoint, nothing may be stored for it
+  if (capacity::is_bounded && !is_endpoint_known(endpoint)) {
+    return;
+  }
+
+  for (const auto& own_synchronizable : own_synchronizables) {
+    send_synchronization(endpoint, own_synchronizable.synchronizable,
+                         own_synchronizable.priority);
   }
 }
 
@@ -178,27 +247,161 @@ void Synchronizer::set_mdns_interface(
   mdns_handler.set_mdns_interface(mdns_interface);
 }
 
+/**
+ * Sets a handler that receives incoming synchronization data in place of the
+ * Synchronizer applying it to the endpoint’s synchronizable. Pass an empty
+ * function to restore the default behavior.
+ */
+void Synchronizer::set_remote_update_handler(
+    const RemoteUpdateHandler new_handler) {
+  remote_update_handler = new_handler;
+}
+
 void Synchronizer::set_default_data_format(
     const DataFormat new_default_data_format) {
   network_handler.set_default_data_format(new_default_data_format);
 }
 
+/**
+ * Sets how outgoing messages are encoded, e.g. whether numbers are shrunk to
+ * integers or float32 where possible.
+ */
+void Synchronizer::set_codec_options(const CodecOptions new_codec_options) {
+  network_handler.set_codec_options(new_codec_options);
+}
+
+/**
+ * Sets the object keys, such as field names, that are sent as small integers
+ * instead of in full. Every endpoint of the group must set the same keys in
+ * the same order, e.g. at init.
+ */
+void Synchronizer::set_key_dictionary(const std::vector<std::string> keys) {
+  auto options = network_handler.get_codec_options();
+  options.key_dictionary = std::make_shared<KeyDictionary>(keys);
+
+  network_handler.set_codec_options(options);
+}
+
+/**
+ * Compresses outgoing packets that encode to at least the given number of
+ * bytes, such as large lookup tables. Pass 0 to disable compression.
+ */
+void Synchronizer::set_compression_threshold(const size_t new_threshold) {
+  network_handler.set_compression_threshold(new_threshold);
+}
+
+/**
+ * Appends a CRC32 to every outgoing packet and rejects incoming packets whose
+ * checksum is missing or does not match, before they are decoded. Every
+ * endpoint of the group must enable checksums, e.g. at init.
+ */
+void Synchronizer::set_checksums_enabled(const bool new_checksums_enabled) {
+  network_handler.set_checksums_enabled(new_checksums_enabled);
+}
+
+/**
+ * Sets the size above which packets are split into fragments that are
+ * acknowledged and retried individually, e.g. 1400 bytes, which fits in a
+ * single Wi-Fi frame. Defaults to 0, which never fragments, since peers
+ * running a release without fragmentation drop fragments. Every endpoint of
+ * the group must support fragmentation before it is enabled.
+ */
+void Synchronizer::set_max_packet_size(const size_t new_max_size) {
+  network_handler.set_max_packet_size(new_max_size);
+}
+
+/**
+ * Limits the memory used to reassemble fragmented synchronizables. Large
+ * synchronizables are only applied once they have arrived completely, so
+ * new_max_bytes must be at least as large as the largest one sent to this
+ * Synchronizer. Synchronizing such synchronizables with a low priority keeps
+ * their transfer from delaying the others.
+ */
+void Synchronizer::set_reassembly_limits(const size_t new_max_reassemblies,
+                                         const size_t new_max_bytes) {
+  network_handler.set_reassembly_limits(new_max_reassemblies, new_max_bytes);
+}
+
+/**
+ * Limits how many messages may be sent (or resent) per 100 ms. When the limit
+ * is reached, higher-priority synchronizables are sent first. Pass 0 to lift
+ * the limit.
+ */
+void Synchronizer::set_max_messages_per_decisecond(
+    const unsigned int new_max_messages) {
+  network_handler.set_max_messages_per_decisecond(new_max_messages);
+}
+
+/**
+ * Sets when keepalives are sent to idle peers, and how long a silent peer may
+ * go unheard before its synchronizations are paused and before it is removed.
+ * No keepalives are sent and silent peers are kept by default; only enable
+ * liveness monitoring if every peer runs a release that sends keepalives.
+ */
+void Synchronizer::set_liveness_options(
+    const liveness::LivenessOptions new_options) {
+  network_handler.set_liveness_options(new_options);
+}
+
+/**
+ * Limits how often the synchronizable with the given name is sent. Updates in
+ * between are coalesced, and the latest state is sent once the limit allows.
+ * Initial synchronizations of new endpoints are not limited.
+ */
+void Synchronizer::set_rate_limit(const std::string synchronizable_name,
+                                  const rate_limiter::RateLimit limit) {
+  rate_limiter.set_rate_limit(synchronizable_name, limit);
+}
+
+void Synchronizer::remove_rate_limit(const std::string synchronizable_name) {
+  rate_limiter.remove_rate_limit(synchronizable_name);
+}
+
+/**
+ * Called by synchronization messages whenever they are put on the wire.
+ */
+void Synchronizer::record_bytes_sent(const std::string& synchronizable_name,
+                                     const size_t byte_count) {
+  rate_limiter.record_bytes_sent(synchronizable_name, byte_count);
+}
+
 const NetworkHandler& Synchronizer::get_network_handler() const {
   return *(&network_handler);
 }
 
+/**
+ * Returns the packets and bytes exchanged with each known endpoint,
+ * retransmissions, dropped duplicates, rejected packets, ack latencies, and
+ * the depth of the send queue, e.g. to tune retry and scan parameters.
+ */
+const NetworkMetrics& Synchronizer::get_network_metrics() const {
+  return network_handler.get_metrics();
+}
+
+void Synchronizer::reset_network_metrics() { network_handler.reset_metrics(); }
+
 const mdns_handler::MDNSHandler& Synchronizer::get_mdns_handler() const {
   return *(&mdns_handler);
 }
 
+/**
+ * Adds the given endpoint as a peer. If the number of peers is limited and
+ * reached, the endpoint is ignored until another peer is removed.
+ */
 void Synchronizer::add_endpoint(const udp_interface::Endpoint endpoint) {
   if (endpoint_to_synchronizables.count(endpoint) != 0) {
     return;
   }
 
+  if (capacity::is_full(endpoint_to_synchronizables.size(),
+                        capacity::max_peers)) {
+    return;
+  }
+
   auto initial_container = delegate->create_initial_synchronizables_container();
   endpoint_to_synchronizables[endpoint] = initial_container;
   endpoint_to_endpoint_info[endpoint] = {};
+  network_handler.track_peer(endpoint);
 }
 
 bool Synchronizer::set_endpoint_info(const udp_interface::Endpoint endpoint,
@@ -223,6 +426,9 @@ Synchronizer::get_endpoint_info(const udp_interface::Endpoint endpoint) const {
 }
 
 void Synchronizer::remove_endpoint(const udp_interface::Endpoint endpoint) {
+  // nothing queued for the endpoint may be retransmitted once it is gone
+  network_handler.cancel_active_messages(endpoint);
+
   {
     auto it = endpoint_to_synchronizables.find(endpoint);
     if (it != endpoint_to_synchronizables.end()) {
@@ -237,6 +443,9 @@ void Synchronizer::remove_endpoint(const udp_interface::Endpoint endpoint) {
       endpoint_to_endpoint_info.erase(it);
     }
   }
+
+  synchronization_slots.erase(endpoint);
+  network_handler.untrack_peer(endpoint);
 }
 
 void Synchronizer::set_group_name(const std::string group_name) {
@@ -258,9 +467,12 @@ void Synchronizer::deregister_all_endpoints() {
     auto deregistration_message = std::make_shared<DeregistrationMessage>();
 
     network_handler.send_message(deregistration_message, endpoint, 100u);
+    network_handler.untrack_peer(endpoint);
   });
 
   endpoint_to_synchronizables.clear();
+  endpoint_to_endpoint_info.clear();
+  synchronization_slots.clear();
 }
 
 unsigned int Synchronizer::get_time_between_scans() const {
@@ -302,6 +514,10 @@ bool Synchronizer::is_scanning() const { return mdns_handler.is_scanning(); }
 
 void Synchronizer::on_100_ms_passed() {
   network_handler.on_100_ms_passed();
+  send_released_synchronizables();
+  if (capacity::is_bounded) {
+    send_deferred_synchronizations();
+  }
   mdns_handler.on_100_ms_passed();
 }
 
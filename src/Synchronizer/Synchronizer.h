@@ -5,44 +5,94 @@
 
 #include "./EndpointInfo/EndpointInfo.h"
 #include "./MDNSHandler/MDNSHandler.h"
+#include "./RateLimiter/RateLimiter.h"
+#include "Capacity/Capacity.h"
 #include "NetworkHandler/NetworkHandler.h"
 #include "Synchronizable/Synchronizable.h"
 #include "SynchronizerDelegate/SynchronizerDelegate.h"
 #include "interfaces/UDPInterface/UDPInterface.h"
 #include "optional/include/tl/optional.hpp"
 
+struct SynchronizationMessage;
+
 namespace synchronizer {
+/**
+ * A function that is handed synchronization data received from an endpoint
+ * instead of the Synchronizer applying it to the endpoint’s synchronizable.
+ */
+typedef std::function<void(
+    const udp_interface::Endpoint endpoint,
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const std::shared_ptr<data_object::GenericValue> data_object)>
+    RemoteUpdateHandler;
+
 struct Synchronizer : public std::enable_shared_from_this<Synchronizer> {
  private:
+  /**
+   * A synchronizable of this Synchronizer and the priority it was last
+   * synchronized with.
+   */
+  struct OwnSynchronizable {
+    std::shared_ptr<Synchronizable> synchronizable;
+    MessagePriority priority;
+
+    OwnSynchronizable(const std::shared_ptr<Synchronizable> synchronizable,
+                      const MessagePriority priority)
+        : synchronizable(synchronizable), priority(priority) {}
+  };
+
   std::shared_ptr<SynchronizerDelegate> delegate;
   NetworkHandler network_handler;
   mdns_handler::MDNSHandler mdns_handler;
-  std::map<udp_interface::Endpoint,
-           std::vector<std::shared_ptr<Synchronizable>>>
+  rate_limiter::RateLimiter rate_limiter;
+  capacity::Map<udp_interface::Endpoint,
+                std::vector<std::shared_ptr<Synchronizable>>>
       endpoint_to_synchronizables;
-  std::map<udp_interface::Endpoint, endpoint_info::EndpointInfo>
+  capacity::Map<udp_interface::Endpoint, endpoint_info::EndpointInfo>
       endpoint_to_endpoint_info;
-  std::deque<std::shared_ptr<Synchronizable>> own_synchronizables;
+  capacity::Queue<OwnSynchronizable> own_synchronizables;
   uint32_t group_name_hash;
+  RemoteUpdateHandler remote_update_handler;
+
+  /**
+   * One reusable SynchronizationMessage per endpoint and synchronizable name.
+   * Updating a synchronizable while its previous state is in flight overwrites
+   * the state in place instead of queueing another message.
+   */
+  capacity::Map<udp_interface::Endpoint,
+                capacity::Map<std::string,
+                              std::shared_ptr<SynchronizationMessage>>>
+      synchronization_slots;
+
+  void send_synchronization(
+      const udp_interface::Endpoint endpoint,
+      const std::shared_ptr<Synchronizable> synchronizable,
+      const MessagePriority priority);
+
+  void send_to_all_endpoints(
+      const std::shared_ptr<Synchronizable> synchronizable,
+      const MessagePriority priority);
 
-  bool is_message_related_to_synchronizable(
-      const std::shared_ptr<data_object::GenericValue> message_info,
-      const std::shared_ptr<Synchronizable> synchronizable) const;
+  void send_released_synchronizables();
+
+  void send_deferred_synchronizations();
 
   tl::optional<std::shared_ptr<Synchronizable>>
   get_synchronizable_instance_for_endpoint(
       const udp_interface::Endpoint endpoint,
       const std::string synchronizable_name) const;
 
-  void add_or_update_own_synchronizable(
-      const std::shared_ptr<Synchronizable> synchronizable);
+  bool add_or_update_own_synchronizable(
+      const std::shared_ptr<Synchronizable> synchronizable,
+      const MessagePriority priority);
 
  public:
   static std::shared_ptr<Synchronizer> create(const char* hostname);
 
   void init();
 
-  void synchronize(const std::shared_ptr<Synchronizable> synchronizable);
+  void synchronize(const std::shared_ptr<Synchronizable> synchronizable,
+                   const MessagePriority priority = MessagePriority::NORMAL);
 
   void handle_synchronization_message(
       const uint32_t group_name_hash, const udp_interface::Endpoint endpoint,
@@ -89,9 +139,37 @@ struct Synchronizer : public std::enable_shared_from_this<Synchronizer> {
   void set_mdns_interface(
       const std::shared_ptr<mdns_interface::MDNSInterface> mdns_interface);
 
+  void set_remote_update_handler(const RemoteUpdateHandler new_handler);
+
   void set_default_data_format(const DataFormat new_default_data_format);
 
+  void set_codec_options(const CodecOptions new_codec_options);
+
+  void set_key_dictionary(const std::vector<std::string> keys);
+
+  void set_compression_threshold(const size_t new_threshold);
+
+  void set_checksums_enabled(const bool new_checksums_enabled);
+
+  void set_max_packet_size(const size_t new_max_size);
+
+  void set_reassembly_limits(const size_t new_max_reassemblies,
+                             const size_t new_max_bytes);
+
+  void set_max_messages_per_decisecond(const unsigned int new_max_messages);
+
+  void set_liveness_options(const liveness::LivenessOptions new_options);
+
+  void set_rate_limit(const std::string synchronizable_name,
+                      const rate_limiter::RateLimit limit);
+  void remove_rate_limit(const std::string synchronizable_name);
+
+  void record_bytes_sent(const std::string& synchronizable_name,
+                         const size_t byte_count);
+
   const NetworkHandler& get_network_handler() const;
+  const NetworkMetrics& get_network_metrics() const;
+  void reset_network_metrics();
   const mdns_handler::MDNSHandler& get_mdns_handler() const;
 
   void add_endpoint(const udp_interface::Endpoint endpoint);
@@ -0,0 +1,200 @@
+#include "ThreadedSynchronizer.h"
+
+#ifdef SMALL_DATA_SYNC_HAS_TASKS
+
+#include "Synchronizable/SynchronizableSnapshot.h"
+
+namespace synchronizer {
+ThreadedSynchronizer::ThreadedSynchronizer(
+    const std::shared_ptr<Synchronizer> synchronizer,
+    const size_t queue_capacity)
+    : synchronizer(synchronizer),
+      outgoing_synchronizables(queue_capacity),
+      remote_updates(queue_capacity),
+      should_run(false) {}
+
+ThreadedSynchronizer::~ThreadedSynchronizer() { stop(); }
+
+/**
+ * Hands a remote update over to the application thread. Updates that do not
+ * fit into the queue are kept on the network thread and handed over later, so
+ * none are lost.
+ */
+void ThreadedSynchronizer::hand_over_remote_update(const RemoteUpdate update) {
+  if (!overflowing_remote_updates.empty() || !remote_updates.push(update)) {
+    overflowing_remote_updates.push_back(update);
+  }
+}
+
+/**
+ * Retries handing over remote updates that did not fit into the queue.
+ */
+void ThreadedSynchronizer::flush_overflowing_remote_updates() {
+  while (!overflowing_remote_updates.empty()) {
+    if (!remote_updates.push(overflowing_remote_updates.front())) {
+      return;
+    }
+
+    overflowing_remote_updates.pop_front();
+  }
+}
+
+/**
+ * Synchronizes every synchronizable that has been posted by the application
+ * threads since the last call.
+ */
+void ThreadedSynchronizer::synchronize_outgoing_synchronizables() {
+  while (true) {
+    const auto synchronizable = outgoing_synchronizables.pop();
+
+    if (!synchronizable.has_value()) {
+      return;
+    }
+
+    synchronizer->synchronize(synchronizable.value().first,
+                              synchronizable.value().second);
+  }
+}
+
+/**
+ * The network thread’s main loop.
+ */
+void ThreadedSynchronizer::run() {
+  const uint64_t tick_interval_in_microseconds = 100000;
+  auto next_tick =
+      os::get_time_in_microseconds() + tick_interval_in_microseconds;
+
+  while (should_run.load(std::memory_order_acquire)) {
+    synchronize_outgoing_synchronizables();
+
+    for (unsigned int i = 0; i < heartbeats_per_poll; i += 1) {
+      synchronizer->heartbeat();
+    }
+
+    const auto now = os::get_time_in_microseconds();
+    while (now >= next_tick) {
+      synchronizer->on_100_ms_passed();
+      next_tick += tick_interval_in_microseconds;
+    }
+
+    flush_overflowing_remote_updates();
+
+    os::sleep_for_microseconds(poll_interval_in_microseconds);
+  }
+}
+
+/**
+ * Starts the network thread. From now on, the Synchronizer must not be
+ * accessed directly anymore until `stop` returns.
+ */
+void ThreadedSynchronizer::start() {
+  if (is_running()) {
+    return;
+  }
+
+  synchronizer->set_remote_update_handler(
+      [this](const udp_interface::Endpoint endpoint,
+             const std::shared_ptr<Synchronizable> synchronizable,
+             const std::shared_ptr<data_object::GenericValue> data_object) {
+        hand_over_remote_update(
+            RemoteUpdate(endpoint, synchronizable, data_object));
+      });
+
+  should_run.store(true, std::memory_order_release);
+  if (!network_task.start([this]() { run(); }, network_task_config)) {
+    should_run.store(false, std::memory_order_release);
+    synchronizer->set_remote_update_handler(nullptr);
+  }
+}
+
+/**
+ * Stops the network thread and waits for it to finish. Remote updates that
+ * have not been applied yet can still be applied afterwards.
+ */
+void ThreadedSynchronizer::stop() {
+  if (!is_running()) {
+    return;
+  }
+
+  should_run.store(false, std::memory_order_release);
+  network_task.join();
+
+  synchronizer->set_remote_update_handler(nullptr);
+}
+
+/**
+ * Returns true if the network thread is running.
+ */
+bool ThreadedSynchronizer::is_running() const {
+  return network_task.is_started();
+}
+
+/**
+ * Takes a snapshot of the given synchronizable and posts it to the network
+ * thread, which synchronizes it with all known endpoints using the given
+ * priority. May be called from any thread. Returns false if the queue is full.
+ */
+bool ThreadedSynchronizer::synchronize(
+    const std::shared_ptr<Synchronizable> synchronizable,
+    const MessagePriority priority) {
+  return outgoing_synchronizables.push(std::make_pair(
+      std::static_pointer_cast<Synchronizable>(
+          SynchronizableSnapshot::of(*synchronizable)),
+      priority));
+}
+
+/**
+ * Applies all updates that have been received from other endpoints since the
+ * last call and returns their number. Must always be called from the same
+ * (application) thread.
+ */
+unsigned int ThreadedSynchronizer::apply_remote_updates() {
+  unsigned int count = 0;
+
+  while (true) {
+    const auto update_optional = remote_updates.pop();
+
+    if (!update_optional.has_value()) {
+      return count;
+    }
+
+    const auto& update = update_optional.value();
+    update.apply();
+    endpoint_to_synchronizables[update.endpoint]
+                               [update.synchronizable->get_name()] =
+                                   update.synchronizable;
+
+    count += 1;
+  }
+}
+
+/**
+ * Sets how long the network thread sleeps between polls. Must be called before
+ * `start`.
+ */
+void ThreadedSynchronizer::set_poll_interval_in_microseconds(
+    unsigned int new_poll_interval) {
+  poll_interval_in_microseconds = new_poll_interval;
+}
+
+/**
+ * Sets how many times the Synchronizer’s `heartbeat` is called per poll, i.e.
+ * how many incoming packets can be handled per poll. Must be called before
+ * `start`.
+ */
+void ThreadedSynchronizer::set_heartbeats_per_poll(
+    unsigned int new_heartbeats_per_poll) {
+  heartbeats_per_poll = new_heartbeats_per_poll;
+}
+
+/**
+ * Sets how the network task is created (name, stack size, priority and the
+ * core it is pinned to). Must be called before `start`.
+ */
+void ThreadedSynchronizer::set_network_task_config(
+    const os::TaskConfig &new_config) {
+  network_task_config = new_config;
+}
+}  // namespace synchronizer
+
+#endif
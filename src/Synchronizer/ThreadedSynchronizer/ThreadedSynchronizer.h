@@ -0,0 +1,119 @@
+#pragma once
+
+#include "OS/OS.h"
+
+#ifdef SMALL_DATA_SYNC_HAS_TASKS
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "LockFreeQueue/MPSCQueue.h"
+#include "LockFreeQueue/SPSCQueue.h"
+#include "Synchronizable/Synchronizable.h"
+#include "Synchronizer/RemoteUpdate/RemoteUpdate.h"
+#include "Synchronizer/Synchronizer.h"
+#include "interfaces/UDPInterface/UDPInterface.h"
+#include "optional/include/tl/optional.hpp"
+
+namespace synchronizer {
+/**
+ * Runs a Synchronizer on a dedicated network thread (a FreeRTOS task on the
+ * ESP32, a std::thread on Linux).
+ *
+ * Once started, the network thread owns the Synchronizer (and thereby its
+ * NetworkHandler): it is the only thread that calls `heartbeat`,
+ * `on_100_ms_passed` and `synchronize` on it. Application threads call
+ * `ThreadedSynchronizer::synchronize`, which snapshots the synchronizable and
+ * posts the snapshot into a lock-free MPSC queue.
+ *
+ * Updates received from other endpoints are not applied on the network thread.
+ * They are handed back through a lock-free SPSC queue and applied once the
+ * application thread calls `apply_remote_updates`.
+ *
+ * On the ESP32, the network task is pinned to the PRO core by default, next to
+ * the Wi-Fi stack, so that application logic on the APP core is not stalled
+ * while synchronization traffic is processed.
+ *
+ * The Synchronizer must be fully configured and initialized before `start` is
+ * called. Its delegate’s callbacks are invoked on the network thread.
+ */
+struct ThreadedSynchronizer {
+ private:
+  std::shared_ptr<Synchronizer> synchronizer;
+  lock_free_queue::MPSCQueue<
+      std::pair<std::shared_ptr<Synchronizable>, MessagePriority>>
+      outgoing_synchronizables;
+  lock_free_queue::SPSCQueue<RemoteUpdate> remote_updates;
+  std::deque<RemoteUpdate> overflowing_remote_updates;  // network thread only
+  std::map<udp_interface::Endpoint,
+           std::map<std::string, std::shared_ptr<Synchronizable>>>
+      endpoint_to_synchronizables;  // application thread only
+  os::Task network_task;
+  os::TaskConfig network_task_config =
+      os::TaskConfig("sds_network", 8192, 5, os::PRO_CORE);
+  std::atomic<bool> should_run;
+  uint32_t poll_interval_in_microseconds = 1000;
+  unsigned int heartbeats_per_poll = 16;
+
+  void hand_over_remote_update(const RemoteUpdate update);
+
+  void flush_overflowing_remote_updates();
+
+  void synchronize_outgoing_synchronizables();
+
+  void run();
+
+ public:
+  ThreadedSynchronizer(const std::shared_ptr<Synchronizer> synchronizer,
+                       const size_t queue_capacity = 256);
+
+  ThreadedSynchronizer(const ThreadedSynchronizer&) = delete;
+  ThreadedSynchronizer& operator=(const ThreadedSynchronizer&) = delete;
+
+  ~ThreadedSynchronizer();
+
+  void start();
+  void stop();
+
+  bool is_running() const;
+
+  bool synchronize(const std::shared_ptr<Synchronizable> synchronizable,
+                   const MessagePriority priority = MessagePriority::NORMAL);
+
+  unsigned int apply_remote_updates();
+
+  template <typename T = Synchronizable>
+  tl::optional<std::shared_ptr<T>> get_synchronizable_for_endpoint(
+      const udp_interface::Endpoint endpoint,
+      const std::string synchronizable_name) const {
+    const auto endpoint_it = endpoint_to_synchronizables.find(endpoint);
+    if (endpoint_it == endpoint_to_synchronizables.end()) {
+      return {};
+    }
+
+    const auto it = endpoint_it->second.find(synchronizable_name);
+    if (it == endpoint_it->second.end()) {
+      return {};
+    }
+
+#ifdef ALLOW_DYNAMIC_CAST
+    const auto cast_value = std::dynamic_pointer_cast<T>(it->second);
+    if (cast_value) {
+      return cast_value;
+    }
+#endif
+    return std::static_pointer_cast<T>(it->second);
+  }
+
+  void set_poll_interval_in_microseconds(unsigned int new_poll_interval);
+
+  void set_heartbeats_per_poll(unsigned int new_heartbeats_per_poll);
+
+  void set_network_task_config(const os::TaskConfig &new_config);
+};
+}  // namespace synchronizer
+
+#endif
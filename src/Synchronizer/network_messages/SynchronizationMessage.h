@@ -8,6 +8,10 @@
 /**
  * A message containing synchronization data to be sent to another endpoint.
  * Used to synchronize a Synchronizable object.
+ *
+ * The Synchronizer keeps one SynchronizationMessage per endpoint and
+ * synchronizable name and replaces its contents in place while it is in
+ * flight, so that only the latest state of a synchronizable is ever sent.
  */
 struct SynchronizationMessage : public NetworkMessage {
  private:
@@ -26,18 +30,46 @@ struct SynchronizationMessage : public NetworkMessage {
    */
   std::shared_ptr<synchronizer::Synchronizer> synchronizer;
 
+  /**
+   * The priority class this message is sent with.
+   */
+  MessagePriority priority;
+
+  /**
+   * Whether this message is currently queued in the NetworkHandler.
+   */
+  mutable bool in_flight = false;
+
+  /**
+   * Whether the contents were replaced since the message was last sent.
+   */
+  mutable bool has_pending_update = false;
+
+  /**
+   * Whether the NetworkHandler had no room for this message, so that it needs
+   * to be sent again later.
+   */
+  mutable bool is_deferred = false;
+
+  void finish() const {
+    in_flight = false;
+    has_pending_update = false;
+  }
+
  public:
   SynchronizationMessage(
       std::shared_ptr<Synchronizable> synchronizable,
       udp_interface::Endpoint endpoint,
-      std::shared_ptr<synchronizer::Synchronizer> synchronizer)
+      std::shared_ptr<synchronizer::Synchronizer> synchronizer,
+      MessagePriority priority = MessagePriority::NORMAL)
       : synchronizable(synchronizable),
         endpoint(endpoint),
-        synchronizer(synchronizer) {}
+        synchronizer(synchronizer),
+        priority(priority) {}
 
   std::shared_ptr<data_object::GenericValue> to_data_object() const override {
     return data_object::create_array({
-        data_object::create_number_value(synchronizer->get_group_name_hash()),
+        data_object::create_int_value(synchronizer->get_group_name_hash()),
         data_object::create_string_value(synchronizable->get_name()),
         synchronizable->to_data_object(),
     });
@@ -45,18 +77,75 @@ struct SynchronizationMessage : public NetworkMessage {
 
   MessageType get_message_type() const override { return MessageType::SYNC; }
 
-  void on_send_succeeded() const override {}
+  MessagePriority get_priority() const override { return priority; }
+
+  /**
+   * Replaces the synchronizable state carried by this message. Returns true if
+   * the message is still in flight, in which case the new state goes out with
+   * its next transmission. Otherwise, the message is considered in flight from
+   * now on and the caller needs to send it.
+   */
+  bool replace_contents(std::shared_ptr<Synchronizable> new_synchronizable,
+                        MessagePriority new_priority) {
+    synchronizable = new_synchronizable;
+    priority = new_priority;
+
+    if (in_flight) {
+      has_pending_update = true;
+      return true;
+    }
+
+    in_flight = true;
+    return false;
+  }
+
+  bool take_pending_update() override {
+    const auto result = has_pending_update;
+    has_pending_update = false;
+
+    return result;
+  }
+
+  void on_emitted(const size_t packet_size) const override {
+    synchronizer->record_bytes_sent(synchronizable->get_name(), packet_size);
+  }
+
+  void on_send_succeeded() const override { finish(); }
 
   void on_send_failed() const override {
+    finish();
     synchronizer->remove_endpoint(endpoint);
   }
 
-  void on_cancelled() const override {}
+  void on_cancelled() const override { finish(); }
+
+  void on_rejected() const override {
+    finish();
+    is_deferred = true;
+  }
+
+  /**
+   * Returns true if the message was rejected by the NetworkHandler and has not
+   * been sent since. The message is then considered in flight again and the
+   * caller needs to send it.
+   */
+  bool resume_if_deferred() {
+    if (!is_deferred) {
+      return false;
+    }
+
+    is_deferred = false;
+    if (in_flight) {
+      return false;
+    }
+
+    in_flight = true;
+    return true;
+  }
 
   /**
    * Returns the message’s type, destination endpoint, and synchronizable object
-   * name. Used by the Synchronizer to cancel outgoing synchronization messages
-   * if a synchronizable is updated before its previous state is sent.
+   * name.
    */
   std::shared_ptr<data_object::GenericValue> get_info() const override {
     return data_object::create_array({
@@ -0,0 +1,169 @@
+#include "Tracing.h"
+
+#ifdef SMALL_DATA_SYNC_TRACING
+#include <atomic>
+#include <chrono>
+
+#include "OS/OS.h"
+
+namespace tracing {
+namespace {
+uint64_t get_default_time_in_nanoseconds() {
+#if defined(SMALL_DATA_SYNC_FREERTOS) || defined(ARDUINO_ARCH_ESP8266)
+  return os::get_time_in_microseconds() * 1000;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/**
+ * Returns the index of the StageHistogram bucket the given duration falls
+ * into.
+ */
+size_t get_bucket_index(const uint64_t duration_in_nanoseconds) {
+  size_t bucket_index = 0;
+  while (bucket_index < StageHistogram::bucket_count - 1 &&
+         duration_in_nanoseconds >
+             StageHistogram::get_upper_bound(bucket_index)) {
+    bucket_index += 1;
+  }
+
+  return bucket_index;
+}
+
+/**
+ * A StageHistogram that any number of threads may record into at once. Each
+ * counter is updated atomically on its own, without ordering, so reading it
+ * while recording goes on may see a duration in the count but not yet in the
+ * buckets.
+ */
+struct SharedStageHistogram {
+  std::atomic<uint32_t> buckets[StageHistogram::bucket_count];
+  std::atomic<uint32_t> count;
+  std::atomic<uint64_t> total_nanoseconds;
+  std::atomic<uint64_t> max_nanoseconds;
+
+  SharedStageHistogram() { clear(); }
+
+  void record(const uint64_t duration_in_nanoseconds) {
+    buckets[get_bucket_index(duration_in_nanoseconds)].fetch_add(
+        1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total_nanoseconds.fetch_add(duration_in_nanoseconds,
+                                std::memory_order_relaxed);
+
+    auto max = max_nanoseconds.load(std::memory_order_relaxed);
+    while (duration_in_nanoseconds > max &&
+           !max_nanoseconds.compare_exchange_weak(max, duration_in_nanoseconds,
+                                                  std::memory_order_relaxed)) {
+    }
+  }
+
+  StageHistogram load() const {
+    StageHistogram histogram;
+    for (size_t i = 0; i < StageHistogram::bucket_count; i += 1) {
+      histogram.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    histogram.count = count.load(std::memory_order_relaxed);
+    histogram.total_nanoseconds =
+        total_nanoseconds.load(std::memory_order_relaxed);
+    histogram.max_nanoseconds = max_nanoseconds.load(std::memory_order_relaxed);
+
+    return histogram;
+  }
+
+  void clear() {
+    for (auto& bucket : buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    total_nanoseconds.store(0, std::memory_order_relaxed);
+    max_nanoseconds.store(0, std::memory_order_relaxed);
+  }
+};
+
+std::atomic<Clock> current_clock(&get_default_time_in_nanoseconds);
+SharedStageHistogram histograms[stage_count];
+}  // namespace
+
+const char* get_stage_name(const Stage stage) {
+  switch (stage) {
+    case Stage::TO_DATA_OBJECT:
+      return "to_data_object";
+    case Stage::ENCODE:
+      return "encode";
+    case Stage::SEND_PACKET:
+      return "send_packet";
+    case Stage::RECEIVE:
+      return "receive";
+    case Stage::DECODE:
+      return "decode";
+    case Stage::DEDUP:
+      return "dedup";
+    case Stage::APPLY:
+      return "apply";
+  }
+
+  return "";
+}
+
+/**
+ * Replaces the clock used to time stages, e.g. with a cycle counter. Passing
+ * nullptr restores the default clock: the steady clock on Linux, and the
+ * microsecond timer of the ESP32 and ESP8266.
+ */
+void set_clock(const Clock new_clock) {
+  current_clock.store(new_clock ? new_clock : &get_default_time_in_nanoseconds,
+                      std::memory_order_relaxed);
+}
+
+uint64_t now() { return current_clock.load(std::memory_order_relaxed)(); }
+
+/**
+ * Adds the given duration to the bucket it falls into.
+ */
+void StageHistogram::record(const uint64_t duration_in_nanoseconds) {
+  buckets[get_bucket_index(duration_in_nanoseconds)] += 1;
+  count += 1;
+  total_nanoseconds += duration_in_nanoseconds;
+  if (duration_in_nanoseconds > max_nanoseconds) {
+    max_nanoseconds = duration_in_nanoseconds;
+  }
+}
+
+/**
+ * Returns the longest duration in nanoseconds counted by the given bucket:
+ * 256 ns for the first, doubling up to about 67 ms, and UINT64_MAX for the
+ * last.
+ */
+uint64_t StageHistogram::get_upper_bound(const size_t bucket_index) {
+  if (bucket_index >= bucket_count - 1) {
+    return UINT64_MAX;
+  }
+
+  return (uint64_t)256 << bucket_index;
+}
+
+void record(const Stage stage, const uint64_t duration_in_nanoseconds) {
+  histograms[(size_t)stage].record(duration_in_nanoseconds);
+}
+
+/**
+ * Returns a copy of the histogram of the given stage.
+ */
+StageHistogram get_histogram(const Stage stage) {
+  return histograms[(size_t)stage].load();
+}
+
+/**
+ * Clears the histograms of all stages.
+ */
+void reset() {
+  for (auto& histogram : histograms) {
+    histogram.clear();
+  }
+}
+}  // namespace tracing
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Optional timing of the stages a synchronization passes through, from
+ * serializing a synchronizable to applying it on the receiving side. Tracing
+ * is compiled in only if SMALL_DATA_SYNC_TRACING is defined; otherwise the
+ * TRACE_* macros expand to the traced code alone and none of this exists.
+ *
+ * Durations are aggregated per stage into fixed-bucket histograms, so
+ * recording never allocates. The histograms are shared by all synchronizers
+ * of the process, and their counters are atomic, so NetworkHandlers running
+ * on several threads may record at the same time.
+ */
+#ifdef SMALL_DATA_SYNC_TRACING
+namespace tracing {
+enum class Stage : uint8_t {
+  TO_DATA_OBJECT,
+  ENCODE,
+  SEND_PACKET,
+  RECEIVE,
+  DECODE,
+  DEDUP,
+  APPLY,
+};
+
+const size_t stage_count = 7;
+
+const char* get_stage_name(const Stage stage);
+
+/**
+ * Returns the current time in nanoseconds. Only differences matter.
+ */
+typedef uint64_t (*Clock)();
+
+void set_clock(const Clock new_clock);
+
+uint64_t now();
+
+/**
+ * Counts the durations of a stage. Bucket i holds durations up to
+ * get_upper_bound(i); the bounds double from 256 ns on, and the last bucket
+ * holds everything above.
+ */
+struct StageHistogram {
+  static const size_t bucket_count = 20;
+
+  uint32_t buckets[bucket_count] = {};
+  uint32_t count = 0;
+  uint64_t total_nanoseconds = 0;
+  uint64_t max_nanoseconds = 0;
+
+  void record(const uint64_t duration_in_nanoseconds);
+
+  static uint64_t get_upper_bound(const size_t bucket_index);
+};
+
+void record(const Stage stage, const uint64_t duration_in_nanoseconds);
+
+StageHistogram get_histogram(const Stage stage);
+
+void reset();
+
+/**
+ * Records the time from its construction to its destruction.
+ */
+struct Span {
+ private:
+  const Stage stage;
+  const uint64_t start_time;
+
+ public:
+  explicit Span(const Stage stage) : stage(stage), start_time(now()) {}
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  ~Span() { record(stage, now() - start_time); }
+};
+
+/**
+ * Evaluates the given function and records how long it took.
+ */
+template <typename Function>
+auto trace(const Stage stage, const Function& function)
+    -> decltype(function()) {
+  const Span span(stage);
+  return function();
+}
+}  // namespace tracing
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/**
+ * Times the rest of the enclosing scope as the given stage.
+ */
+#define TRACE_SCOPE(stage)                              \
+  const tracing::Span TRACE_CONCAT(trace_span_, __LINE__)( \
+      tracing::Stage::stage)
+
+/**
+ * Times the given expression as the given stage and yields its value.
+ */
+#define TRACE_CALL(stage, expression) \
+  tracing::trace(tracing::Stage::stage, [&]() { return expression; })
+
+/**
+ * Takes the time under the given name, for a later TRACE_SINCE, e.g. to only
+ * record a stage on some paths.
+ */
+#define TRACE_MARK(name) const uint64_t name = tracing::now()
+
+/**
+ * Records the time since the given TRACE_MARK as the given stage.
+ */
+#define TRACE_SINCE(stage, name) \
+  tracing::record(tracing::Stage::stage, tracing::now() - name)
+#else
+#define TRACE_SCOPE(stage)
+#define TRACE_CALL(stage, expression) (expression)
+#define TRACE_MARK(name)
+#define TRACE_SINCE(stage, name)
+#endif
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <array>
 #include <tuple>
@@ -32,6 +33,89 @@ struct NullStruct {
     bool operator<(NullStruct) const { return false; }
 };
 
+/* * * * * * * * * * * * * * * * * * * *
+ * Contiguous-buffer backends
+ *
+ * SizeCounter measures an encoding so that BufferWriter can write it into a
+ * pre-sized buffer with plain pointer bumps. BufferReader parses from a span
+ * and checks every read against its end. All three mirror the subset of the
+ * iostream interface used by the serializer and the parser, so the stream
+ * API keeps working unchanged.
+ */
+
+namespace {
+struct SizeCounter {
+    size_t size = 0;
+
+    void put(char) { size += 1; }
+    void write(const char*, size_t count) { size += count; }
+};
+
+struct BufferWriter {
+    char* position;
+
+    explicit BufferWriter(char* buffer) : position(buffer) {}
+
+    void put(char c) { *position++ = c; }
+    void write(const char* data, size_t count) {
+        std::memcpy(position, data, count);
+        position += count;
+    }
+};
+
+struct BufferReader {
+    const char* const begin;
+    const char* position;
+    const char* const end;
+    std::ios_base::iostate state = std::ios_base::goodbit;
+
+    BufferReader(const char* data, size_t size)
+        : begin(data), position(data), end(data + size) {}
+
+    size_t remaining() const { return static_cast<size_t>(end - position); }
+    size_t offset() const { return static_cast<size_t>(position - begin); }
+
+    bool fail() const { return (state & std::ios_base::failbit) != 0; }
+    bool eof() const { return (state & std::ios_base::eofbit) != 0; }
+    void setstate(std::ios_base::iostate new_state) { state |= new_state; }
+
+    int get() {
+        if (position == end) {
+            setstate(std::ios_base::eofbit | std::ios_base::failbit);
+            return -1;
+        }
+        return static_cast<uint8_t>(*position++);
+    }
+
+    void read(char* destination, size_t count) {
+        if (remaining() < count) {
+            count = remaining();
+            setstate(std::ios_base::eofbit | std::ios_base::failbit);
+        }
+        std::memcpy(destination, position, count);
+        position += count;
+    }
+};
+
+/* ensure_available(is, count)
+ *
+ * Fails the parse before allocating storage for a length prefix that the
+ * remaining input cannot satisfy. Streams do not know their remaining size
+ * and are left to fail on the read itself.
+ */
+inline bool ensure_available(std::istream&, size_t) {
+    return true;
+}
+
+inline bool ensure_available(BufferReader& is, size_t count) {
+    if (is.remaining() < count) {
+        is.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+        return false;
+    }
+    return true;
+}
+}
+
 /* * * * * * * * * * * * * * * * * * * *
  * MasPackValue
  */
@@ -41,6 +125,8 @@ public:
     virtual bool equals(const MsgPackValue * other) const = 0;
     virtual bool less(const MsgPackValue * other) const = 0;
     virtual void dump(std::ostream& os) const = 0;
+    virtual void dump(SizeCounter& os) const = 0;
+    virtual void dump(BufferWriter& os) const = 0;
     virtual MsgPack::Type type() const = 0;
     virtual double number_value() const;
     virtual float float32_value() const;
@@ -63,6 +149,11 @@ public:
     virtual const MsgPack &operator[](const std::string &key) const;
     virtual const MsgPack::extension &extension_items() const;
     virtual ~MsgPackValue() {}
+
+    template< typename Output >
+    static void dump_element(const MsgPack& element, Output& os) {
+        element.m_ptr->dump(os);
+    }
 };
 
 /* * * * * * * * * * * * * * * * * * * *
@@ -76,8 +167,8 @@ static const union {
 } endian_check_data { 0x0001 };
 static const bool is_big_endian = endian_check_data.bytes[0] == 0x00;
 
-template< typename T >
-void dump_data(const T value, std::ostream& os)
+template< typename T, typename Output >
+void dump_data(const T value, Output& os)
 {
     union {
         T packed;
@@ -96,21 +187,25 @@ void dump_data(const T value, std::ostream& os)
     }
 }
 
-inline void dump(NullStruct, std::ostream& os) {
+template< typename Output >
+inline void dump(NullStruct, Output& os) {
     os.put(0xc0);
 }
 
-inline void dump(float value, std::ostream& os) {
+template< typename Output >
+inline void dump(float value, Output& os) {
     os.put(0xca);
     dump_data(value, os);
 }
 
-inline void dump(double value, std::ostream& os) {
+template< typename Output >
+inline void dump(double value, Output& os) {
     os.put(0xcb);
     dump_data(value, os);
 }
 
-inline void dump(uint8_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(uint8_t value, Output& os) {
     if(128 <= value)
     {
         os.put(0xcc);
@@ -118,7 +213,8 @@ inline void dump(uint8_t value, std::ostream& os) {
     os.put(value);
 }
 
-inline void dump(uint16_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(uint16_t value, Output& os) {
     if( value < (1 << 8) )
     {
         dump(static_cast<uint8_t>(value), os );
@@ -130,7 +226,8 @@ inline void dump(uint16_t value, std::ostream& os) {
     }
 }
 
-inline void dump(uint32_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(uint32_t value, Output& os) {
     if( value < (1 << 16) )
     {
         dump(static_cast<uint16_t>(value), os );
@@ -142,7 +239,8 @@ inline void dump(uint32_t value, std::ostream& os) {
     }
 }
 
-inline void dump(uint64_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(uint64_t value, Output& os) {
     if( value < (1ULL << 32) )
     {
         dump(static_cast<uint32_t>(value), os );
@@ -154,7 +252,8 @@ inline void dump(uint64_t value, std::ostream& os) {
     }
 }
 
-inline void dump(int8_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(int8_t value, Output& os) {
     if( value < -32 )
     {
         os.put(0xd0);
@@ -162,7 +261,8 @@ inline void dump(int8_t value, std::ostream& os) {
     os.put(value);
 }
 
-inline void dump(int16_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(int16_t value, Output& os) {
     if( value < -(1 << 7) )
     {
         os.put(0xd1);
@@ -178,7 +278,8 @@ inline void dump(int16_t value, std::ostream& os) {
     }
 }
 
-inline void dump(int32_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(int32_t value, Output& os) {
     if( value < -(1 << 15) )
     {
         os.put(0xd2);
@@ -194,7 +295,8 @@ inline void dump(int32_t value, std::ostream& os) {
     }
 }
 
-inline void dump(int64_t value, std::ostream& os) {
+template< typename Output >
+inline void dump(int64_t value, Output& os) {
     if( value < -(1LL << 31) )
     {
         os.put(0xd3);
@@ -210,12 +312,14 @@ inline void dump(int64_t value, std::ostream& os) {
     }
 }
 
-inline void dump(bool value, std::ostream& os) {
+template< typename Output >
+inline void dump(bool value, Output& os) {
     const uint8_t msgpack_value = (value) ? 0xc3 : 0xc2;
     os.put(msgpack_value);
 }
 
-inline void dump(const std::string& value, std::ostream& os) {
+template< typename Output >
+inline void dump(const std::string& value, Output& os) {
     size_t const len = value.size();
     if(len <= 0x1f)
     {
@@ -242,12 +346,11 @@ inline void dump(const std::string& value, std::ostream& os) {
         throw std::runtime_error("exceeded maximum data length");
     }
 
-    std::for_each(std::begin(value), std::end(value), [&os](char v){
-        dump_data(v, os);
-    });
+    os.write(value.data(), len);
 }
 
-inline void dump(const MsgPack::array& value, std::ostream& os) {
+template< typename Output >
+inline void dump(const MsgPack::array& value, Output& os) {
     size_t const len = value.size();
     if(len <= 15)
     {
@@ -270,11 +373,12 @@ inline void dump(const MsgPack::array& value, std::ostream& os) {
     }
 
     std::for_each(std::begin(value), std::end(value), [&os](MsgPack::array::value_type const& v){
-        os << v;
+        MsgPackValue::dump_element(v, os);
     });
 }
 
-inline void dump(const MsgPack::object& value, std::ostream& os) {
+template< typename Output >
+inline void dump(const MsgPack::object& value, Output& os) {
     size_t const len = value.size();
     if(len <= 15)
     {
@@ -297,12 +401,13 @@ inline void dump(const MsgPack::object& value, std::ostream& os) {
     }
 
     std::for_each(std::begin(value), std::end(value), [&os](MsgPack::object::value_type const& v){
-        os << v.first;
-        os << v.second;
+        MsgPackValue::dump_element(v.first, os);
+        MsgPackValue::dump_element(v.second, os);
     });
 }
 
-inline void dump(const MsgPack::binary& value, std::ostream& os) {
+template< typename Output >
+inline void dump(const MsgPack::binary& value, Output& os) {
     size_t const len = value.size();
     if(len <= 0xff)
     {
@@ -326,7 +431,8 @@ inline void dump(const MsgPack::binary& value, std::ostream& os) {
     os.write(reinterpret_cast<const char*>(value.data()), value.size());
 }
 
-inline void dump(const MsgPack::extension& value, std::ostream& os) {
+template< typename Output >
+inline void dump(const MsgPack::extension& value, Output& os) {
     const uint8_t type = std::get<0>( value );
     const MsgPack::binary& data = std::get<1>( value );
     const size_t len = data.size();
@@ -372,6 +478,21 @@ std::ostream& operator<<(std::ostream& os, const MsgPack& msgpack) {
     return os;
 }
 
+void MsgPack::dump(std::string &out) const {
+    SizeCounter counter;
+    m_ptr->dump(counter);
+
+    out.resize(counter.size);
+    BufferWriter writer(&out[0]);
+    m_ptr->dump(writer);
+}
+
+std::string MsgPack::dump() const {
+    std::string out;
+    dump(out);
+    return out;
+}
+
 
 
 /* * * * * * * * * * * * * * * * * * * *
@@ -404,6 +525,8 @@ protected:
 
     const T m_value;
     void dump(std::ostream& os) const override { msgpack11::dump(m_value, os); }
+    void dump(SizeCounter& os) const override { msgpack11::dump(m_value, os); }
+    void dump(BufferWriter& os) const override { msgpack11::dump(m_value, os); }
 };
 
 bool equal_uint64_int64( uint64_t uint64_value, int64_t int64_value )
@@ -793,11 +916,10 @@ namespace {
  *
  * Object that tracks all state of an in-progress parse.
  */
-namespace MsgPackParser {
-    MsgPack parse_msgpack(std::istream& is, int depth);
-    
+template< typename Input >
+struct MsgPackParser {
     template< typename T >
-    void read_bytes(std::istream& is, T& bytes)
+    static void read_bytes(Input& is, T& bytes)
     {
         static_assert(std::is_fundamental<T>::value,
             "byte read not guaranteed for non-primitive types");
@@ -825,46 +947,53 @@ namespace MsgPackParser {
      *
      * Mark this parse as m_failed.
      */
-    MsgPack fail(std::istream& is) {
+    static MsgPack fail(Input& is) {
         is.setstate(std::ios::failbit);
         return MsgPack();
     }
 
-    MsgPack parse_invalid(std::istream& is, uint8_t, int) {
+    static MsgPack parse_invalid(Input& is, uint8_t, int) {
         return fail(is);
     }
 
-    MsgPack parse_nil(std::istream&, uint8_t, int) {
+    static MsgPack parse_nil(Input&, uint8_t, int) {
         return MsgPack();
     }
 
-    MsgPack parse_bool(std::istream&, uint8_t first_byte, int) {
+    static MsgPack parse_bool(Input&, uint8_t first_byte, int) {
         return MsgPack(first_byte == 0xc3);
     }
 
     template< typename T >
-    MsgPack parse_arith(std::istream& is, uint8_t, int) {
+    static MsgPack parse_arith(Input& is, uint8_t, int) {
         T tmp;
         read_bytes(is, tmp);
         return MsgPack(tmp);
     }
 
-    inline  std::string parse_string_impl(std::istream& is, uint32_t bytes) {
+    static std::string parse_string_impl(Input& is, uint32_t bytes) {
         std::string ret;
+        if (!ensure_available(is, bytes)) {
+            return ret;
+        }
         ret.resize(bytes);
         is.read(&ret[0], bytes);
         return ret;
     }
 
     template< typename T >
-    MsgPack parse_string(std::istream& is, uint8_t, int) {
+    static MsgPack parse_string(Input& is, uint8_t, int) {
         T bytes;
         read_bytes(is, bytes);
         return MsgPack(parse_string_impl(is, static_cast<uint32_t>(bytes)));
     }
 
-    MsgPack::array parse_array_impl(std::istream& is, uint32_t bytes, int depth) {
+    static MsgPack::array parse_array_impl(Input& is, uint32_t bytes, int depth) {
         MsgPack::array res;
+        // Every element takes at least one byte.
+        if (!ensure_available(is, bytes)) {
+            return res;
+        }
         res.reserve(bytes);
 
         for(uint32_t i = 0; i < bytes; ++i) {
@@ -874,14 +1003,17 @@ namespace MsgPackParser {
     }
 
     template< typename T >
-    MsgPack parse_array(std::istream& is, uint8_t, int depth) {
+    static MsgPack parse_array(Input& is, uint8_t, int depth) {
         T bytes;
         read_bytes(is, bytes);
         return MsgPack(parse_array_impl(is, static_cast<uint32_t>(bytes), depth));
     }
 
-    MsgPack::object parse_object_impl(std::istream& is, uint32_t bytes, int depth) {
+    static MsgPack::object parse_object_impl(Input& is, uint32_t bytes, int depth) {
         MsgPack::object res;
+        if (!ensure_available(is, bytes)) {
+            return res;
+        }
 
         for(uint32_t i = 0; i < bytes; ++i) {
             MsgPack key = parse_msgpack(is, depth);
@@ -892,28 +1024,31 @@ namespace MsgPackParser {
     }
 
     template< typename T >
-    MsgPack parse_object(std::istream& is, uint8_t, int depth) {
+    static MsgPack parse_object(Input& is, uint8_t, int depth) {
         T bytes;
         read_bytes(is, bytes);
         return MsgPack(parse_object_impl(is, static_cast<uint32_t>(bytes), depth));
     }
 
-    MsgPack::binary parse_binary_impl(std::istream& is, uint32_t bytes) {
+    static MsgPack::binary parse_binary_impl(Input& is, uint32_t bytes) {
         MsgPack::binary ret;
+        if (!ensure_available(is, bytes)) {
+            return ret;
+        }
         ret.resize(bytes);
         is.read(reinterpret_cast<char*>(ret.data()), bytes);
         return ret;
     }
 
     template< typename T >
-    MsgPack parse_binary(std::istream& is, uint8_t, int) {
+    static MsgPack parse_binary(Input& is, uint8_t, int) {
         T bytes;
         read_bytes(is, bytes);
         return MsgPack(parse_binary_impl(is, static_cast<uint32_t>(bytes)));
     }
 
     template< typename T >
-    MsgPack parse_extension(std::istream& is, uint8_t, int) {
+    static MsgPack parse_extension(Input& is, uint8_t, int) {
         T bytes;
         read_bytes(is, bytes);
         uint8_t type;
@@ -922,30 +1057,30 @@ namespace MsgPackParser {
         return MsgPack(std::make_tuple(type, std::move(data)));
     }
 
-    MsgPack parse_pos_fixint(std::istream&, uint8_t first_byte, int) {
+    static MsgPack parse_pos_fixint(Input&, uint8_t first_byte, int) {
         return MsgPack( first_byte );
     }
 
-    MsgPack parse_fixobject(std::istream& is, uint8_t first_byte, int depth) {
+    static MsgPack parse_fixobject(Input& is, uint8_t first_byte, int depth) {
         uint32_t const bytes = first_byte & 0x0f;
         return MsgPack(parse_object_impl(is, bytes, depth));
     }
 
-    MsgPack parse_fixarray(std::istream& is, uint8_t first_byte, int depth) {
+    static MsgPack parse_fixarray(Input& is, uint8_t first_byte, int depth) {
         uint32_t const bytes = first_byte & 0x0f;
         return MsgPack(parse_array_impl(is, bytes, depth));
     }
 
-    MsgPack parse_fixstring(std::istream& is, uint8_t first_byte, int) {
+    static MsgPack parse_fixstring(Input& is, uint8_t first_byte, int) {
         uint32_t const bytes = first_byte & 0x1f;
         return MsgPack(parse_string_impl(is, bytes));
     }
 
-    MsgPack parse_neg_fixint(std::istream&, uint8_t first_byte, int) {
+    static MsgPack parse_neg_fixint(Input&, uint8_t first_byte, int) {
         return MsgPack(*reinterpret_cast<int8_t*>(&first_byte));
     }
 
-    MsgPack parse_fixext(std::istream& is, uint8_t first_byte, int) {
+    static MsgPack parse_fixext(Input& is, uint8_t first_byte, int) {
         uint8_t type;
         read_bytes(is, type);
         uint32_t const BYTES = 1 << (first_byte - 0xd4u);
@@ -957,9 +1092,9 @@ namespace MsgPackParser {
      *
      * Parse a JSON object.
      */
-    MsgPack parse_msgpack(std::istream& is, int depth) {
-        static const std::array< MsgPack(*)(std::istream&, uint8_t, int), 256 > parsers = [](){
-            using parser_template_element_type = std::tuple<uint8_t, MsgPack(*)(std::istream&,uint8_t,int)>;
+    static MsgPack parse_msgpack(Input& is, int depth) {
+        static const std::array< MsgPack(*)(Input&, uint8_t, int), 256 > parsers = [](){
+            using parser_template_element_type = std::tuple<uint8_t, MsgPack(*)(Input&,uint8_t,int)>;
             std::array< parser_template_element_type, 36 > const parser_template{{
                 parser_template_element_type{ 0x7fu, &MsgPackParser::parse_pos_fixint},
                 parser_template_element_type{ 0x8fu, &MsgPackParser::parse_fixobject},
@@ -995,7 +1130,7 @@ namespace MsgPackParser {
                 parser_template_element_type{ 0xffu, &MsgPackParser::parse_neg_fixint}
             }};
 
-            std::array< MsgPack(*)(std::istream&, uint8_t, int), 256 > parsers;
+            std::array< MsgPack(*)(Input&, uint8_t, int), 256 > parsers;
             int i = 0;
             std::for_each(std::begin(parser_template),
                          std::end(parser_template),
@@ -1031,47 +1166,64 @@ namespace MsgPackParser {
     }
 };
 
+template< typename Input >
+void assign_parse_error(const Input& is, std::string &err) {
+    if (is.eof()) {
+        err = "end of buffer.";
+    } else if (is.fail()) {
+        err = "format error.";
+    }
+}
+
 }//namespace {
 
 std::istream& operator>>(std::istream& is, MsgPack& msgpack) {
-    msgpack = MsgPackParser::parse_msgpack(is, 0);
+    msgpack = MsgPackParser<std::istream>::parse_msgpack(is, 0);
     return is;
 }
 
 MsgPack MsgPack::parse(std::istream& is) {
-    return MsgPackParser::parse_msgpack(is, 0);
+    return MsgPackParser<std::istream>::parse_msgpack(is, 0);
 }
 
 MsgPack MsgPack::parse(std::istream& is, std::string &err) {
     MsgPack ret = MsgPack::parse(is);
-    if (is.eof()) {
-        err = "end of buffer.";
-    } else if (is.fail()) {
-        err = "format error.";
-    }
+    assign_parse_error(is, err);
     return ret;
 }
 
 MsgPack MsgPack::parse(const std::string &in, string &err) {
-    std::stringstream ss(in);
-    return MsgPack::parse(ss, err);
+    return MsgPack::parse(in.data(), in.size(), err);
+}
+
+MsgPack MsgPack::parse(const char * in, size_t len, std::string & err) {
+    if (!in) {
+        err = "null input";
+        return nullptr;
+    }
+
+    BufferReader reader(in, len);
+    MsgPack ret = MsgPackParser<BufferReader>::parse_msgpack(reader, 0);
+    assign_parse_error(reader, err);
+    return ret;
 }
 
 // Documented in msgpack.hpp
 vector<MsgPack> MsgPack::parse_multi(const string &in,
                                      std::string::size_type &parser_stop_pos,
                                      string &err) {
-    std::stringstream ss(in);
-    
+    BufferReader reader(in.data(), in.size());
+
     vector<MsgPack> msgpack_vec;
-    while (static_cast<size_t>(ss.tellg()) != in.size() && !ss.eof() && !ss.fail()) {
-        auto next = MsgPack::parse(ss, err);
-        if (!ss.fail()) {
+    while (reader.offset() != in.size() && !reader.eof() && !reader.fail()) {
+        auto next = MsgPackParser<BufferReader>::parse_msgpack(reader, 0);
+        assign_parse_error(reader, err);
+        if (!reader.fail()) {
             msgpack_vec.emplace_back(std::move(next));
-            parser_stop_pos = ss.tellg();
+            parser_stop_pos = reader.offset();
         }
     }
-        
+
     return msgpack_vec;
 }
 
@@ -171,26 +171,19 @@ public:
     // Return a reference to obj[key] if this is an object, MsgPack() otherwise.
     const MsgPack & operator[](const std::string &key) const;
 
-    // Serialize.
-    void dump(std::string &out) const {
-        std::stringstream ss;
-        ss << *this;
-        out = ss.str();
-    }
-    
-    std::string dump() const {
-        std::stringstream ss;
-        ss << *this;
-        return ss.str();
-    }
-    
+    // Serialize. The size of the encoding is measured first, so the output
+    // is allocated once and written without going through a stream.
+    void dump(std::string &out) const;
+    std::string dump() const;
+
     friend std::ostream& operator<<(std::ostream& os, const MsgPack& msgpack);
     // Parse. If parse fails, set msgpack to MsgPack() and
     // sets failbit on stream.
     friend std::istream& operator>>(std::istream& is, MsgPack& msgpack);
 
     // Parse. If parse fails, return MsgPack() and assign
-    // an error message to err.
+    // an error message to err. Parses straight from the buffer without
+    // copying it into a stream.
     static MsgPack parse(const std::string & in, std::string & err);
     // Parse. If parse fails, return MsgPack(), sets failbit on stream and and
     // assign an error message to err.
@@ -198,14 +191,7 @@ public:
     // Parse (without the need to default initialise object first).
     // If parse fails, return MsgPack() and sets failbit on stream.
     static MsgPack parse(std::istream& is);
-    static MsgPack parse(const char * in, size_t len, std::string & err) {
-        if (in) {
-            return parse(std::string(in,in+len), err);
-        } else {
-            err = "null input";
-            return nullptr;
-        }
-    }
+    static MsgPack parse(const char * in, size_t len, std::string & err);
     // Parse multiple objects, concatenated or separated by whitespace
     static std::vector<MsgPack> parse_multi(
         const std::string & in,
@@ -235,6 +221,7 @@ public:
     bool has_shape(const shape & types, std::string & err) const;
 
 private:
+    friend class MsgPackValue;
     std::shared_ptr<MsgPackValue> m_ptr;
 };
 